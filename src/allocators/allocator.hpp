@@ -35,6 +35,7 @@
 
 #include "module.hpp"
 #include "config_utils.hpp"
+#include "checkpoint.hpp"
 
 class Allocator : public Module {
 protected:
@@ -81,6 +82,11 @@ public:
   virtual void PrintRequests( ostream * os = NULL ) const = 0;
   void PrintGrants( ostream * os = NULL ) const;
 
+  // Checkpoints: priority pointers that carry over from one cycle to the
+  // next; requests and grants are rebuilt every cycle
+  virtual void SaveState( CheckpointWriter & writer ) const { }
+  virtual void LoadState( CheckpointReader & reader ) { }
+
   static Allocator *NewAllocator( Module *parent, const string& name,
 				  const string &alloc_type, 
 				  int inputs, int outputs, 
@@ -179,3 +179,11 @@ void DORAllocator::_UpdateGrantPointers() {
     }
   }
 }
+
+void DORAllocator::SaveState(CheckpointWriter & writer) const {
+  writer.WriteInts(_gptrs);
+}
+
+void DORAllocator::LoadState(CheckpointReader & reader) {
+  _gptrs = reader.ReadInts();
+}
@@ -22,6 +22,9 @@ public:
   virtual ~DORAllocator() {}
   
   virtual void Allocate();
+
+  virtual void SaveState( CheckpointWriter & writer ) const;
+  virtual void LoadState( CheckpointReader & reader );
 };
 
 #endif
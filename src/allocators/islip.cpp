@@ -181,3 +181,15 @@ void iSLIP_Sparse::Allocate( )
   cout << endl;
 #endif
 }
+
+void iSLIP_Sparse::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInts( _gptrs );
+  writer.WriteInts( _aptrs );
+}
+
+void iSLIP_Sparse::LoadState( CheckpointReader & reader )
+{
+  _gptrs = reader.ReadInts( );
+  _aptrs = reader.ReadInts( );
+}
@@ -43,6 +43,9 @@ public:
 		int inputs, int outputs, int iters );
 
   void Allocate( );
+
+  void SaveState( CheckpointWriter & writer ) const;
+  void LoadState( CheckpointReader & reader );
 };
 
 #endif 
@@ -110,3 +110,15 @@ void LOA::Allocate( )
 }
 
 
+
+void LOA::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInts( _rptr );
+  writer.WriteInts( _gptr );
+}
+
+void LOA::LoadState( CheckpointReader & reader )
+{
+  _rptr = reader.ReadInts( );
+  _gptr = reader.ReadInts( );
+}
@@ -44,6 +44,9 @@ public:
        int inputs, int outputs );
 
   void Allocate( );
+
+  void SaveState( CheckpointWriter & writer ) const;
+  void LoadState( CheckpointReader & reader );
 };
 
 #endif
@@ -208,3 +208,13 @@ bool MaxSizeMatch::_ShortestAugmenting( )
 
   return true;
 }
+
+void MaxSizeMatch::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInt( _prio );
+}
+
+void MaxSizeMatch::LoadState( CheckpointReader & reader )
+{
+  _prio = reader.ReadInt( );
+}
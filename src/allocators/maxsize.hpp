@@ -46,6 +46,9 @@ public:
   ~MaxSizeMatch( );
   
   void Allocate( );
+
+  void SaveState( CheckpointWriter & writer ) const;
+  void LoadState( CheckpointReader & reader );
 };
 
 #endif 
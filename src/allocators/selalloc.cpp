@@ -252,3 +252,15 @@ void SelAlloc::PrintRequests( ostream * os ) const
   *os << "]." << endl;
 }
 
+
+void SelAlloc::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInts( _aptrs );
+  writer.WriteInts( _gptrs );
+}
+
+void SelAlloc::LoadState( CheckpointReader & reader )
+{
+  _aptrs = reader.ReadInts( );
+  _gptrs = reader.ReadInts( );
+}
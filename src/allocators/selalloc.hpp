@@ -50,6 +50,9 @@ public:
 
   virtual void PrintRequests( ostream * os = NULL ) const;
 
+  virtual void SaveState( CheckpointWriter & writer ) const;
+  virtual void LoadState( CheckpointReader & reader );
+
 };
 
 #endif 
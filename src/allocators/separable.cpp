@@ -84,3 +84,23 @@ void SeparableAllocator::Clear() {
   }
   SparseAllocator::Clear();
 }
+
+void SeparableAllocator::SaveState( CheckpointWriter & writer ) const
+{
+  for ( int i = 0; i < _inputs; ++i ) {
+    _input_arb[i]->SaveState( writer );
+  }
+  for ( int i = 0; i < _outputs; ++i ) {
+    _output_arb[i]->SaveState( writer );
+  }
+}
+
+void SeparableAllocator::LoadState( CheckpointReader & reader )
+{
+  for ( int i = 0; i < _inputs; ++i ) {
+    _input_arb[i]->LoadState( reader );
+  }
+  for ( int i = 0; i < _outputs; ++i ) {
+    _output_arb[i]->LoadState( reader );
+  }
+}
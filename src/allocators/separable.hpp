@@ -56,6 +56,9 @@ public:
 
   virtual void Clear() ;
 
+  virtual void SaveState( CheckpointWriter & writer ) const;
+  virtual void LoadState( CheckpointReader & reader );
+
 } ;
 
 #endif
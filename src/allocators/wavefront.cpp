@@ -109,3 +109,13 @@ void Wavefront::Allocate( )
 }
 
 
+
+void Wavefront::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInt( _pri );
+}
+
+void Wavefront::LoadState( CheckpointReader & reader )
+{
+  _pri = reader.ReadInt( );
+}
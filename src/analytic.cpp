@@ -0,0 +1,444 @@
+// $Id$
+
+/*analytic.cpp
+ *
+ * Analytic throughput and latency estimate (sim_type = analytic)
+ *
+ * Every packet of the configured traffic pattern is routed through the
+ * built network with the registered routing function, from the injection
+ * channel of its source to the ejection channel of its destination, and
+ * its flits are added to the load of every channel on the way. Where the
+ * routing function offers several output ports, each is taken with equal
+ * probability and the route is sampled analytic_route_samples times.
+ *
+ * The ideal saturation throughput is the injection rate at which the
+ * busiest channel is fully used. Below it, every channel is modelled as an
+ * M/D/1 queue served at one flit per cycle, and the latency estimate is
+ * the zero-load latency plus the mean waiting time along the path.
+ *
+ * Only the first traffic class and the first subnet are modelled.
+ *
+ */
+
+#include "booksim.hpp"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <cstdlib>
+#include <ctime>
+#include <sys/time.h>
+
+#include "analytic.hpp"
+#include "sweep.hpp"
+#include "network.hpp"
+#include "routefunc.hpp"
+#include "traffic.hpp"
+#include "random_utils.hpp"
+
+class _ChannelLoads {
+  Network * _net;
+  tRoutingFunction _rf;
+  int _nodes;
+  int _samples;
+  int _router_delay;
+  int _max_hops;
+  double _packet_flits;
+
+  vector<FlitChannel const *> _channels; // network, then injection, then ejection
+  vector<int> _output_base; // per router, into _output
+  vector<int> _output;      // channel of every router output
+  vector<int> _turn_base;   // per channel, into turns
+
+  Flit * _flit;
+  vector<int> _path;       // channels
+  vector<int> _path_turns; // turns into the channels, past the first
+  vector<OutputSet::sSetElement const *> _ports;
+
+  bool _Walk( int source, int dest, double * latency );
+
+public:
+  // flits per cycle at an injection rate of one packet per node and cycle
+  vector<double> load;
+  // flits per cycle into a network or ejection channel from each input
+  // of the router driving it
+  vector<double> turns;
+  vector<int> turn_channel;
+  double packets;      // per cycle, at the same rate
+  double hops;         // network channels per packet
+  double zero_load;    // latency per packet at zero load, without serialization
+
+  _ChannelLoads( Configuration const & config, Network * net, tRoutingFunction rf,
+                 double packet_flits );
+  ~_ChannelLoads( );
+
+  void AddTraffic( int source, int dest, double packets );
+  int Channels( ) const { return _channels.size( ); }
+  FlitChannel const * Channel( int c ) const { return _channels[c]; }
+};
+
+_ChannelLoads::_ChannelLoads( Configuration const & config, Network * net,
+                              tRoutingFunction rf, double packet_flits )
+  : _net( net ), _rf( rf ), packets( 0.0 ), hops( 0.0 ), zero_load( 0.0 )
+{
+  _nodes = net->NumNodes( );
+  _samples = config.GetInt( "analytic_route_samples" );
+  if ( _samples < 1 ) {
+    cerr << "Error: analytic_route_samples must be positive." << endl;
+    exit(-1);
+  }
+  _router_delay = config.GetInt( "routing_delay" ) + config.GetInt( "vc_alloc_delay" ) +
+    config.GetInt( "sw_alloc_delay" ) + config.GetInt( "st_prepare_delay" ) +
+    config.GetInt( "st_final_delay" );
+  // routes that visit every router more than twice do not terminate
+  _max_hops = 2 * net->NumRouters( ) + 2;
+
+  vector<FlitChannel *> const & chan = net->GetChannels( );
+  vector<FlitChannel *> const & inject = net->GetInject( );
+  vector<FlitChannel *> const & eject = net->GetEject( );
+  _channels.insert( _channels.end( ), chan.begin( ), chan.end( ) );
+  _channels.insert( _channels.end( ), inject.begin( ), inject.end( ) );
+  _channels.insert( _channels.end( ), eject.begin( ), eject.end( ) );
+  map<FlitChannel const *, int> index;
+  for ( size_t c = 0; c < _channels.size( ); ++c ) {
+    index[_channels[c]] = c;
+  }
+  load.assign( _channels.size( ), 0.0 );
+
+  vector<Router *> const & routers = net->GetRouters( );
+  _turn_base.assign( _channels.size( ), -1 );
+  for ( size_t r = 0; r < routers.size( ); ++r ) {
+    _output_base.push_back( _output.size( ) );
+    for ( int port = 0; port < routers[r]->NumOutputs( ); ++port ) {
+      int const c = index[routers[r]->GetOutputChannel( port )];
+      _output.push_back( c );
+      _turn_base[c] = turns.size( );
+      turns.resize( turns.size( ) + routers[r]->NumInputs( ), 0.0 );
+      turn_channel.resize( turns.size( ), c );
+    }
+  }
+  _packet_flits = packet_flits;
+
+  _flit = Flit::New( );
+}
+
+_ChannelLoads::~_ChannelLoads( )
+{
+  _flit->Free( );
+}
+
+// one route from source to dest into _path; false if it always takes the
+// same ports
+bool _ChannelLoads::_Walk( int source, int dest, double * latency )
+{
+  Flit * const f = _flit;
+  f->Reset( );
+  f->id = f->pid = source * _nodes + dest;
+  f->src = source;
+  f->dest = dest;
+  f->cl = 0;
+  f->head = true;
+  f->tail = true;
+  f->subnetwork = 0;
+
+  OutputSet route_set;
+  _rf( NULL, f, -1, &route_set, true );
+  f->vc = route_set.begin( )->vc_start;
+
+  _path.clear( );
+  _path_turns.clear( );
+  bool branched = false;
+  FlitChannel const * channel = _net->GetInject( source );
+  _path.push_back( _channels.size( ) - 2 * _nodes + source );
+  *latency = 0.0;
+  for ( ; ; ) {
+    *latency += channel->GetLatency( );
+    Router const * const router = channel->GetSink( );
+    if ( !router ) {
+      break;
+    }
+    if ( (int)_path.size( ) > _max_hops ) {
+      cerr << "Error: The route from node " << source << " to node " << dest
+           << " does not reach its destination." << endl;
+      exit(-1);
+    }
+    *latency += _router_delay;
+
+    _rf( router, f, channel->GetSinkPort( ), &route_set, false );
+    // distinct output ports; lanes and adaptive choices are equally likely
+    vector<OutputSet::sSetElement const *> & ports = _ports;
+    ports.clear( );
+    for ( OutputSet::const_iterator iter = route_set.begin( ); iter != route_set.end( ); ++iter ) {
+      bool seen = false;
+      for ( size_t i = 0; i < ports.size( ); ++i ) {
+        seen = seen || ( ports[i]->output_port == iter->output_port );
+      }
+      if ( !seen ) {
+        ports.push_back( iter );
+      }
+    }
+    if ( ports.empty( ) ) {
+      cerr << "Error: No route from node " << source << " to node " << dest
+           << " at " << router->FullName( ) << "." << endl;
+      exit(-1);
+    }
+    OutputSet::sSetElement const * const out =
+      ports[( ports.size( ) > 1 ) ? RandomInt( ports.size( ) - 1 ) : 0];
+    branched = branched || ( ports.size( ) > 1 );
+    f->vc = out->vc_start;
+    ++f->hops;
+    int const c = _output[_output_base[router->GetID( )] + out->output_port];
+    _path.push_back( c );
+    _path_turns.push_back( _turn_base[c] + channel->GetSinkPort( ) );
+    channel = _channels[c];
+  }
+  if ( channel != _net->GetEject( dest ) ) {
+    cerr << "Error: The packet from node " << source << " to node " << dest
+         << " was ejected at the wrong node." << endl;
+    exit(-1);
+  }
+  return branched;
+}
+
+void _ChannelLoads::AddTraffic( int source, int dest, double rate )
+{
+  double latency;
+  int const samples = _Walk( source, dest, &latency ) ? _samples : 1;
+  double const weight = rate / samples;
+  for ( int s = 0; s < samples; ++s ) {
+    if ( s > 0 ) {
+      _Walk( source, dest, &latency );
+    }
+    for ( size_t i = 0; i < _path.size( ); ++i ) {
+      load[_path[i]] += weight * _packet_flits;
+    }
+    for ( size_t i = 0; i < _path_turns.size( ); ++i ) {
+      turns[_path_turns[i]] += weight * _packet_flits;
+    }
+    packets += weight;
+    hops += weight * ( _path.size( ) - 2 );
+    zero_load += weight * latency;
+  }
+}
+
+bool AnalyticEnabled( Configuration const & config )
+{
+  return config.GetStr( "sim_type" ) == "analytic";
+}
+
+bool RunAnalytic( BookSimConfig & config )
+{
+  struct timeval start_time, end_time;
+  gettimeofday( &start_time, NULL );
+
+  string const rf_name = config.GetStr( "routing_function" ) + "_" +
+    config.GetStr( "topology" );
+  map<string, tRoutingFunction>::const_iterator const rf_iter =
+    gRoutingFunctionMap.find( rf_name );
+  if ( rf_iter == gRoutingFunctionMap.end( ) ) {
+    cerr << "Error: Invalid routing function: " << rf_name << endl;
+    exit(-1);
+  }
+
+  // average packet size of the first class
+  vector<int> sizes;
+  string const packet_size_str = config.GetStr( "packet_size" );
+  if ( packet_size_str.empty( ) ) {
+    sizes.push_back( config.GetInt( "packet_size" ) );
+  } else {
+    sizes = tokenize_int( tokenize_str( packet_size_str )[0] );
+  }
+  vector<int> size_rates( sizes.size( ), 1 );
+  string const size_rate_str = config.GetStr( "packet_size_rate" );
+  if ( !size_rate_str.empty( ) ) {
+    size_rates = tokenize_int( tokenize_str( size_rate_str )[0] );
+    size_rates.resize( sizes.size( ), size_rates.back( ) );
+  }
+  double packet_flits = 0.0;
+  double size_weight = 0.0;
+  for ( size_t i = 0; i < sizes.size( ); ++i ) {
+    packet_flits += sizes[i] * size_rates[i];
+    size_weight += size_rates[i];
+  }
+  packet_flits /= size_weight;
+
+  // injection rates are in packets unless injection_rate_uses_flits is set
+  double const rate_scale = config.GetInt( "injection_rate_uses_flits" ) ?
+    1.0 / packet_flits : 1.0;
+
+  Network * const net = Network::New( config, "network_0" );
+  int const nodes = net->NumNodes( );
+
+  if ( config.GetStr( "seed" ) == "time" ) {
+    RandomSeed( int( time( NULL ) ) );
+  } else {
+    RandomSeed( config.GetInt( "seed" ) );
+  }
+
+  _ChannelLoads model( config, net, rf_iter->second, packet_flits );
+  string const traffic = config.GetStrArray( "traffic" )[0];
+  TrafficPattern * const pattern = TrafficPattern::New( traffic, nodes, &config );
+  if ( dynamic_cast<UniformRandomTrafficPattern *>( pattern ) ) {
+    // exact: every node, including the source, is equally likely
+    for ( int source = 0; source < nodes; ++source ) {
+      for ( int dest = 0; dest < nodes; ++dest ) {
+        model.AddTraffic( source, dest, 1.0 / nodes );
+      }
+    }
+  } else {
+    // permutations have a single destination per source, other random
+    // patterns are sampled
+    bool const fixed = dynamic_cast<PermutationTrafficPattern *>( pattern ) ||
+      dynamic_cast<RandomPermutationTrafficPattern *>( pattern );
+    int const samples = fixed ? 1 : config.GetInt( "analytic_samples" );
+    if ( samples < 1 ) {
+      cerr << "Error: analytic_samples must be positive." << endl;
+      exit(-1);
+    }
+    for ( int source = 0; source < nodes; ++source ) {
+      for ( int s = 0; s < samples; ++s ) {
+        int const dest = pattern->dest( source );
+        if ( dest >= 0 ) {
+          model.AddTraffic( source, dest, 1.0 / samples );
+        }
+      }
+    }
+  }
+  delete pattern;
+
+  int const channels = model.Channels( );
+  int bottleneck = 0;
+  for ( int c = 1; c < channels; ++c ) {
+    if ( model.load[c] > model.load[bottleneck] ) {
+      bottleneck = c;
+    }
+  }
+  double const saturation = ( model.load[bottleneck] > 0.0 ) ?
+    1.0 / ( model.load[bottleneck] * rate_scale ) : 0.0;
+  double const avg_hops = model.hops / model.packets;
+  // the tail flit leaves packet_flits - 1 cycles after the head
+  double const zero_load = model.zero_load / model.packets + packet_flits - 1.0;
+
+  // injection rates: those of sweep_injection_rate, or fractions of the
+  // saturation throughput
+  vector<double> rates;
+  string const rate_str = config.GetStr( "sweep_injection_rate" );
+  if ( !rate_str.empty( ) ) {
+    rates = ExpandSweepRange( rate_str );
+  } else {
+    for ( int i = 1; i <= 19; ++i ) {
+      rates.push_back( saturation * i / 20.0 );
+    }
+  }
+
+  // M/D/1: the mean wait for a channel used a fraction rho of the time by
+  // packets of packet_flits flits is rho * packet_flits / ( 2 * ( 1 - rho ) ).
+  // Past the injection channel, packets arriving from the same channel were
+  // already spaced out by it: their share of rho counts half towards the
+  // wait (all of it overestimates the latency of multi-flit packets by about
+  // 2x, none of it underestimates it by as much).
+  int const network_channels = net->GetChannels( ).size( );
+  vector<double> latency( rates.size( ) );
+  for ( size_t r = 0; r < rates.size( ); ++r ) {
+    double const rate = rates[r] * rate_scale;
+    double flits_wait = 0.0; // flits times their wait
+    bool stable = true;
+    for ( int c = 0; c < channels; ++c ) {
+      double const rho = rate * model.load[c];
+      stable = stable && ( rho < 1.0 );
+      if ( stable && ( c >= network_channels ) && ( c < network_channels + nodes ) ) {
+        flits_wait += model.load[c] * rho * packet_flits / ( 2.0 * ( 1.0 - rho ) );
+      }
+    }
+    for ( size_t t = 0; stable && ( t < model.turns.size( ) ); ++t ) {
+      int const c = model.turn_channel[t];
+      double const rho = rate * model.load[c];
+      double const other = rate * ( model.load[c] - 0.5 * model.turns[t] );
+      flits_wait += model.turns[t] * other * packet_flits / ( 2.0 * ( 1.0 - rho ) );
+    }
+    latency[r] = stable ?
+      zero_load + flits_wait / ( packet_flits * model.packets ) : -1.0;
+  }
+
+  gettimeofday( &end_time, NULL );
+  double const ms = ( end_time.tv_sec - start_time.tv_sec ) * 1000.0 +
+    ( end_time.tv_usec - start_time.tv_usec ) / 1000.0;
+
+  cout << "Analytic model: " << rf_name << ", traffic " << traffic << " ("
+       << ms << " ms)" << endl
+       << "Ideal saturation throughput = " << saturation << endl
+       << "Bottleneck channel ";
+  if ( bottleneck < network_channels ) {
+    net->WriteChannelKeyHeader( cout );
+    cout << " = ";
+    net->WriteChannelKey( cout, bottleneck );
+  } else if ( bottleneck < network_channels + nodes ) {
+    cout << "= injection of node " << bottleneck - network_channels;
+  } else {
+    cout << "= ejection of node " << bottleneck - network_channels - nodes;
+  }
+  cout << " (" << model.load[bottleneck] * rate_scale
+       << " flits per cycle at injection rate 1)" << endl
+       << "Average hops = " << avg_hops << endl
+       << "Zero-load latency = " << zero_load << endl;
+  for ( size_t r = 0; r < rates.size( ); ++r ) {
+    cout << "  rate " << rates[r] << ": latency ";
+    if ( latency[r] >= 0.0 ) {
+      cout << latency[r] << endl;
+    } else {
+      cout << "inf" << endl;
+    }
+  }
+
+  // in the format of the sweep CSV
+  string const out_file = config.GetStr( "analytic_output_file" );
+  if ( !out_file.empty( ) ) {
+    ofstream out( out_file.c_str( ) );
+    if ( !out ) {
+      cerr << "Error: Could not open analytic_output_file " << out_file << endl;
+      exit(-1);
+    }
+    ostringstream size_str;
+    vector<int> const dim_sizes = config.GetIntArray( "dim_sizes" );
+    for ( size_t d = 0; d < dim_sizes.size( ); ++d ) {
+      size_str << ( d ? "," : "" ) << dim_sizes[d];
+    }
+    out << "Traffic,InjectionRate,Size,VCs,VerticalTopology,AvgLatency,Throughput,"
+        << "LatencyCI,ThroughputCI" << endl;
+    for ( size_t r = 0; r < rates.size( ); ++r ) {
+      out << traffic << ',' << rates[r] << ",\"" << size_str.str( ) << "\","
+          << config.GetInt( "num_vcs" ) << ',' << config.GetStr( "vertical_topology" )
+          << ',';
+      if ( latency[r] >= 0.0 ) {
+        out << latency[r] << ',' << rates[r] << ",," << endl;
+      } else {
+        out << "inf,0,," << endl;
+      }
+    }
+  }
+
+  // load of every network channel, keyed as in channel_stats_out
+  string const channel_file = config.GetStr( "analytic_channel_out" );
+  if ( !channel_file.empty( ) ) {
+    ofstream out( channel_file.c_str( ) );
+    if ( !out ) {
+      cerr << "Error: Could not open analytic_channel_out " << channel_file << endl;
+      exit(-1);
+    }
+    net->WriteChannelKeyHeader( out );
+    out << ",load,utilization" << endl;
+    // relative to the bottleneck; no channel is used if it carries nothing
+    double const max_load = model.load[bottleneck];
+    for ( int c = 0; c < network_channels; ++c ) {
+      net->WriteChannelKey( out, c );
+      out << ',' << model.load[c] * rate_scale << ','
+          << ( ( max_load > 0.0 ) ? model.load[c] / max_load : 0.0 ) << endl;
+    }
+  }
+
+  delete net;
+  return true;
+}
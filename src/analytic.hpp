@@ -0,0 +1,14 @@
+// $Id$
+
+#ifndef _ANALYTIC_HPP_
+#define _ANALYTIC_HPP_
+
+#include "booksim_config.hpp"
+
+// sim_type = analytic: ideal saturation throughput and M/D/1 latency
+// estimates from the channel loads of the configured routing function and
+// traffic pattern, without simulating
+bool AnalyticEnabled( Configuration const & config );
+bool RunAnalytic( BookSimConfig & config );
+
+#endif
@@ -37,6 +37,7 @@
 #include <vector>
 
 #include "module.hpp"
+#include "checkpoint.hpp"
 
 class Arbiter : public Module {
 
@@ -75,6 +76,10 @@ public:
 
   virtual void Clear();
 
+  // Checkpoints: priority state that carries over from one cycle to the next
+  virtual void SaveState( CheckpointWriter & writer ) const { }
+  virtual void LoadState( CheckpointReader & reader ) { }
+
   inline int LastWinner() const {
     return _selected;
   }
@@ -119,3 +119,17 @@ void MatrixArbiter::Clear()
   _last_req = -1;
   Arbiter::Clear();
 }
+
+void MatrixArbiter::SaveState( CheckpointWriter & writer ) const
+{
+  for ( int i = 0; i < _size; ++i ) {
+    writer.WriteInts( _matrix[i] );
+  }
+}
+
+void MatrixArbiter::LoadState( CheckpointReader & reader )
+{
+  for ( int i = 0; i < _size; ++i ) {
+    _matrix[i] = reader.ReadInts( );
+  }
+}
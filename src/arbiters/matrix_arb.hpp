@@ -66,6 +66,9 @@ public:
 
   virtual void Clear();
 
+  virtual void SaveState( CheckpointWriter & writer ) const;
+  virtual void LoadState( CheckpointReader & reader );
+
 } ;
 
 #endif
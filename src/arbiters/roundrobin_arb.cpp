@@ -78,3 +78,13 @@ void RoundRobinArbiter::Clear()
   _best_input = -1;
   Arbiter::Clear();
 }
+
+void RoundRobinArbiter::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInt( _pointer );
+}
+
+void RoundRobinArbiter::LoadState( CheckpointReader & reader )
+{
+  _pointer = reader.ReadInt( );
+}
@@ -117,3 +117,19 @@ void TreeArbiter::Clear()
   _global_arbiter->Clear();
   Arbiter::Clear();
 }
+
+void TreeArbiter::SaveState( CheckpointWriter & writer ) const
+{
+  for ( size_t i = 0; i < _group_arbiters.size( ); ++i ) {
+    _group_arbiters[i]->SaveState( writer );
+  }
+  _global_arbiter->SaveState( writer );
+}
+
+void TreeArbiter::LoadState( CheckpointReader & reader )
+{
+  for ( size_t i = 0; i < _group_arbiters.size( ); ++i ) {
+    _group_arbiters[i]->LoadState( reader );
+  }
+  _global_arbiter->LoadState( reader );
+}
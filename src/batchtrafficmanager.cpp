@@ -42,6 +42,13 @@ BatchTrafficManager::BatchTrafficManager( const Configuration &config,
 
   _max_outstanding = config.GetInt ("max_outstanding_requests");  
 
+  // packets are issued by _IssuePacket, not by the injection process
+  _inject_skip_ahead = false;
+
+  if(!_checkpoint_save.empty() || !_checkpoint_load.empty()) {
+    Error("Checkpoints are not supported for batch simulations.");
+  }
+
   _batch_size = config.GetInt( "batch_size" );
   _batch_count = config.GetInt( "batch_count" );
 
@@ -143,7 +150,7 @@ bool BatchTrafficManager::_SingleSim( )
     
     bool packets_left = false;
     for(int c = 0; c < _classes; ++c) {
-      packets_left |= !_total_in_flight_flits[c].empty();
+      packets_left |= !_total_in_flight_flits[c].Empty();
     }
     
     while( packets_left ) { 
@@ -158,7 +165,7 @@ bool BatchTrafficManager::_SingleSim( )
       
       packets_left = false;
       for(int c = 0; c < _classes; ++c) {
-	packets_left |= !_total_in_flight_flits[c].empty();
+	packets_left |= !_total_in_flight_flits[c].Empty();
       }
     }
     cout << endl;
@@ -0,0 +1,287 @@
+// $Id$
+
+/*buffer_bench.cpp
+ *
+ *Microbenchmark of network cycles per second with the structure-of-arrays
+ *Buffer against the buffer with one VC module per virtual channel that it
+ *replaced
+ *
+ *In a cycle every router does what IQRouter does with its input buffers:
+ *every input receives a flit of its current packet, the VCs holding a head
+ *flit move from idle through routing and vc_alloc to active, and switch
+ *allocation scans the active VCs of every input for the highest priority
+ *and sends its front flit. The default of 192 routers with 6 inputs is an
+ *8x8x3 UniTorus, so the buffers do not fit in the cache as they do not in
+ *a simulation. Both buffers see the same sequence of flits. Build with
+ *"make bench" and run
+ *
+ *  bench/buffer_bench [routers] [cycles]
+ *
+ */
+
+#include <sys/time.h>
+
+#include <deque>
+#include <vector>
+#include <cstdlib>
+#include <sstream>
+#include <iostream>
+
+#include "booksim.hpp"
+#include "booksim_config.hpp"
+#include "buffer.hpp"
+
+// normally provided by main.cpp
+int GetSimTime( ) { return 0; }
+thread_local ostream * gWatchOut = NULL;
+
+static double _Now( )
+{
+  struct timeval t;
+  gettimeofday( &t, NULL );
+  return (double)t.tv_sec + (double)t.tv_usec / 1000000.0;
+}
+
+// xorshift, so both buffers see the same sequence of flits
+static unsigned _Next( unsigned & state )
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// the previous VC, reduced to what a router cycle uses
+class ModuleVC : public Module {
+  deque<Flit *> _buffer;
+  VC::eVCState _state;
+  OutputSet *_route_set;
+  int _out_port, _out_vc;
+  int _pri;
+  string _priority;
+  int _expected_pid;
+public:
+  ModuleVC( const Configuration& config, Module *parent, const string& name )
+    : Module( parent, name ), _state( VC::idle ), _out_port( -1 ),
+      _out_vc( -1 ), _pri( 0 ), _expected_pid( -1 )
+  {
+    _route_set = config.GetInt( "routing_delay" ) ? new OutputSet( ) : NULL;
+    _priority = config.GetStr( "priority" );
+  }
+  ~ModuleVC( ) { delete _route_set; }
+  void AddFlit( Flit *f ) {
+    if ( _expected_pid >= 0 ) {
+      if ( f->pid != _expected_pid ) {
+        Error( "Received flit with unexpected packet ID" );
+      } else if ( f->tail ) {
+        _expected_pid = -1;
+      }
+    } else if ( !f->tail ) {
+      _expected_pid = f->pid;
+    }
+    _buffer.push_back( f );
+    _UpdatePriority( );
+  }
+  Flit *RemoveFlit( ) {
+    Flit *f = _buffer.front( );
+    _buffer.pop_front( );
+    _UpdatePriority( );
+    return f;
+  }
+  void _UpdatePriority( ) {
+    if ( _buffer.empty( ) || ( _priority == "none" ) ) return;
+    _pri = ( _priority == "queue_length" ) ? (int)_buffer.size( ) : _buffer.front( )->pri;
+  }
+  Flit *FrontFlit( ) const { return _buffer.empty( ) ? NULL : _buffer.front( ); }
+  bool Empty( ) const { return _buffer.empty( ); }
+  VC::eVCState GetState( ) const { return _state; }
+  void SetState( VC::eVCState s ) { _state = s; }
+  void SetOutput( int port, int vc ) { _out_port = port; _out_vc = vc; }
+  int GetOutputPort( ) const { return _out_port; }
+  int GetOutputVC( ) const { return _out_vc; }
+  int GetPriority( ) const { return _pri; }
+  int GetOccupancy( ) const { return (int)_buffer.size( ); }
+};
+
+// the previous Buffer: one heap-allocated ModuleVC per VC
+class ModuleBuffer : public Module {
+  vector<ModuleVC *> _vc;
+public:
+  ModuleBuffer( const Configuration& config, int outputs,
+                Module *parent, const string& name )
+    : Module( parent, name )
+  {
+    int const vcs = config.GetInt( "num_vcs" );
+    for ( int i = 0; i < vcs; ++i ) {
+      ostringstream vc_name;
+      vc_name << "vc_" << i;
+      _vc.push_back( new ModuleVC( config, this, vc_name.str( ) ) );
+    }
+  }
+  ~ModuleBuffer( ) {
+    for ( size_t i = 0; i < _vc.size( ); ++i ) {
+      delete _vc[i];
+    }
+  }
+  void AddFlit( int vc, Flit *f ) { _vc[vc]->AddFlit( f ); }
+  Flit *RemoveFlit( int vc ) { return _vc[vc]->RemoveFlit( ); }
+  Flit *FrontFlit( int vc ) const { return _vc[vc]->FrontFlit( ); }
+  bool Empty( int vc ) const { return _vc[vc]->Empty( ); }
+  VC::eVCState GetState( int vc ) const { return _vc[vc]->GetState( ); }
+  void SetState( int vc, VC::eVCState s ) { _vc[vc]->SetState( s ); }
+  void SetOutput( int vc, int port, int out_vc ) { _vc[vc]->SetOutput( port, out_vc ); }
+  int GetOutputPort( int vc ) const { return _vc[vc]->GetOutputPort( ); }
+  int GetOutputVC( int vc ) const { return _vc[vc]->GetOutputVC( ); }
+  int GetPriority( int vc ) const { return _vc[vc]->GetPriority( ); }
+  int GetOccupancy( int vc ) const { return _vc[vc]->GetOccupancy( ); }
+};
+
+// packet being received by one input
+struct Arrival {
+  int pid;
+  int vc;
+  int left;
+};
+
+// network cycles per second over routers * ports inputs; flits is the
+// free list
+template<class Buf>
+static double _Run( Configuration const & config, int routers, int ports,
+                    vector<Flit *> flits, long cycles, long * checksum )
+{
+  int const inputs = routers * ports;
+  int const vcs = config.GetInt( "num_vcs" );
+  int const vc_buf_size = config.GetInt( "vc_buf_size" );
+  int const packet_size = 4;
+
+  vector<Buf *> buffers;
+  for ( int i = 0; i < inputs; ++i ) {
+    ostringstream name;
+    name << "buf_" << i;
+    buffers.push_back( new Buf( config, ports, NULL, name.str( ) ) );
+  }
+  vector<Arrival> arrival( inputs );
+  for ( int i = 0; i < inputs; ++i ) {
+    arrival[i].pid = -1;
+    arrival[i].vc = -1;
+    arrival[i].left = 0;
+  }
+  unsigned state = 12345;
+  int next_pid = 0;
+
+  double const start = _Now( );
+  for ( long c = 0; c < cycles; ++c ) {
+    for ( int i = 0; i < inputs; ++i ) {
+      Buf * const buf = buffers[i];
+
+      // receive the next flit of the current packet, if there is room
+      Arrival & a = arrival[i];
+      if ( !a.left ) {
+        a.pid = next_pid++;
+        a.vc = _Next( state ) % vcs;
+        a.left = packet_size;
+      }
+      if ( buf->GetOccupancy( a.vc ) < vc_buf_size ) {
+        Flit * const f = flits.back( );
+        flits.pop_back( );
+        f->pid = a.pid;
+        f->head = ( a.left == packet_size );
+        f->tail = ( a.left == 1 );
+        f->pri = _Next( state ) % 4;
+        buf->AddFlit( a.vc, f );
+        --a.left;
+      }
+
+      // route and VC allocation of waiting head flits
+      for ( int vc = 0; vc < vcs; ++vc ) {
+        if ( buf->Empty( vc ) ) continue;
+        switch ( buf->GetState( vc ) ) {
+        case VC::idle:
+          buf->SetState( vc, VC::routing );
+          break;
+        case VC::routing:
+          buf->SetState( vc, VC::vc_alloc );
+          break;
+        case VC::vc_alloc:
+          buf->SetOutput( vc, buf->FrontFlit( vc )->pid % ports, vc );
+          buf->SetState( vc, VC::active );
+          break;
+        default:
+          break;
+        }
+      }
+
+      // switch allocation: send the front flit of the best active VC
+      int best = -1;
+      int best_pri = -1;
+      for ( int vc = 0; vc < vcs; ++vc ) {
+        if ( buf->Empty( vc ) || ( buf->GetState( vc ) != VC::active ) ) continue;
+        int const pri = buf->GetPriority( vc );
+        if ( pri > best_pri ) {
+          best = vc;
+          best_pri = pri;
+        }
+      }
+      if ( best >= 0 ) {
+        *checksum += buf->GetOutputPort( best ) + buf->GetOutputVC( best );
+        Flit * const f = buf->RemoveFlit( best );
+        *checksum += f->pid;
+        flits.push_back( f );
+        if ( f->tail ) {
+          buf->SetState( best, VC::idle );
+        }
+      }
+    }
+  }
+  double const elapsed = _Now( ) - start;
+
+  for ( int i = 0; i < inputs; ++i ) {
+    delete buffers[i];
+  }
+  return (double)cycles / elapsed;
+}
+
+int main( int argc, char * argv[] )
+{
+  int const routers = ( argc > 1 ) ? atoi( argv[1] ) : 192;
+  long const cycles = ( argc > 2 ) ? atol( argv[2] ) : 5000;
+  if ( ( routers <= 0 ) || ( cycles <= 0 ) ) {
+    cerr << "Usage: " << argv[0] << " [routers] [cycles]" << endl;
+    return 1;
+  }
+
+  // inputs of a UniTorus router (x, y, three elevator lanes and injection)
+  int const ports = 6;
+  int const vc_counts[] = { 4, 8, 16 };
+
+  // enough flits that every VC of every input can be full
+  BookSimConfig const defaults;
+  int const vc_buf_size = defaults.GetInt( "vc_buf_size" );
+  vector<Flit *> flits;
+  for ( int i = 0; i < routers * ports * 16 * vc_buf_size; ++i ) {
+    flits.push_back( Flit::New( ) );
+    flits.back( )->id = i;
+  }
+
+  cout << cycles << " cycles of " << routers << " routers with " << ports
+       << " inputs per case, cycles/s" << endl;
+  for ( size_t c = 0; c < sizeof( vc_counts ) / sizeof( vc_counts[0] ); ++c ) {
+    BookSimConfig config;
+    config.Assign( "num_vcs", vc_counts[c] );
+    long module_sum = 0;
+    long soa_sum = 0;
+    double const module_rate = _Run<ModuleBuffer>( config, routers, ports, flits,
+                                                   cycles, &module_sum );
+    double const soa_rate = _Run<Buffer>( config, routers, ports, flits,
+                                          cycles, &soa_sum );
+    if ( module_sum != soa_sum ) {
+      cerr << "Error: the buffers disagree" << endl;
+      return 1;
+    }
+    cout << "  " << vc_counts[c] << " VCs" << ( vc_counts[c] < 10 ? " " : "" )
+         << " VC modules " << module_rate
+         << ", Buffer " << soa_rate
+         << " (" << soa_rate / module_rate << "x)" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+// $Id$
+
+/*flit_table_bench.cpp
+ *
+ *Microbenchmark of FlitTable against the std::map it replaced in
+ *TrafficManager (in-flight flits by flit ID)
+ *
+ *A fixed number of flits is kept in flight; every step looks up a random
+ *one, retires it and inserts the next ID, as flits are ejected and
+ *injected in a running simulation. Build with "make bench" and run
+ *
+ *  bench/flit_table_bench [in_flight] [steps]
+ *
+ */
+
+#include <sys/time.h>
+
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+#include "booksim.hpp"
+#include "flit_table.hpp"
+
+static double _Now( )
+{
+  struct timeval t;
+  gettimeofday( &t, NULL );
+  return (double)t.tv_sec + (double)t.tv_usec / 1000000.0;
+}
+
+// xorshift, so both tables see the same sequence of keys
+static unsigned _Next( unsigned & state )
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// keys[i] is the ID of the flit in slot i; returns ns per step
+template<class Table>
+static double _Run( Table & table, vector<Flit *> const & flits, int in_flight,
+                    long steps, long * checksum )
+{
+  vector<int> keys( in_flight );
+  for ( int i = 0; i < in_flight; ++i ) {
+    keys[i] = i;
+    table.Insert( i, flits[i] );
+  }
+  int next_id = in_flight;
+  unsigned state = 12345;
+
+  double const start = _Now( );
+  for ( long s = 0; s < steps; ++s ) {
+    int const slot = _Next( state ) % in_flight;
+    Flit * const f = table.Find( keys[slot] );
+    *checksum += f->id;
+    table.Erase( keys[slot] );
+    keys[slot] = next_id++;
+    table.Insert( keys[slot], f );
+  }
+  double const elapsed = _Now( ) - start;
+
+  for ( int i = 0; i < in_flight; ++i ) {
+    table.Erase( keys[i] );
+  }
+  return elapsed * 1e9 / (double)steps;
+}
+
+// the interface of FlitTable over the map TrafficManager used before
+class MapTable {
+  map<int, Flit *> _flits;
+public:
+  inline Flit * Find( int key ) const {
+    map<int, Flit *>::const_iterator iter = _flits.find( key );
+    return ( iter == _flits.end( ) ) ? 0 : iter->second;
+  }
+  inline void Insert( int key, Flit * f ) { _flits.insert( make_pair( key, f ) ); }
+  inline void Erase( int key ) { _flits.erase( key ); }
+};
+
+int main( int argc, char * argv[] )
+{
+  int const in_flight = ( argc > 1 ) ? atoi( argv[1] ) : 4096;
+  long const steps = ( argc > 2 ) ? atol( argv[2] ) : 20000000;
+  if ( ( in_flight <= 0 ) || ( steps <= 0 ) ) {
+    cerr << "Usage: " << argv[0] << " [in_flight] [steps]" << endl;
+    return 1;
+  }
+
+  vector<Flit *> flits( in_flight );
+  for ( int i = 0; i < in_flight; ++i ) {
+    flits[i] = Flit::New( );
+    flits[i]->id = i;
+  }
+  long map_sum = 0;
+  long table_sum = 0;
+
+  MapTable map_table;
+  double const map_ns = _Run( map_table, flits, in_flight, steps, &map_sum );
+  FlitTable flit_table;
+  double const table_ns = _Run( flit_table, flits, in_flight, steps, &table_sum );
+
+  for ( int i = 0; i < in_flight; ++i ) {
+    flits[i]->Free( );
+  }
+
+  if ( map_sum != table_sum ) {
+    cerr << "Error: the tables disagree" << endl;
+    return 1;
+  }
+
+  cout << in_flight << " flits in flight, " << steps << " steps" << endl;
+  cout << "  std::map   " << map_ns << " ns per find+erase+insert" << endl;
+  cout << "  FlitTable  " << table_ns << " ns per find+erase+insert" << endl;
+  cout << "  speedup    " << map_ns / table_ns << "x" << endl;
+  return 0;
+}
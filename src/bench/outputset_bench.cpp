@@ -0,0 +1,150 @@
+// $Id$
+
+/*outputset_bench.cpp
+ *
+ *Microbenchmark of route computations per second with OutputSet against
+ *the std::set based version it replaced
+ *
+ *A route computation is what a routing function and the router do with
+ *the set of one flit: Clear, one AddRange per candidate, then a pass over
+ *the elements as in VC allocation. The std::set version also makes the
+ *copy of the set IQRouter used to take. Build with "make bench" and run
+ *
+ *  bench/outputset_bench [iterations]
+ *
+ */
+
+#include <sys/time.h>
+
+#include <set>
+#include <cstdlib>
+#include <iostream>
+
+#include "booksim.hpp"
+#include "outputset.hpp"
+
+static double _Now( )
+{
+  struct timeval t;
+  gettimeofday( &t, NULL );
+  return (double)t.tv_sec + (double)t.tv_usec / 1000000.0;
+}
+
+// the previous OutputSet, reduced to what a route computation uses
+class SetOutputSet {
+public:
+  struct sSetElement {
+    int vc_start;
+    int vc_end;
+    int pri;
+    int output_port;
+    bool operator<( sSetElement const & other ) const {
+      return pri > other.pri; // higher priorities first!
+    }
+  };
+  void Clear( ) { _outputs.clear( ); }
+  void AddRange( int output_port, int vc_start, int vc_end, int pri ) {
+    sSetElement s;
+    s.vc_start = vc_start;
+    s.vc_end = vc_end;
+    s.pri = pri;
+    s.output_port = output_port;
+    _outputs.insert( s );
+  }
+  const set<sSetElement> & GetSet( ) const { return _outputs; }
+private:
+  set<sSetElement> _outputs;
+};
+
+// candidates of one route: port, first VC, last VC and priority
+struct Candidate {
+  int port;
+  int vc_start;
+  int vc_end;
+  int pri;
+};
+
+static long _Route( SetOutputSet & outputs, Candidate const * route, int n )
+{
+  outputs.Clear( );
+  for ( int i = 0; i < n; ++i ) {
+    outputs.AddRange( route[i].port, route[i].vc_start, route[i].vc_end, route[i].pri );
+  }
+  set<SetOutputSet::sSetElement> const setlist = outputs.GetSet( );
+  long sum = 0;
+  for ( set<SetOutputSet::sSetElement>::const_iterator iter = setlist.begin( );
+        iter != setlist.end( ); ++iter ) {
+    sum += iter->output_port + iter->vc_end - iter->vc_start;
+  }
+  return sum;
+}
+
+static long _Route( OutputSet & outputs, Candidate const * route, int n )
+{
+  outputs.Clear( );
+  for ( int i = 0; i < n; ++i ) {
+    outputs.AddRange( route[i].port, route[i].vc_start, route[i].vc_end, route[i].pri );
+  }
+  OutputSet const & setlist = outputs.GetSet( );
+  long sum = 0;
+  for ( OutputSet::const_iterator iter = setlist.begin( );
+        iter != setlist.end( ); ++iter ) {
+    sum += iter->output_port + iter->vc_end - iter->vc_start;
+  }
+  return sum;
+}
+
+// route computations per second, in millions
+template<class Set>
+static double _Run( Candidate const * route, int n, long iterations, long * checksum )
+{
+  Set outputs;
+  double const start = _Now( );
+  for ( long i = 0; i < iterations; ++i ) {
+    *checksum += _Route( outputs, route, n );
+  }
+  return (double)iterations / ( _Now( ) - start ) / 1e6;
+}
+
+int main( int argc, char * argv[] )
+{
+  long const iterations = ( argc > 1 ) ? atol( argv[1] ) : 10000000;
+  if ( iterations <= 0 ) {
+    cerr << "Usage: " << argv[0] << " [iterations]" << endl;
+    return 1;
+  }
+
+  // dimension order: one VC range on one port
+  Candidate const dor[] = { { 2, 0, 7, 0 } };
+  // UniTorus with three elevator lanes: one range per lane
+  Candidate const lanes[] = { { 4, 0, 1, 3 }, { 4, 2, 3, 2 }, { 5, 4, 7, 1 } };
+  // minimal adaptive: two productive ports plus the escape VCs
+  Candidate const adaptive[] = { { 0, 2, 7, 3 }, { 2, 2, 7, 2 }, { 0, 0, 1, 1 },
+                                 { 2, 1, 1, 0 } };
+
+  struct {
+    char const * name;
+    Candidate const * route;
+    int n;
+  } const cases[] = { { "dor (1 range)     ", dor, 1 },
+                      { "3 lanes           ", lanes, 3 },
+                      { "adaptive (4 adds) ", adaptive, 4 } };
+
+  cout << iterations << " route computations per case, M/s" << endl;
+  for ( size_t c = 0; c < sizeof( cases ) / sizeof( cases[0] ); ++c ) {
+    long set_sum = 0;
+    long inline_sum = 0;
+    double const set_rate = _Run<SetOutputSet>( cases[c].route, cases[c].n,
+                                                iterations, &set_sum );
+    double const inline_rate = _Run<OutputSet>( cases[c].route, cases[c].n,
+                                                iterations, &inline_sum );
+    if ( set_sum != inline_sum ) {
+      cerr << "Error: the sets disagree" << endl;
+      return 1;
+    }
+    cout << "  " << cases[c].name << " std::set " << set_rate
+         << ", OutputSet " << inline_rate
+         << " (" << inline_rate / set_rate << "x)" << endl;
+  }
+  return 0;
+}
@@ -60,6 +60,22 @@ BookSimConfig::BookSimConfig( )
   AddStrField( "dim_penalty", "" );    // per-dimension penalty (comma-separated)
   _int_map["unitorus_debug"] = 0;      // enable debug output for UniTorus
   AddStrField( "elevator_mapping_coords", "" );
+  // elevator placement without a literal mapping: a CSV of elevator
+  // columns (or a full table) and the assignment policy (nearest, tiled,
+  // checkerboard or table), see UniTorus::_AssignElevators; takes
+  // precedence over elevator_mapping_coords
+  AddStrField( "elevator_file", "" );
+  AddStrField( "elevator_assignment", "nearest" );
+  _int_map["elevator_tile"] = 4;
+  // adaptive_elevator routing: number of nearest elevators to choose from,
+  // and the cost in hops of a flit queued at the next router (0 picks the
+  // shortest path through a candidate; weighting congestion lowered the
+  // saturation rate on 8x8x3 and 16x16x3)
+  _int_map["elevator_candidates"] = 2;
+  _float_map["elevator_congestion_weight"] = 0.0;
+  // src_dst_elevator routing: cost of the planar path via an elevator,
+  // "hops" or "latency" (hops weighted by dim_latency)
+  AddStrField( "elevator_pair_cost", "hops" );
   AddStrField( "routing_function", "none" );
   AddStrField( "vertical_topology", "mesh" );
   _int_map["enable_shadow_registers"] = 1;
@@ -243,6 +259,28 @@ BookSimConfig::BookSimConfig( )
 
   _int_map["warmup_periods"] = 3; // number of samples periods to "warm-up" the simulation
 
+  // only visit channels and routers with pending work each cycle; results
+  // are identical to the default cycle-by-cycle loop
+  _int_map["event_driven"] = 0;
+
+  // threads evaluating the routers of each network in parallel; results
+  // are identical for any number of threads
+  _int_map["sim_threads"] = 1;
+
+  // sample inter-arrival gaps of the injection processes instead of
+  // drawing one random number per node and cycle; statistically
+  // equivalent, but uses the random number stream differently
+  _int_map["injection_skip_ahead"] = 0;
+
+  // trace-driven injection: replay the packets of a binary packet trace
+  // (see packet_trace.hpp) instead of the synthetic traffic; the trace is
+  // read through a memory-mapped window of packet_trace_window MB. With
+  // packet_trace_replies, reply records are ignored and every request gets
+  // a reply once it arrives, as with use_read_write.
+  AddStrField("packet_trace", "");
+  _int_map["packet_trace_window"] = 64;
+  _int_map["packet_trace_replies"] = 0;
+
   _int_map["sample_period"] = 1000; // how long between measurements
   _int_map["max_samples"]   = 10;   // maximum number of sample periods in a simulation
 
@@ -251,6 +289,67 @@ BookSimConfig::BookSimConfig( )
   AddStrField("measure_stats", ""); // workaround to allow for vector specification
   //whether to enable per pair statistics, caution N^2 memory usage
   _int_map["pair_stats"] = 0;
+  // optional per pair power-of-two histogram for p50/p90/p99
+  _int_map["pair_stats_sketch"] = 0;
+  // dump of the per pair statistics at the end of the run ("csv" or "binary")
+  AddStrField("pair_stats_out", "");
+  AddStrField("pair_stats_format", "csv");
+
+  // per sample period utilization of every channel and occupancy of the
+  // input buffer it feeds, written as CSV
+  AddStrField("channel_stats_out", "");
+
+  // per elevator packets, vertical wait and extra planar hops (3D UniTorus),
+  // printed after the run; elevator_stats_out adds one CSV block per sample
+  _int_map["elevator_stats"] = 0;
+  AddStrField("elevator_stats_out", "");
+
+  //==== In-process sweep ================================
+  // a non-empty sweep_injection_rate runs one simulation per point instead
+  // of a single one; ranges are given as {min:max:step} or as a list
+  AddStrField("sweep_injection_rate", "");
+  AddStrField("sweep_traffic", "");           // defaults to traffic
+  AddStrField("sweep_dim_sizes", "");         // e.g. {{4,4,3},{8,8,3}}, defaults to dim_sizes
+  AddStrField("sweep_num_vcs", "");           // defaults to num_vcs
+  AddStrField("sweep_vertical_topology", ""); // defaults to vertical_topology
+  AddStrField("sweep_output_file", "results_unitorus.csv"); // "-" for stdout
+  _int_map["sweep_jobs"] = 1; // points run in parallel (forked workers), see --jobs
+
+  // sim_type = saturation_search: bracket and bisect the injection rate at
+  // which latency_thres is exceeded, for each sweep_* configuration
+  _float_map["saturation_min_rate"] = 0.01;
+  _float_map["saturation_max_rate"] = 1.0;
+  _float_map["saturation_precision"] = 0.005; // width of the final bracket
+  _int_map["saturation_knee_points"] = 3;     // extra points below the knee
+  _float_map["saturation_knee_step"] = 0.01;
+  AddStrField("saturation_output_file", "saturation_unitorus.csv"); // "-" for stdout
+  AddStrField("saturation_probe_file", ""); // all probes, in sweep CSV format
+
+  // sim_type = elevator_placement: search elevator columns of a 3D unitorus
+  // with an analytic channel-load model
+  _int_map["placement_elevators"] = 8;
+  AddStrField("placement_search", "anneal"); // greedy or anneal
+  _int_map["placement_iterations"] = 20000;  // annealing moves per chain
+  _int_map["placement_chains"] = 4;
+  _int_map["placement_threads"] = 0;         // 0 for all hardware threads
+  _int_map["placement_samples"] = 64;        // destinations per node of random traffic
+  _int_map["placement_top"] = 5;             // placements reported
+  _int_map["placement_confirm"] = 0;         // placements checked by saturation search
+  AddStrField("placement_output_file", "");
+
+  // sim_type = analytic: saturation throughput and latency estimate from the
+  // channel loads of the routing function, at the sweep_injection_rate points
+  _int_map["analytic_samples"] = 64;       // destinations per node of random traffic
+  _int_map["analytic_route_samples"] = 16; // routes per pair of adaptive routing
+  AddStrField("analytic_output_file", ""); // in sweep CSV format
+  AddStrField("analytic_channel_out", ""); // per-channel load, keyed like channel_stats_out
+
+  //==== Checkpoints =====================================
+  // save the state at the end of the first warmup, or resume from such a
+  // file instead of warming up (iq routers and sim_type latency/throughput)
+  AddStrField("checkpoint_save", "");
+  AddStrField("checkpoint_load", "");
+  _int_map["checkpoint_seed"] = -1; // if non-negative, reseed after loading
 
   // if avg. latency exceeds the threshold, assume unstable
   _float_map["latency_thres"] = 500.0;
@@ -268,6 +367,14 @@ BookSimConfig::BookSimConfig( )
   _float_map["acc_stopping_thres"] = 0.05;
   AddStrField("acc_stopping_thres", ""); // workaround to allow for vector specification
 
+  // "change" stops after three sample periods within the stopping
+  // thresholds; "confidence" treats sample periods as batches and stops once
+  // the 95% confidence half-widths of latency and accepted rate are within
+  // confidence_precision of their means
+  AddStrField("stopping_mode", "change");
+  _float_map["confidence_precision"] = 0.05;
+  _int_map["confidence_min_batches"] = 5;
+
   _int_map["sim_count"]     = 1;   // number of simulations to perform
 
 
@@ -297,6 +404,19 @@ BookSimConfig::BookSimConfig( )
 
   AddStrField("watch_out", "");
 
+  // binary trace of flit events, see event_trace.hpp; sweep and saturation
+  // search points write trace_out.<point>
+  AddStrField("trace_out", "");
+  // subset of {inject,route,vc_alloc,sw_alloc,traverse,eject}; empty for all
+  AddStrField("trace_events", "");
+  // trace one packet in trace_sample, created between trace_start and
+  // trace_end (-1: end of the simulation)
+  _int_map["trace_sample"] = 1;
+  _int_map["trace_start"] = 0;
+  _int_map["trace_end"] = -1;
+  _int_map["trace_compress"] = 1;
+  _int_map["trace_block"] = 4096;
+
   AddStrField("stats_out", "");
 
 #ifdef TRACK_FLOWS
@@ -25,6 +25,7 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <limits>
 #include <sstream>
 
 #include "globals.hpp"
@@ -35,20 +36,55 @@ Buffer::Buffer( const Configuration& config, int outputs,
 		Module *parent, const string& name ) :
 Module( parent, name ), _occupancy(0)
 {
-  int num_vcs = config.GetInt( "num_vcs" );
+  _vcs = config.GetInt( "num_vcs" );
 
+  int const vc_buf_size = config.GetInt( "vc_buf_size" );
   _size = config.GetInt("buf_size");
   if(_size < 0) {
-    _size = num_vcs * config.GetInt( "vc_buf_size" );
+    _size = _vcs * vc_buf_size;
   };
 
-  _vc.resize(num_vcs);
+  _state.resize(_vcs, VC::idle);
+  _out_port.resize(_vcs, -1);
+  _out_vc.resize(_vcs, -1);
+  _pri.resize(_vcs, 0);
+  _expected_pid.resize(_vcs, -1);
+  _watched.resize(_vcs, false);
 
-  for(int i = 0; i < num_vcs; ++i) {
-    ostringstream vc_name;
-    vc_name << "vc_" << i;
-    _vc[i] = new VC(config, outputs, this, vc_name.str( ) );
+  _ring_shift = 0;
+  while((1 << _ring_shift) < vc_buf_size) {
+    ++_ring_shift;
   }
+  _ring_mask = (1 << _ring_shift) - 1;
+  _flits.resize(_vcs << _ring_shift, NULL);
+  _head.resize(_vcs, 0);
+  _count.resize(_vcs, 0);
+
+  _lookahead_routing = !config.GetInt("routing_delay");
+  if(_lookahead_routing) {
+    _route_set.resize(_vcs, NULL);
+  } else {
+    _own_route_set.resize(_vcs);
+    _route_set.resize(_vcs);
+    for(int i = 0; i < _vcs; ++i) {
+      _route_set[i] = &_own_route_set[i];
+    }
+  }
+
+  string priority = config.GetStr( "priority" );
+  if ( priority == "local_age" ) {
+    _pri_type = local_age_based;
+  } else if ( priority == "queue_length" ) {
+    _pri_type = queue_length_based;
+  } else if ( priority == "hop_count" ) {
+    _pri_type = hop_count_based;
+  } else if ( priority == "none" ) {
+    _pri_type = none;
+  } else {
+    _pri_type = other;
+  }
+
+  _priority_donation = config.GetInt("vc_priority_donation");
 
 #ifdef TRACK_BUFFERS
   int classes = config.GetInt("classes");
@@ -56,28 +92,206 @@ Module( parent, name ), _occupancy(0)
 #endif
 }
 
-Buffer::~Buffer()
-{
-  for(vector<VC*>::iterator i = _vc.begin(); i != _vc.end(); ++i) {
-    delete *i;
-  }
-}
-
 void Buffer::AddFlit( int vc, Flit *f )
 {
+  assert(f);
+
   if(_occupancy >= _size) {
     Error("Flit buffer overflow.");
   }
+
+  if(_expected_pid[vc] >= 0) {
+    if(f->pid != _expected_pid[vc]) {
+      ostringstream err;
+      err << "Received flit " << f->id << " with unexpected packet ID: " << f->pid 
+	  << " (expected: " << _expected_pid[vc] << ")";
+      cout << "Error in " << _VCName(vc) << " : " << err.str() << endl;
+      exit(-1);
+    } else if(f->tail) {
+      _expected_pid[vc] = -1;
+    }
+  } else if(!f->tail) {
+    _expected_pid[vc] = f->pid;
+  }
+    
+  // update flit priority before adding to VC buffer
+  if(_pri_type == local_age_based) {
+    f->pri = numeric_limits<int>::max() - GetSimTime();
+    assert(f->pri >= 0);
+  } else if(_pri_type == hop_count_based) {
+    f->pri = f->hops;
+    assert(f->pri >= 0);
+  }
+
+  if(_count[vc] > _ring_mask) {
+    _GrowRings();
+  }
+  _flits[(vc << _ring_shift) + ((_head[vc] + _count[vc]) & _ring_mask)] = f;
+  ++_count[vc];
   ++_occupancy;
-  _vc[vc]->AddFlit(f);
 #ifdef TRACK_BUFFERS
   ++_class_occupancy[f->cl];
 #endif
+  _UpdatePriority(vc);
+}
+
+Flit *Buffer::RemoveFlit( int vc )
+{
+  if(!_count[vc]) {
+    cout << "Error in " << _VCName(vc) << " : "
+	 << "Trying to remove flit from empty buffer." << endl;
+    exit(-1);
+  }
+  Flit * const f = FrontFlit(vc);
+  _head[vc] = (_head[vc] + 1) & _ring_mask;
+  --_count[vc];
+  --_occupancy;
+#ifdef TRACK_BUFFERS
+  assert(_class_occupancy[f->cl] > 0);
+  --_class_occupancy[f->cl];
+#endif
+  _UpdatePriority(vc);
+  return f;
+}
+
+// Double the ring size of every VC, unrolling each ring to start at 0
+void Buffer::_GrowRings( )
+{
+  int const old_size = 1 << _ring_shift;
+  vector<Flit *> flits(_vcs << (_ring_shift + 1), NULL);
+  for(int vc = 0; vc < _vcs; ++vc) {
+    for(int i = 0; i < _count[vc]; ++i) {
+      flits[(vc << (_ring_shift + 1)) + i] = _Flit(vc, i);
+    }
+    _head[vc] = 0;
+  }
+  _flits.swap(flits);
+  ++_ring_shift;
+  _ring_mask = (old_size << 1) - 1;
+}
+
+void Buffer::_UpdatePriority( int vc )
+{
+  if(!_count[vc]) return;
+  if(_pri_type == queue_length_based) {
+    _pri[vc] = _count[vc];
+  } else if(_pri_type != none) {
+    Flit * f = FrontFlit(vc);
+    if((_pri_type != local_age_based) && _priority_donation) {
+      Flit * df = f;
+      for(int i = 1; i < _count[vc]; ++i) {
+	Flit * bf = _Flit(vc, i);
+	if(bf->pri > df->pri) df = bf;
+      }
+      if((df != f) && (df->watch || f->watch)) {
+	*gWatchOut << GetSimTime() << " | " << _VCName(vc) << " | "
+		    << "Flit " << df->id
+		    << " donates priority to flit " << f->id
+		    << "." << endl;
+      }
+      f = df;
+    }
+    if(f->watch)
+      *gWatchOut << GetSimTime() << " | " << _VCName(vc) << " | "
+		  << "Flit " << f->id
+		  << " sets priority to " << f->pri
+		  << "." << endl;
+    _pri[vc] = f->pri;
+  }
+}
+
+void Buffer::_WatchStateChange( int vc, VC::eVCState s ) const
+{
+  *gWatchOut << GetSimTime() << " | " << _VCName(vc) << " | "
+	      << "Changing state from " << VC::VCSTATE[_state[vc]]
+	      << " to " << VC::VCSTATE[s] << "." << endl;
+}
+
+// name of a VC in the module hierarchy, for watch and error output
+string Buffer::_VCName( int vc ) const
+{
+  ostringstream name;
+  name << FullName() << "/vc_" << vc;
+  return name.str();
 }
 
 void Buffer::Display( ostream & os ) const
 {
-  for(vector<VC*>::const_iterator i = _vc.begin(); i != _vc.end(); ++i) {
-    (*i)->Display(os);
+  for(int vc = 0; vc < _vcs; ++vc) {
+    if ( _state[vc] != VC::idle ) {
+      os << _VCName(vc) << ": "
+	 << " state: " << VC::VCSTATE[_state[vc]];
+      if(_state[vc] == VC::active) {
+	os << " out_port: " << _out_port[vc]
+	   << " out_vc: " << _out_vc[vc];
+      }
+      os << " fill: " << _count[vc];
+      if(_count[vc]) {
+	os << " front: " << FrontFlit(vc)->id;
+      }
+      os << " pri: " << _pri[vc];
+      os << endl;
+    }
+  }
+}
+
+void Buffer::SaveState( CheckpointWriter & writer ) const
+{
+  for(int vc = 0; vc < _vcs; ++vc) {
+    writer.WriteInt(_state[vc]);
+    writer.WriteInt(_out_port[vc]);
+    writer.WriteInt(_out_vc[vc]);
+    writer.WriteInt(_pri[vc]);
+    writer.WriteInt(_expected_pid[vc]);
+    writer.WriteBool(_watched[vc]);
+    writer.WriteInt(_count[vc]);
+    for(int i = 0; i < _count[vc]; ++i) {
+      writer.Write(_Flit(vc, i));
+    }
+    // with lookahead routing, the route set is that of the head flit at the
+    // front of the VC while it is being routed and allocated
+    if(_lookahead_routing) {
+      bool const front_route_set = _count[vc] && 
+	(_route_set[vc] == &FrontFlit(vc)->la_route_set);
+      writer.WriteBool(front_route_set);
+    } else {
+      writer.Write(*_route_set[vc]);
+    }
+  }
+}
+
+void Buffer::LoadState( CheckpointReader & reader )
+{
+  _occupancy = 0;
+#ifdef TRACK_BUFFERS
+  _class_occupancy.assign(_class_occupancy.size(), 0);
+#endif
+  for(int vc = 0; vc < _vcs; ++vc) {
+    _state[vc] = (VC::eVCState)reader.ReadInt();
+    _out_port[vc] = reader.ReadInt();
+    _out_vc[vc] = reader.ReadInt();
+    _pri[vc] = reader.ReadInt();
+    _expected_pid[vc] = reader.ReadInt();
+    _watched[vc] = reader.ReadBool();
+    int const count = reader.ReadInt();
+    while(count > _ring_mask + 1) {
+      _GrowRings();
+    }
+    _head[vc] = 0;
+    _count[vc] = count;
+    for(int i = 0; i < count; ++i) {
+      Flit * f;
+      reader.Read(f);
+      _flits[(vc << _ring_shift) + i] = f;
+#ifdef TRACK_BUFFERS
+      ++_class_occupancy[f->cl];
+#endif
+    }
+    _occupancy += count;
+    if(_lookahead_routing) {
+      _route_set[vc] = reader.ReadBool() ? &FrontFlit(vc)->la_route_set : NULL;
+    } else {
+      reader.Read(_route_set[vc]);
+    }
   }
 }
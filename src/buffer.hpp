@@ -35,45 +35,79 @@
 #include "outputset.hpp"
 #include "routefunc.hpp"
 #include "config_utils.hpp"
-
+#include "checkpoint.hpp"
+
+// Input buffer of a router port. The per-VC state is kept as a structure of
+// arrays indexed by VC, so the allocation stages scan contiguous state,
+// output and priority arrays instead of chasing one heap object per VC.
+// Flits are stored in per-VC ring buffers that share one array; the ring
+// size starts at vc_buf_size (rounded up to a power of two) and is doubled
+// for all VCs if a shared buffer policy lets a VC grow beyond it.
 class Buffer : public Module {
   
   int _occupancy;
   int _size;
 
-  vector<VC*> _vc;
+  int _vcs;
+
+  vector<VC::eVCState> _state;
+  vector<int> _out_port;
+  vector<int> _out_vc;
+  vector<int> _pri;
+  vector<OutputSet *> _route_set;
+
+  // flit storage: VC v uses _flits[v << _ring_shift, ...) as a ring
+  vector<Flit *> _flits;
+  int _ring_shift;
+  int _ring_mask;
+  vector<int> _head;
+  vector<int> _count;
+
+  // route sets owned by the buffer when routing is not done by lookahead
+  vector<OutputSet> _own_route_set;
+
+  vector<int> _expected_pid;
+  vector<bool> _watched;
+
+  enum ePrioType { local_age_based, queue_length_based, hop_count_based, none, other };
+
+  ePrioType _pri_type;
+
+  int _priority_donation;
+
+  bool _lookahead_routing;
 
 #ifdef TRACK_BUFFERS
   vector<int> _class_occupancy;
 #endif
 
+  inline Flit * _Flit( int vc, int i ) const
+  {
+    return _flits[(vc << _ring_shift) + ((_head[vc] + i) & _ring_mask)];
+  }
+
+  void _GrowRings( );
+  void _UpdatePriority( int vc );
+  void _WatchStateChange( int vc, VC::eVCState s ) const;
+  string _VCName( int vc ) const;
+
 public:
   
   Buffer( const Configuration& config, int outputs,
 	  Module *parent, const string& name );
-  ~Buffer();
 
   void AddFlit( int vc, Flit *f );
 
-  inline Flit *RemoveFlit( int vc )
-  {
-    --_occupancy;
-#ifdef TRACK_BUFFERS
-    int cl = _vc[vc]->FrontFlit()->cl;
-    assert(_class_occupancy[cl] > 0);
-    --_class_occupancy[cl];
-#endif
-    return _vc[vc]->RemoveFlit( );
-  }
+  Flit *RemoveFlit( int vc );
   
   inline Flit *FrontFlit( int vc ) const
   {
-    return _vc[vc]->FrontFlit( );
+    return _count[vc] ? _flits[(vc << _ring_shift) + _head[vc]] : NULL;
   }
   
   inline bool Empty( int vc ) const
   {
-    return _vc[vc]->Empty( );
+    return !_count[vc];
   }
 
   inline bool Full( ) const
@@ -83,59 +117,66 @@ public:
 
   inline VC::eVCState GetState( int vc ) const
   {
-    return _vc[vc]->GetState( );
+    return _state[vc];
   }
 
   inline void SetState( int vc, VC::eVCState s )
   {
-    _vc[vc]->SetState(s);
+    if(_count[vc] && FrontFlit(vc)->watch)
+      _WatchStateChange(vc, s);
+    _state[vc] = s;
   }
 
   inline const OutputSet *GetRouteSet( int vc ) const
   {
-    return _vc[vc]->GetRouteSet( );
+    return _route_set[vc];
   }
 
   inline void SetRouteSet( int vc, OutputSet * output_set )
   {
-    _vc[vc]->SetRouteSet(output_set);
+    _route_set[vc] = output_set;
+    _out_port[vc] = -1;
+    _out_vc[vc] = -1;
   }
 
   inline void SetOutput( int vc, int out_port, int out_vc )
   {
-    _vc[vc]->SetOutput(out_port, out_vc);
+    _out_port[vc] = out_port;
+    _out_vc[vc] = out_vc;
   }
 
   inline int GetOutputPort( int vc ) const
   {
-    return _vc[vc]->GetOutputPort( );
+    return _out_port[vc];
   }
 
   inline int GetOutputVC( int vc ) const
   {
-    return _vc[vc]->GetOutputVC( );
+    return _out_vc[vc];
   }
 
   inline int GetPriority( int vc ) const
   {
-    return _vc[vc]->GetPriority( );
+    return _pri[vc];
   }
 
   inline void Route( int vc, tRoutingFunction rf, const Router* router, const Flit* f, int in_channel )
   {
-    _vc[vc]->Route(rf, router, f, in_channel);
+    rf( router, f, in_channel, _route_set[vc], false );
+    _out_port[vc] = -1;
+    _out_vc[vc] = -1;
   }
 
   // ==== Debug functions ====
 
   inline void SetWatch( int vc, bool watch = true )
   {
-    _vc[vc]->SetWatch(watch);
+    _watched[vc] = watch;
   }
 
   inline bool IsWatched( int vc ) const
   {
-    return _vc[vc]->IsWatched( );
+    return _watched[vc];
   }
 
   inline int GetOccupancy( ) const
@@ -145,7 +186,7 @@ public:
 
   inline int GetOccupancy( int vc ) const
   {
-    return _vc[vc]->GetOccupancy( );
+    return _count[vc];
   }
 
 #ifdef TRACK_BUFFERS
@@ -156,6 +197,9 @@ public:
 #endif
 
   void Display( ostream & os = cout ) const;
+
+  void SaveState( CheckpointWriter & writer ) const;
+  void LoadState( CheckpointReader & reader );
 };
 
 #endif 
@@ -573,7 +573,7 @@ void BufferState::ProcessCredit( Credit const * const c )
 {
   assert( c );
 
-  set<int>::iterator iter = c->vc.begin();
+  Credit::VCSet::const_iterator iter = c->vc.begin();
   while(iter != c->vc.end()) {
 
     int const vc = *iter;
@@ -674,3 +674,120 @@ void BufferState::Display( ostream & os ) const
        << ", occupied = " << _vc_occupancy[v] << endl;
   }
 }
+
+//=============================================================
+// Checkpoints
+
+static void _SaveQueue( CheckpointWriter & writer, queue<int> q )
+{
+  writer.WriteInt(q.size());
+  while(!q.empty()) {
+    writer.WriteInt(q.front());
+    q.pop();
+  }
+}
+
+static void _LoadQueue( CheckpointReader & reader, queue<int> & q )
+{
+  q = queue<int>();
+  int const size = reader.ReadInt();
+  for(int i = 0; i < size; ++i) {
+    q.push(reader.ReadInt());
+  }
+}
+
+void BufferState::SharedBufferPolicy::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInts(_private_buf_occupancy);
+  writer.WriteInt(_shared_buf_occupancy);
+  writer.WriteInts(_reserved_slots);
+}
+
+void BufferState::SharedBufferPolicy::LoadState( CheckpointReader & reader )
+{
+  _private_buf_occupancy = reader.ReadInts();
+  _shared_buf_occupancy = reader.ReadInt();
+  _reserved_slots = reader.ReadInts();
+}
+
+void BufferState::LimitedSharedBufferPolicy::SaveState( CheckpointWriter & writer ) const
+{
+  SharedBufferPolicy::SaveState(writer);
+  writer.WriteInt(_active_vcs);
+  writer.WriteInt(_max_held_slots);
+}
+
+void BufferState::LimitedSharedBufferPolicy::LoadState( CheckpointReader & reader )
+{
+  SharedBufferPolicy::LoadState(reader);
+  _active_vcs = reader.ReadInt();
+  _max_held_slots = reader.ReadInt();
+}
+
+void BufferState::FeedbackSharedBufferPolicy::SaveState( CheckpointWriter & writer ) const
+{
+  SharedBufferPolicy::SaveState(writer);
+  writer.WriteInts(_occupancy_limit);
+  writer.WriteInts(_round_trip_time);
+  for(int vc = 0; vc < _vcs; ++vc) {
+    _SaveQueue(writer, _flit_sent_time[vc]);
+  }
+  writer.WriteInt(_total_mapped_size);
+}
+
+void BufferState::FeedbackSharedBufferPolicy::LoadState( CheckpointReader & reader )
+{
+  SharedBufferPolicy::LoadState(reader);
+  _occupancy_limit = reader.ReadInts();
+  _round_trip_time = reader.ReadInts();
+  for(int vc = 0; vc < _vcs; ++vc) {
+    _LoadQueue(reader, _flit_sent_time[vc]);
+  }
+  _total_mapped_size = reader.ReadInt();
+}
+
+void BufferState::SimpleFeedbackSharedBufferPolicy::SaveState( CheckpointWriter & writer ) const
+{
+  FeedbackSharedBufferPolicy::SaveState(writer);
+  writer.WriteInts(_pending_credits);
+}
+
+void BufferState::SimpleFeedbackSharedBufferPolicy::LoadState( CheckpointReader & reader )
+{
+  FeedbackSharedBufferPolicy::LoadState(reader);
+  _pending_credits = reader.ReadInts();
+}
+
+void BufferState::SaveState( CheckpointWriter & writer ) const
+{
+  writer.WriteInt(_occupancy);
+  writer.WriteInts(_vc_occupancy);
+  writer.WriteInts(_in_use_by);
+  writer.WriteBools(_tail_sent);
+  writer.WriteInts(_last_id);
+  writer.WriteInts(_last_pid);
+#ifdef TRACK_BUFFERS
+  for(int vc = 0; vc < _vcs; ++vc) {
+    _SaveQueue(writer, _outstanding_classes[vc]);
+  }
+  writer.WriteInts(_class_occupancy);
+#endif
+  _buffer_policy->SaveState(writer);
+}
+
+void BufferState::LoadState( CheckpointReader & reader )
+{
+  _occupancy = reader.ReadInt();
+  _vc_occupancy = reader.ReadInts();
+  _in_use_by = reader.ReadInts();
+  _tail_sent = reader.ReadBools();
+  _last_id = reader.ReadInts();
+  _last_pid = reader.ReadInts();
+#ifdef TRACK_BUFFERS
+  for(int vc = 0; vc < _vcs; ++vc) {
+    _LoadQueue(reader, _outstanding_classes[vc]);
+  }
+  _class_occupancy = reader.ReadInts();
+#endif
+  _buffer_policy->LoadState(reader);
+}
@@ -35,6 +35,7 @@
 #include "flit.hpp"
 #include "credit.hpp"
 #include "config_utils.hpp"
+#include "checkpoint.hpp"
 
 class BufferState : public Module {
   
@@ -52,6 +53,10 @@ class BufferState : public Module {
     virtual int AvailableFor(int vc = 0) const = 0;
     virtual int LimitFor(int vc = 0) const = 0;
 
+    // Checkpoints: the state that changes as flits and credits pass
+    virtual void SaveState(CheckpointWriter & writer) const {}
+    virtual void LoadState(CheckpointReader & reader) {}
+
     static BufferPolicy * New(Configuration const & config, 
 			      BufferState * parent, const string & name);
   };
@@ -86,6 +91,8 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const;
     virtual int AvailableFor(int vc = 0) const;
     virtual int LimitFor(int vc = 0) const;
+    virtual void SaveState(CheckpointWriter & writer) const;
+    virtual void LoadState(CheckpointReader & reader);
   };
 
   class LimitedSharedBufferPolicy : public SharedBufferPolicy {
@@ -102,6 +109,8 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const;
     virtual int AvailableFor(int vc = 0) const;
     virtual int LimitFor(int vc = 0) const;
+    virtual void SaveState(CheckpointWriter & writer) const;
+    virtual void LoadState(CheckpointReader & reader);
   };
     
   class DynamicLimitedSharedBufferPolicy : public LimitedSharedBufferPolicy {
@@ -144,6 +153,8 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const;
     virtual int AvailableFor(int vc = 0) const;
     virtual int LimitFor(int vc = 0) const;
+    virtual void SaveState(CheckpointWriter & writer) const;
+    virtual void LoadState(CheckpointReader & reader);
   };
   
   class SimpleFeedbackSharedBufferPolicy : public FeedbackSharedBufferPolicy {
@@ -154,6 +165,8 @@ class BufferState : public Module {
 				     BufferState * parent, const string & name);
     virtual void SendingFlit(Flit const * const f);
     virtual void FreeSlotFor(int vc = 0);
+    virtual void SaveState(CheckpointWriter & writer) const;
+    virtual void LoadState(CheckpointReader & reader);
   };
   
   bool _wait_for_tail_credit;
@@ -234,6 +247,9 @@ public:
 #endif
 
   void Display( ostream & os = cout ) const;
+
+  void SaveState( CheckpointWriter & writer ) const;
+  void LoadState( CheckpointReader & reader );
 };
 
 #endif 
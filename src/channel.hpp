@@ -43,9 +43,24 @@
 #include "globals.hpp"
 #include "module.hpp"
 #include "timed_module.hpp"
+#include "checkpoint.hpp"
 
 using namespace std;
 
+class Flit;
+class Credit;
+template<typename T> class Channel;
+
+// Receives activity notifications from channels; used by the event-driven
+// network kernel to only visit modules that have work to do
+class ActivityListener {
+public:
+  virtual ~ActivityListener() {}
+  virtual void ChannelBusy(Channel<Flit> * channel) = 0;
+  virtual void ChannelBusy(Channel<Credit> * channel) = 0;
+  virtual void WakeReceiver(int receiver) = 0;
+};
+
 template<typename T>
 class Channel : public TimedModule {
 public:
@@ -66,17 +81,38 @@ public:
   virtual void Evaluate() {}
   virtual void WriteOutputs();
 
+  // Event-driven kernel: the listener is told when data is sent on an idle
+  // channel, and which receiver to wake when data arrives at the output
+  void SetActivityListener(ActivityListener * listener, int receiver = -1) {
+    _listener = listener;
+    _receiver = receiver;
+  }
+  // called after WriteOutputs; returns false once the channel went idle
+  inline bool UpdateBusy() {
+    _busy = _input || _output || !_wait_queue.empty();
+    return _busy;
+  }
+
+  // Checkpoints: data on the channel, including data still in flight
+  virtual void SaveState(CheckpointWriter & writer) const;
+  virtual void LoadState(CheckpointReader & reader);
+
 protected:
   int _delay;
   T * _input;
   T * _output;
   queue<pair<int, T *> > _wait_queue;
 
+  ActivityListener * _listener;
+  int _receiver;
+  bool _busy;
+
 };
 
 template<typename T>
 Channel<T>::Channel(Module * parent, string const & name)
-  : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+  : TimedModule(parent, name), _delay(1), _input(0), _output(0),
+    _listener(0), _receiver(-1), _busy(false) {
 }
 
 template<typename T>
@@ -90,6 +126,10 @@ void Channel<T>::SetLatency(int cycles) {
 template<typename T>
 void Channel<T>::Send(T * data) {
   _input = data;
+  if(data && _listener && !_busy) {
+    _busy = true;
+    _listener->ChannelBusy(this);
+  }
 }
 
 template<typename T>
@@ -120,6 +160,38 @@ void Channel<T>::WriteOutputs() {
   _output = item.second;
   assert(_output);
   _wait_queue.pop();
+  if(_listener && (_receiver >= 0)) {
+    _listener->WakeReceiver(_receiver);
+  }
+}
+
+template<typename T>
+void Channel<T>::SaveState(CheckpointWriter & writer) const {
+  writer.Write(_input);
+  writer.Write(_output);
+  queue<pair<int, T *> > wait_queue = _wait_queue;
+  writer.WriteInt(wait_queue.size());
+  while(!wait_queue.empty()) {
+    writer.WriteInt(wait_queue.front().first);
+    writer.Write(wait_queue.front().second);
+    wait_queue.pop();
+  }
+}
+
+template<typename T>
+void Channel<T>::LoadState(CheckpointReader & reader) {
+  reader.Read(_input);
+  reader.Read(_output);
+  _wait_queue = queue<pair<int, T *> >();
+  int const size = reader.ReadInt();
+  for(int i = 0; i < size; ++i) {
+    int const time = reader.ReadInt();
+    T * data;
+    reader.Read(data);
+    _wait_queue.push(make_pair(time, data));
+  }
+  // the event-driven kernel rebuilds its busy lists after loading
+  _busy = false;
 }
 
 #endif
@@ -0,0 +1,373 @@
+// $Id$
+
+/*checkpoint.cpp
+ *
+ *Binary writer and reader for simulator checkpoints
+ *
+ */
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+#include "booksim.hpp"
+#include "checkpoint.hpp"
+#include "flit.hpp"
+#include "credit.hpp"
+#include "outputset.hpp"
+
+CheckpointWriter::CheckpointWriter( string const & filename )
+  : _filename( filename ), _os( filename.c_str( ), ios::binary )
+{
+  if ( !_os ) {
+    cout << "Error: Could not open checkpoint file " << filename
+         << " for writing." << endl;
+    exit(-1);
+  }
+}
+
+void CheckpointWriter::_Write( void const * data, size_t size )
+{
+  _os.write( static_cast<char const *>( data ), size );
+  if ( !_os ) {
+    cout << "Error: Could not write checkpoint file " << _filename << "." << endl;
+    exit(-1);
+  }
+}
+
+void CheckpointWriter::WriteInt( int value )
+{
+  _Write( &value, sizeof( value ) );
+}
+
+void CheckpointWriter::WriteLong( long value )
+{
+  _Write( &value, sizeof( value ) );
+}
+
+void CheckpointWriter::WriteBool( bool value )
+{
+  char const c = value ? 1 : 0;
+  _Write( &c, sizeof( c ) );
+}
+
+void CheckpointWriter::WriteDouble( double value )
+{
+  _Write( &value, sizeof( value ) );
+}
+
+void CheckpointWriter::WriteString( string const & value )
+{
+  WriteInt( value.size( ) );
+  _Write( value.data( ), value.size( ) );
+}
+
+void CheckpointWriter::WriteInts( vector<int> const & values )
+{
+  WriteInt( values.size( ) );
+  if ( !values.empty( ) ) {
+    _Write( &values[0], values.size( ) * sizeof( int ) );
+  }
+}
+
+void CheckpointWriter::WriteBools( vector<bool> const & values )
+{
+  WriteInt( values.size( ) );
+  for ( size_t i = 0; i < values.size( ); ++i ) {
+    WriteBool( values[i] );
+  }
+}
+
+void CheckpointWriter::Write( Flit const * f )
+{
+  if ( !f ) {
+    WriteInt( -1 );
+    return;
+  }
+  map<Flit const *, int>::const_iterator iter = _flits.find( f );
+  if ( iter != _flits.end( ) ) {
+    WriteInt( iter->second );
+    return;
+  }
+  int const index = _flits.size( );
+  _flits[f] = index;
+  WriteInt( index );
+
+  if ( f->data ) {
+    cout << "Error: Cannot checkpoint flit " << f->id
+         << " carrying arbitrary data." << endl;
+    exit(-1);
+  }
+  WriteInt( f->type );
+  WriteInt( f->vc );
+  WriteInt( f->cl );
+  WriteBool( f->head );
+  WriteBool( f->tail );
+  WriteInt( f->ctime );
+  WriteInt( f->itime );
+  WriteInt( f->atime );
+  WriteInt( f->rtime );
+  WriteInt( f->id );
+  WriteInt( f->pid );
+  WriteBool( f->record );
+  WriteInt( f->src );
+  WriteInt( f->dest );
+  WriteInt( f->pri );
+  WriteInt( f->hops );
+  WriteBool( f->watch );
+  WriteBool( f->trace );
+  WriteInt( f->subnetwork );
+  WriteInt( f->intm );
+  WriteInt( f->ph );
+  Write( f->la_route_set );
+}
+
+void CheckpointWriter::Write( Credit const * c )
+{
+  if ( !c ) {
+    WriteInt( -1 );
+    return;
+  }
+  map<Credit const *, int>::const_iterator iter = _credits.find( c );
+  if ( iter != _credits.end( ) ) {
+    WriteInt( iter->second );
+    return;
+  }
+  int const index = _credits.size( );
+  _credits[c] = index;
+  WriteInt( index );
+
+  WriteInt( c->vc.size( ) );
+  for ( Credit::VCSet::const_iterator iter = c->vc.begin( );
+        iter != c->vc.end( ); ++iter ) {
+    WriteInt( *iter );
+  }
+  WriteBool( c->head );
+  WriteBool( c->tail );
+  WriteInt( c->id );
+}
+
+void CheckpointWriter::Write( OutputSet const & s )
+{
+  WriteInt( s.size( ) );
+  for ( OutputSet::const_iterator iter = s.begin( ); iter != s.end( ); ++iter ) {
+    WriteInt( iter->output_port );
+    WriteInt( iter->vc_start );
+    WriteInt( iter->vc_end );
+    WriteInt( iter->pri );
+  }
+}
+
+void CheckpointWriter::WriteMarker( int marker )
+{
+  WriteInt( marker );
+}
+
+void CheckpointWriter::Close( )
+{
+  _os.close( );
+  if ( !_os ) {
+    cout << "Error: Could not write checkpoint file " << _filename << "." << endl;
+    exit(-1);
+  }
+}
+
+//=============================================================
+
+CheckpointReader::CheckpointReader( string const & filename )
+  : _filename( filename ), _is( filename.c_str( ), ios::binary )
+{
+  if ( !_is ) {
+    cout << "Error: Could not open checkpoint file " << filename
+         << " for reading." << endl;
+    exit(-1);
+  }
+}
+
+void CheckpointReader::Error( string const & msg ) const
+{
+  cout << "Error in checkpoint file " << _filename << ": " << msg << endl;
+  exit(-1);
+}
+
+void CheckpointReader::_Read( void * data, size_t size )
+{
+  _is.read( static_cast<char *>( data ), size );
+  if ( !_is ) {
+    Error( "unexpected end of file." );
+  }
+}
+
+int CheckpointReader::ReadInt( )
+{
+  int value;
+  _Read( &value, sizeof( value ) );
+  return value;
+}
+
+long CheckpointReader::ReadLong( )
+{
+  long value;
+  _Read( &value, sizeof( value ) );
+  return value;
+}
+
+bool CheckpointReader::ReadBool( )
+{
+  char c;
+  _Read( &c, sizeof( c ) );
+  return c != 0;
+}
+
+double CheckpointReader::ReadDouble( )
+{
+  double value;
+  _Read( &value, sizeof( value ) );
+  return value;
+}
+
+string CheckpointReader::ReadString( )
+{
+  int const size = ReadInt( );
+  if ( size < 0 ) {
+    Error( "invalid string length." );
+  }
+  string value( size, '\0' );
+  if ( size > 0 ) {
+    _Read( &value[0], size );
+  }
+  return value;
+}
+
+vector<int> CheckpointReader::ReadInts( )
+{
+  int const size = ReadInt( );
+  if ( size < 0 ) {
+    Error( "invalid vector length." );
+  }
+  vector<int> values( size );
+  if ( size > 0 ) {
+    _Read( &values[0], size * sizeof( int ) );
+  }
+  return values;
+}
+
+vector<bool> CheckpointReader::ReadBools( )
+{
+  int const size = ReadInt( );
+  if ( size < 0 ) {
+    Error( "invalid vector length." );
+  }
+  vector<bool> values( size );
+  for ( int i = 0; i < size; ++i ) {
+    values[i] = ReadBool( );
+  }
+  return values;
+}
+
+void CheckpointReader::Read( Flit * & f )
+{
+  int const index = ReadInt( );
+  if ( index < 0 ) {
+    f = NULL;
+    return;
+  }
+  if ( index < (int)_flits.size( ) ) {
+    f = _flits[index];
+    return;
+  }
+  if ( index != (int)_flits.size( ) ) {
+    Error( "invalid flit reference." );
+  }
+  f = Flit::New( );
+  _flits.push_back( f );
+
+  f->type = (Flit::FlitType)ReadInt( );
+  f->vc = ReadInt( );
+  f->cl = ReadInt( );
+  f->head = ReadBool( );
+  f->tail = ReadBool( );
+  f->ctime = ReadInt( );
+  f->itime = ReadInt( );
+  f->atime = ReadInt( );
+  f->rtime = ReadInt( );
+  f->id = ReadInt( );
+  f->pid = ReadInt( );
+  f->record = ReadBool( );
+  f->src = ReadInt( );
+  f->dest = ReadInt( );
+  f->pri = ReadInt( );
+  f->hops = ReadInt( );
+  f->watch = ReadBool( );
+  f->trace = ReadBool( );
+  f->subnetwork = ReadInt( );
+  f->intm = ReadInt( );
+  f->ph = ReadInt( );
+  Read( &f->la_route_set );
+}
+
+void CheckpointReader::Read( Credit * & c )
+{
+  int const index = ReadInt( );
+  if ( index < 0 ) {
+    c = NULL;
+    return;
+  }
+  if ( index < (int)_credits.size( ) ) {
+    c = _credits[index];
+    return;
+  }
+  if ( index != (int)_credits.size( ) ) {
+    Error( "invalid credit reference." );
+  }
+  c = Credit::New( );
+  _credits.push_back( c );
+
+  int const vcs = ReadInt( );
+  for ( int i = 0; i < vcs; ++i ) {
+    c->vc.insert( ReadInt( ) );
+  }
+  c->head = ReadBool( );
+  c->tail = ReadBool( );
+  c->id = ReadInt( );
+}
+
+void CheckpointReader::Read( OutputSet * s )
+{
+  s->Clear( );
+  int const size = ReadInt( );
+  for ( int i = 0; i < size; ++i ) {
+    int const output_port = ReadInt( );
+    int const vc_start = ReadInt( );
+    int const vc_end = ReadInt( );
+    int const pri = ReadInt( );
+    s->AddRange( output_port, vc_start, vc_end, pri );
+  }
+}
+
+void CheckpointReader::ReadMarker( int marker )
+{
+  if ( ReadInt( ) != marker ) {
+    Error( "file is corrupt or was written by a different version." );
+  }
+}
+
+void CheckpointReader::Expect( int value, string const & what )
+{
+  int const saved = ReadInt( );
+  if ( saved != value ) {
+    ostringstream err;
+    err << what << " is " << saved << " in the checkpoint but " << value
+        << " in the current configuration.";
+    Error( err.str( ) );
+  }
+}
+
+void CheckpointReader::Expect( string const & value, string const & what )
+{
+  string const saved = ReadString( );
+  if ( saved != value ) {
+    Error( what + " is " + saved + " in the checkpoint but " + value
+           + " in the current configuration." );
+  }
+}
@@ -0,0 +1,92 @@
+// $Id$
+
+#ifndef _CHECKPOINT_HPP_
+#define _CHECKPOINT_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+
+using namespace std;
+
+class Flit;
+class Credit;
+class OutputSet;
+
+// Binary simulator checkpoints (checkpoint_save / checkpoint_load). Values
+// are written in native byte order, so a checkpoint can only be loaded by
+// the same build on the same kind of machine.
+//
+// Flits and credits can be referenced from several places at once (e.g. a
+// buffer and the traffic manager's in-flight table). The first reference
+// writes the whole object and assigns it an index, later ones only write
+// the index; the reader allocates each object once and resolves the
+// indices to the same pointer.
+class CheckpointWriter {
+
+  string _filename;
+  ofstream _os;
+
+  map<Flit const *, int> _flits;
+  map<Credit const *, int> _credits;
+
+  void _Write( void const * data, size_t size );
+
+public:
+  CheckpointWriter( string const & filename );
+
+  void WriteInt( int value );
+  void WriteLong( long value );
+  void WriteBool( bool value );
+  void WriteDouble( double value );
+  void WriteString( string const & value );
+  void WriteInts( vector<int> const & values );
+  void WriteBools( vector<bool> const & values );
+
+  void Write( Flit const * f );
+  void Write( Credit const * c );
+  void Write( OutputSet const & s );
+
+  // marks the end of a section, checked when loading to catch mismatched
+  // save and load code early
+  void WriteMarker( int marker );
+
+  void Close( );
+};
+
+class CheckpointReader {
+
+  string _filename;
+  ifstream _is;
+
+  vector<Flit *> _flits;
+  vector<Credit *> _credits;
+
+  void _Read( void * data, size_t size );
+
+public:
+  CheckpointReader( string const & filename );
+
+  int ReadInt( );
+  long ReadLong( );
+  bool ReadBool( );
+  double ReadDouble( );
+  string ReadString( );
+  vector<int> ReadInts( );
+  vector<bool> ReadBools( );
+
+  void Read( Flit * & f );
+  void Read( Credit * & c );
+  void Read( OutputSet * s );
+
+  void ReadMarker( int marker );
+
+  // fails unless the next value equals the one of the current configuration
+  void Expect( int value, string const & what );
+  void Expect( string const & value, string const & what );
+
+  void Error( string const & msg ) const;
+};
+
+#endif
@@ -30,12 +30,11 @@
  *A class for credits
  */
 
+#include <algorithm>
+
 #include "booksim.hpp"
 #include "credit.hpp"
 
-stack<Credit *> Credit::_all;
-stack<Credit *> Credit::_free;
-
 Credit::Credit()
 {
   Reset();
@@ -50,30 +49,27 @@ void Credit::Reset()
 }
 
 Credit * Credit::New() {
-  Credit * c;
-  if(_free.empty()) {
-    c = new Credit();
-    _all.push(c);
-  } else {
-    c = _free.top();
-    c->Reset();
-    _free.pop();
-  }
+  Credit * const c = ObjectPool<Credit>::New();
+  c->Reset();
   return c;
 }
 
 void Credit::Free() {
-  _free.push(this);
+  ObjectPool<Credit>::Free(this);
 }
 
 void Credit::FreeAll() {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
-  }
+  ObjectPool<Credit>::FreeAll();
 }
 
-
 int Credit::OutStanding(){
-  return _all.size()-_free.size();
+  return ObjectPool<Credit>::Outstanding();
+}
+
+void Credit::VCSet::insert( int vc )
+{
+  vector<int>::iterator iter = lower_bound( _vcs.begin( ), _vcs.end( ), vc );
+  if ( ( iter == _vcs.end( ) ) || ( *iter != vc ) ) {
+    _vcs.insert( iter, vc );
+  }
 }
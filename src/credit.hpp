@@ -28,14 +28,29 @@
 #ifndef _CREDIT_HPP_
 #define _CREDIT_HPP_
 
-#include <set>
-#include <stack>
+#include <vector>
+
+#include "pool.hpp"
 
 class Credit {
 
 public:
 
-  set<int> vc;
+  // VCs being credited, in increasing order; the storage is kept when a
+  // credit is recycled, so pooled credits do not allocate
+  class VCSet {
+    vector<int> _vcs;
+  public:
+    typedef vector<int>::const_iterator const_iterator;
+    void insert( int vc );
+    inline const_iterator begin( ) const { return _vcs.begin( ); }
+    inline const_iterator end( ) const { return _vcs.end( ); }
+    inline size_t size( ) const { return _vcs.size( ); }
+    inline bool empty( ) const { return _vcs.empty( ); }
+    inline void clear( ) { _vcs.clear( ); }
+  };
+
+  VCSet vc;
 
   // these are only used by the event router
   bool head, tail;
@@ -49,8 +64,8 @@ public:
   static int OutStanding();
 private:
 
-  static stack<Credit *> _all;
-  static stack<Credit *> _free;
+  friend class ObjectPool<Credit>;
+  Credit * _next_free;
 
   Credit();
   ~Credit() {}
@@ -0,0 +1,710 @@
+// $Id$
+
+/*elevator_placement.cpp
+ *
+ * Elevator placement search for the 3D UniTorus (sim_type =
+ * elevator_placement)
+ *
+ * Candidate placements of placement_elevators elevator columns are scored
+ * with an analytic channel-load model instead of simulation. The traffic
+ * matrix of the configured traffic pattern is routed along the paths of
+ * dim_order_3d_elevator_unitorus, with every column assigned its nearest
+ * elevator (elevator_assignment = nearest). The predicted saturation rate
+ * is the injection rate at which the busiest channel, ejection port or
+ * injection port reaches its bandwidth.
+ *
+ * Traffic within a layer does not depend on the placement and is routed
+ * once. Traffic between layers is split into the path to the elevator
+ * (which only depends on the source column), the vertical hops and the
+ * path from the elevator to the destination, so that scoring a placement
+ * does not route every node pair again.
+ *
+ * The search adds elevators greedily, one at a time, and also scores all
+ * lattice placements. Simulated annealing (placement_search = anneal) then
+ * refines the greedy placement and the best lattices in placement_chains
+ * independent chains. Candidates and annealing chains are spread over
+ * placement_threads threads. The best
+ * placement_top placements are printed with their elevator_mapping_coords
+ * and written to placement_output_file; the best placement_confirm ones
+ * are checked with a saturation search.
+ *
+ */
+
+#include "booksim.hpp"
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+#include "elevator_placement.hpp"
+#include "sweep.hpp"
+#include "traffic.hpp"
+#include "random_utils.hpp"
+#include "thread_pool.hpp"
+#include "unitorus.hpp"
+
+// channels of a router in the model: X, Y and the two vertical directions
+// (a vertical torus only uses Z-up)
+enum { _X = 0, _Y, _ZUp, _ZDown, _Ports };
+
+struct _Score {
+  double max_load; // busiest channel per lane, flits per cycle at rate 1
+  double hops;     // channel hops per flit
+  double cost;     // search objective
+};
+
+class _LoadModel {
+  int _width;
+  int _height;
+  int _layers;
+  int _columns;
+  int _nodes;
+  bool _vertical_mesh;
+  double _lanes[3];
+
+  // flits per cycle at an injection rate of one packet per node and cycle,
+  // split by how the placement affects their path
+  vector<double> _base;     // traffic within a layer, per channel
+  vector<double> _out;      // per node: traffic to other layers
+  vector<double> _to;       // per source column and destination node
+  vector<double> _vertical; // per source column, source and destination layer
+  double _eject;            // busiest ejection port
+  double _inject;
+  double _flits;            // total traffic between different nodes
+
+  inline int _Node( int column, int layer ) const {
+    return layer * _columns + column;
+  }
+  inline int _Next( int column, int port ) const {
+    return ( port == _X ) ?
+      ( column / _width ) * _width + ( column + 1 ) % _width :
+      ( column + _width ) % _columns;
+  }
+  void _AddTraffic( int source, int dest, double flits );
+
+public:
+  _LoadModel( Configuration const & config );
+
+  int Columns( ) const { return _columns; }
+  int Width( ) const { return _width; }
+  int Height( ) const { return _height; }
+  int Layers( ) const { return _layers; }
+
+  // the busiest port outside of the network channels
+  double PortLoad( ) const { return max( _eject, _inject ); }
+
+  void Mapping( vector<int> const & elevators, vector<int> * mapped ) const;
+  void Evaluate( vector<int> const & elevators, _Score * score ) const;
+  void EvaluateMapping( vector<int> const & mapped, _Score * score ) const;
+};
+
+_LoadModel::_LoadModel( Configuration const & config )
+{
+  vector<int> const dims = config.GetIntArray( "dim_sizes" );
+  if ( ( config.GetStr( "topology" ) != "unitorus" ) || ( dims.size( ) != 3 ) ) {
+    cerr << "Error: elevator_placement needs a 3D unitorus topology." << endl;
+    exit(-1);
+  }
+  _width = dims[0];
+  _height = dims[1];
+  _layers = dims[2];
+  _columns = _width * _height;
+  _nodes = _columns * _layers;
+  _vertical_mesh = ( config.GetStr( "vertical_topology" ) == "mesh" );
+
+  vector<int> const bandwidth = config.GetIntArray( "dim_bandwidth" );
+  for ( int d = 0; d < 3; ++d ) {
+    _lanes[d] = ( ( d < (int)bandwidth.size( ) ) && ( bandwidth[d] > 0 ) ) ?
+      bandwidth[d] : 1;
+  }
+
+  // average packet size of the first class
+  double packet_flits = config.GetInt( "packet_size" );
+  string const packet_size_str = config.GetStr( "packet_size" );
+  if ( !packet_size_str.empty( ) ) {
+    vector<int> const sizes = tokenize_int( tokenize_str( packet_size_str )[0] );
+    packet_flits = 0.0;
+    for ( size_t i = 0; i < sizes.size( ); ++i ) {
+      packet_flits += sizes[i];
+    }
+    packet_flits /= sizes.size( );
+  }
+
+  _base.assign( _nodes * _Ports, 0.0 );
+  _out.assign( _nodes, 0.0 );
+  _to.assign( _columns * _nodes, 0.0 );
+  _vertical.assign( _columns * _layers * _layers, 0.0 );
+  _flits = 0.0;
+  _inject = packet_flits;
+
+  vector<double> eject( _nodes, 0.0 );
+  string const traffic = config.GetStrArray( "traffic" )[0];
+  TrafficPattern * const pattern = TrafficPattern::New( traffic, _nodes, &config );
+  if ( dynamic_cast<UniformRandomTrafficPattern *>( pattern ) ) {
+    // exact: every node, including the source, is equally likely, and
+    // packets to the source itself do not enter the network
+    double const flits = packet_flits / _nodes;
+    for ( int source = 0; source < _nodes; ++source ) {
+      for ( int dest = 0; dest < _nodes; ++dest ) {
+        if ( dest != source ) {
+          _AddTraffic( source, dest, flits );
+          eject[dest] += flits;
+        }
+      }
+    }
+  } else {
+    // permutations have a single destination per source, other random
+    // patterns are sampled
+    bool const fixed = dynamic_cast<PermutationTrafficPattern *>( pattern ) ||
+      dynamic_cast<RandomPermutationTrafficPattern *>( pattern );
+    int const samples = fixed ? 1 : config.GetInt( "placement_samples" );
+    if ( samples < 1 ) {
+      cerr << "Error: placement_samples must be positive." << endl;
+      exit(-1);
+    }
+    if ( config.GetStr( "seed" ) == "time" ) {
+      RandomSeed( int( time( NULL ) ) );
+    } else {
+      RandomSeed( config.GetInt( "seed" ) );
+    }
+    double const flits = packet_flits / samples;
+    for ( int source = 0; source < _nodes; ++source ) {
+      for ( int s = 0; s < samples; ++s ) {
+        int const dest = pattern->dest( source );
+        if ( ( dest >= 0 ) && ( dest != source ) ) {
+          _AddTraffic( source, dest, flits );
+          eject[dest] += flits;
+        }
+      }
+    }
+  }
+  delete pattern;
+
+  _eject = *max_element( eject.begin( ), eject.end( ) );
+}
+
+void _LoadModel::_AddTraffic( int source, int dest, double flits )
+{
+  int const source_column = source % _columns;
+  int const source_layer = source / _columns;
+  int const dest_column = dest % _columns;
+  int const dest_layer = dest / _columns;
+  _flits += flits;
+
+  if ( source_layer != dest_layer ) {
+    _out[source] += flits;
+    _to[source_column * _nodes + dest] += flits;
+    _vertical[( source_column * _layers + source_layer ) * _layers + dest_layer] += flits;
+    return;
+  }
+
+  // X, then Y within the layer
+  int cur = source_column;
+  while ( cur != dest_column ) {
+    int const port = ( ( cur % _width ) != ( dest_column % _width ) ) ? _X : _Y;
+    _base[_Node( cur, source_layer ) * _Ports + port] += flits;
+    cur = _Next( cur, port );
+  }
+}
+
+void _LoadModel::Mapping( vector<int> const & elevators, vector<int> * mapped ) const
+{
+  vector<vector<int> > coords( elevators.size( ) );
+  for ( size_t i = 0; i < elevators.size( ); ++i ) {
+    coords[i] = { elevators[i] % _width, elevators[i] / _width };
+  }
+  mapped->resize( _columns );
+  for ( int c = 0; c < _columns; ++c ) {
+    int const e = UniTorus::NearestElevator( c % _width, c / _width,
+                                             _width, _height, coords );
+    ( *mapped )[c] = elevators[e];
+  }
+}
+
+void _LoadModel::Evaluate( vector<int> const & elevators, _Score * score ) const
+{
+  vector<int> mapped;
+  Mapping( elevators, &mapped );
+  EvaluateMapping( mapped, score );
+}
+
+void _LoadModel::EvaluateMapping( vector<int> const & mapped, _Score * score ) const
+{
+  // the elevators are the columns mapped to themselves
+  vector<int> elevators;
+  vector<int> index( _columns, -1 );
+  for ( int c = 0; c < _columns; ++c ) {
+    if ( mapped[c] == c ) {
+      index[c] = elevators.size( );
+      elevators.push_back( c );
+    }
+  }
+  int const count = elevators.size( );
+
+  vector<double> load( _base );
+  vector<double> into( count * _nodes, 0.0 );
+  vector<double> vertical( count * _layers * _layers, 0.0 );
+
+  // to the elevator: dim_order_3d_elevator_unitorus follows the mapping of
+  // the router it is at, so the path may end at a nearer elevator than the
+  // source column's own
+  for ( int c = 0; c < _columns; ++c ) {
+    int cur = c;
+    for ( int hops = 0; mapped[cur] != cur; ++hops ) {
+      if ( hops >= _width + _height ) {
+        cerr << "Error: The elevator mapping of column " << c
+             << " does not lead to an elevator." << endl;
+        exit(-1);
+      }
+      int const target = mapped[cur];
+      int const port = ( ( cur % _width ) != ( target % _width ) ) ? _X : _Y;
+      for ( int z = 0; z < _layers; ++z ) {
+        load[_Node( cur, z ) * _Ports + port] += _out[_Node( c, z )];
+      }
+      cur = _Next( cur, port );
+    }
+    int const e = index[cur];
+    double const * const to = &_to[c * _nodes];
+    double * const e_into = &into[e * _nodes];
+    for ( int d = 0; d < _nodes; ++d ) {
+      e_into[d] += to[d];
+    }
+    for ( int i = 0; i < _layers * _layers; ++i ) {
+      vertical[e * _layers * _layers + i] += _vertical[c * _layers * _layers + i];
+    }
+  }
+
+  vector<double> column_flits( _width );
+  for ( int e = 0; e < count; ++e ) {
+    int const column = elevators[e];
+
+    // vertical hops
+    for ( int zs = 0; zs < _layers; ++zs ) {
+      for ( int zd = 0; zd < _layers; ++zd ) {
+        double const flits = vertical[( e * _layers + zs ) * _layers + zd];
+        if ( ( zs == zd ) || ( flits == 0.0 ) ) {
+          continue;
+        }
+        if ( _vertical_mesh ) {
+          int const step = ( zd > zs ) ? 1 : -1;
+          int const port = ( zd > zs ) ? _ZUp : _ZDown;
+          for ( int z = zs; z != zd; z += step ) {
+            load[_Node( column, z ) * _Ports + port] += flits;
+          }
+        } else {
+          for ( int z = zs; z != zd; z = ( z + 1 ) % _layers ) {
+            load[_Node( column, z ) * _Ports + _ZUp] += flits;
+          }
+        }
+      }
+    }
+
+    // from the elevator, X then Y in the destination layer: the channel s
+    // hops from the elevator carries everything at least s + 1 hops away
+    int const ex = column % _width;
+    int const ey = column / _width;
+    for ( int zd = 0; zd < _layers; ++zd ) {
+      double const * const flits = &into[e * _nodes + _Node( 0, zd )];
+      for ( int x = 0; x < _width; ++x ) {
+        column_flits[x] = 0.0;
+        for ( int y = 0; y < _height; ++y ) {
+          column_flits[x] += flits[y * _width + x];
+        }
+      }
+      double sum = 0.0;
+      for ( int s = _width - 1; s >= 1; --s ) {
+        sum += column_flits[( ex + s ) % _width];
+        int const x = ( ex + s - 1 ) % _width;
+        load[_Node( ey * _width + x, zd ) * _Ports + _X] += sum;
+      }
+      for ( int x = 0; x < _width; ++x ) {
+        sum = 0.0;
+        for ( int s = _height - 1; s >= 1; --s ) {
+          sum += flits[( ( ey + s ) % _height ) * _width + x];
+          int const y = ( ey + s - 1 ) % _height;
+          load[_Node( y * _width + x, zd ) * _Ports + _Y] += sum;
+        }
+      }
+    }
+  }
+
+  double max_load = 0.0;
+  double total = 0.0;
+  double total_lanes = 0.0;
+  for ( int n = 0; n < _nodes; ++n ) {
+    for ( int p = 0; p < _Ports; ++p ) {
+      double const lanes = _lanes[min( p, 2 )];
+      max_load = max( max_load, load[n * _Ports + p] / lanes );
+      total += load[n * _Ports + p];
+      total_lanes += lanes;
+    }
+  }
+  score->max_load = max_load;
+  score->hops = ( _flits > 0.0 ) ? total / _flits : 0.0;
+  // fewer hops (a lower average load) break ties between placements with
+  // the same busiest channel
+  score->cost = max_load + 0.1 * total / total_lanes;
+}
+
+// best placements found, by cost
+typedef map<vector<int>, _Score> _Placements;
+
+static void _Remember( _Placements & found, vector<int> placement,
+                       _Score const & score, int top )
+{
+  sort( placement.begin( ), placement.end( ) );
+  if ( found.count( placement ) ) {
+    return;
+  }
+  if ( (int)found.size( ) >= top ) {
+    _Placements::iterator worst = found.begin( );
+    for ( _Placements::iterator iter = found.begin( ); iter != found.end( ); ++iter ) {
+      if ( iter->second.cost > worst->second.cost ) {
+        worst = iter;
+      }
+    }
+    if ( worst->second.cost <= score.cost ) {
+      return;
+    }
+    found.erase( worst );
+  }
+  found[placement] = score;
+}
+
+struct _ScoreJob {
+  _LoadModel const * model;
+  vector<vector<int> > placements;
+  vector<_Score> scores;
+};
+
+static void _ScorePart( void * arg, int part, int parts )
+{
+  _ScoreJob * const job = (_ScoreJob *)arg;
+  for ( size_t i = part; i < job->placements.size( ); i += parts ) {
+    job->model->Evaluate( job->placements[i], &job->scores[i] );
+  }
+}
+
+static void _ScoreAll( ThreadPool & pool, _ScoreJob & job )
+{
+  job.scores.assign( job.placements.size( ), _Score( ) );
+  pool.Run( &_ScorePart, &job );
+}
+
+struct _AnnealJob {
+  _LoadModel const * model;
+  vector<vector<int> > starts; // chains start from these in turn
+  int iterations;
+  int chains;
+  int seed;
+  int top;
+  vector<_Placements> found; // per chain
+  vector<long> evaluations;  // per chain
+};
+
+static void _AnnealChain( _AnnealJob * job, int chain )
+{
+  _LoadModel const & model = *job->model;
+  int const columns = model.Columns( );
+  int const width = model.Width( );
+  int const height = model.Height( );
+  mt19937 rng( job->seed + chain );
+
+  vector<int> placement( job->starts[chain % job->starts.size( )] );
+  vector<bool> used( columns, false );
+  for ( size_t i = 0; i < placement.size( ); ++i ) {
+    used[placement[i]] = true;
+  }
+  _Score score;
+  model.Evaluate( placement, &score );
+  _Placements & found = job->found[chain];
+  _Remember( found, placement, score, job->top );
+
+  // geometric cooling from a few percent of the starting cost
+  double temperature = 0.02 * score.cost;
+  double const cooling = pow( 1e-3, 1.0 / max( job->iterations, 1 ) );
+  uniform_real_distribution<double> uniform( 0.0, 1.0 );
+  for ( int it = 0; it < job->iterations; ++it, temperature *= cooling ) {
+    // move one elevator, half of the time to a nearby column
+    int const i = rng( ) % placement.size( );
+    int const old = placement[i];
+    int column;
+    if ( rng( ) % 2 ) {
+      int const x = ( old % width + (int)( rng( ) % 5 ) - 2 + width ) % width;
+      int const y = ( old / width + (int)( rng( ) % 5 ) - 2 + height ) % height;
+      column = y * width + x;
+    } else {
+      column = rng( ) % columns;
+    }
+    if ( used[column] ) {
+      continue;
+    }
+    placement[i] = column;
+    _Score moved;
+    model.Evaluate( placement, &moved );
+    ++job->evaluations[chain];
+    double const delta = moved.cost - score.cost;
+    if ( ( delta <= 0.0 ) || ( uniform( rng ) < exp( -delta / temperature ) ) ) {
+      used[old] = false;
+      used[column] = true;
+      score = moved;
+      _Remember( found, placement, score, job->top );
+    } else {
+      placement[i] = old;
+    }
+  }
+}
+
+static void _AnnealPart( void * arg, int part, int parts )
+{
+  _AnnealJob * const job = (_AnnealJob *)arg;
+  for ( int chain = part; chain < job->chains; chain += parts ) {
+    _AnnealChain( job, chain );
+  }
+}
+
+bool ElevatorPlacementEnabled( Configuration const & config )
+{
+  return config.GetStr( "sim_type" ) == "elevator_placement";
+}
+
+bool RunElevatorPlacement( BookSimConfig & config )
+{
+  int const count = config.GetInt( "placement_elevators" );
+  string const search = config.GetStr( "placement_search" );
+  int const iterations = config.GetInt( "placement_iterations" );
+  int const chains = config.GetInt( "placement_chains" );
+  int const top = config.GetInt( "placement_top" );
+  int const confirm = config.GetInt( "placement_confirm" );
+  int threads = config.GetInt( "placement_threads" );
+  if ( threads <= 0 ) {
+    threads = max( (int)thread::hardware_concurrency( ), 1 );
+  }
+  if ( ( search != "greedy" ) && ( search != "anneal" ) ) {
+    cerr << "Error: Unknown placement_search " << search
+         << " (expected greedy or anneal)." << endl;
+    exit(-1);
+  }
+  if ( ( iterations < 0 ) || ( chains < 1 ) || ( top < 1 ) || ( confirm < 0 ) ) {
+    cerr << "Error: Invalid elevator placement parameters." << endl;
+    exit(-1);
+  }
+
+  time_t const start_time = time( NULL );
+  _LoadModel const model( config );
+  int const columns = model.Columns( );
+  if ( ( count < 1 ) || ( count > columns ) ) {
+    cerr << "Error: placement_elevators must be between 1 and " << columns
+         << "." << endl;
+    exit(-1);
+  }
+
+  // the configured mapping, for comparison, built as UniTorus does; it is
+  // checked before the search so that a literal elevator_mapping_coords
+  // for another size does not throw the results away
+  vector<int> configured;
+  vector<vector<int> > assigned;
+  if ( UniTorus::AssignElevators( config, config.GetIntArray( "dim_sizes" ),
+                                  &assigned ) ) {
+    for ( int c = 0; c < columns; ++c ) {
+      configured.push_back( assigned[c][1] * model.Width( ) + assigned[c][0] );
+    }
+  } else if ( !config.GetStr( "elevator_mapping_coords" ).empty( ) ) {
+    vector<int> const coords = config.GetIntArray( "elevator_mapping_coords" );
+    if ( (int)coords.size( ) == 2 * columns ) {
+      for ( int c = 0; c < columns; ++c ) {
+        configured.push_back( coords[2 * c + 1] * model.Width( ) + coords[2 * c] );
+      }
+    } else {
+      cout << "WARNING: elevator_mapping_coords has " << coords.size( )
+           << " coordinates instead of " << 2 * columns
+           << ", not comparing with the configured mapping." << endl;
+    }
+  }
+
+  ThreadPool pool( threads );
+  long evaluations = 0;
+
+  // greedy: add the elevator that lowers the cost most; ties go to the
+  // lower column
+  _Placements found;
+  _ScoreJob job;
+  job.model = &model;
+  vector<int> greedy;
+  _Score greedy_score;
+  for ( int k = 0; k < count; ++k ) {
+    job.placements.clear( );
+    for ( int c = 0; c < columns; ++c ) {
+      if ( find( greedy.begin( ), greedy.end( ), c ) == greedy.end( ) ) {
+        job.placements.push_back( greedy );
+        job.placements.back( ).push_back( c );
+      }
+    }
+    _ScoreAll( pool, job );
+    evaluations += job.placements.size( );
+    int best = 0;
+    for ( size_t i = 1; i < job.placements.size( ); ++i ) {
+      if ( job.scores[i].cost < job.scores[best].cost ) {
+        best = i;
+      }
+    }
+    greedy = job.placements[best];
+    greedy_score = job.scores[best];
+  }
+  _Remember( found, greedy, greedy_score, top );
+
+  // lattices: elevator i at column i * step (row-major), which includes
+  // the diagonals. A single elevator move rarely improves on a greedy
+  // placement whose busiest channels are spread over several elevators,
+  // so these are starting points of their own.
+  job.placements.clear( );
+  for ( int step = 1; step < columns; ++step ) {
+    vector<int> lattice( count );
+    vector<bool> used( columns, false );
+    bool distinct = true;
+    for ( int i = 0; distinct && ( i < count ); ++i ) {
+      lattice[i] = (int)( ( (long)i * step ) % columns );
+      distinct = !used[lattice[i]];
+      used[lattice[i]] = true;
+    }
+    if ( distinct ) {
+      job.placements.push_back( lattice );
+    }
+  }
+  _ScoreAll( pool, job );
+  evaluations += job.placements.size( );
+  vector<pair<double, int> > lattices;
+  for ( size_t i = 0; i < job.placements.size( ); ++i ) {
+    _Remember( found, job.placements[i], job.scores[i], top );
+    lattices.push_back( make_pair( job.scores[i].cost, (int)i ) );
+  }
+  sort( lattices.begin( ), lattices.end( ) );
+
+  if ( search == "anneal" ) {
+    _AnnealJob anneal;
+    anneal.model = &model;
+    // the greedy placement and the best lattices
+    anneal.starts.push_back( greedy );
+    for ( size_t i = 0; ( i < lattices.size( ) ) && ( (int)i < chains - 1 ); ++i ) {
+      anneal.starts.push_back( job.placements[lattices[i].second] );
+    }
+    anneal.iterations = iterations;
+    anneal.chains = chains;
+    anneal.seed = ( config.GetStr( "seed" ) == "time" ) ? int( time( NULL ) ) :
+      config.GetInt( "seed" );
+    anneal.top = top;
+    anneal.found.resize( chains );
+    anneal.evaluations.assign( chains, 0 );
+    pool.Run( &_AnnealPart, &anneal );
+    for ( int c = 0; c < chains; ++c ) {
+      evaluations += anneal.evaluations[c];
+      for ( _Placements::const_iterator iter = anneal.found[c].begin( );
+            iter != anneal.found[c].end( ); ++iter ) {
+        _Remember( found, iter->first, iter->second, top );
+      }
+    }
+  }
+
+  vector<pair<double, vector<int> > > ranked;
+  for ( _Placements::const_iterator iter = found.begin( ); iter != found.end( ); ++iter ) {
+    ranked.push_back( make_pair( iter->second.cost, iter->first ) );
+  }
+  sort( ranked.begin( ), ranked.end( ) );
+
+  int const width = model.Width( );
+  cout << "Elevator placement: " << count << " elevators, " << width << "x"
+       << model.Height( ) << "x" << model.Layers( ) << ", traffic "
+       << config.GetStrArray( "traffic" )[0] << " (" << evaluations
+       << " placements scored in " << difftime( time( NULL ), start_time )
+       << " s)" << endl;
+
+  if ( !configured.empty( ) ) {
+    _Score score;
+    model.EvaluateMapping( configured, &score );
+    cout << "  configured mapping: predicted saturation "
+         << 1.0 / max( score.max_load, model.PortLoad( ) )
+         << ", max channel load " << score.max_load
+         << ", hops " << score.hops << endl;
+  }
+
+  vector<string> elevator_strs( ranked.size( ) );
+  vector<string> mapping_strs( ranked.size( ) );
+  vector<_Score> scores( ranked.size( ) );
+  for ( size_t r = 0; r < ranked.size( ); ++r ) {
+    vector<int> const & placement = ranked[r].second;
+    scores[r] = found[placement];
+    ostringstream elevator_str;
+    for ( size_t i = 0; i < placement.size( ); ++i ) {
+      elevator_str << ( i ? ";" : "" ) << placement[i] % width << ","
+                   << placement[i] / width;
+    }
+    elevator_strs[r] = elevator_str.str( );
+    vector<int> mapped;
+    model.Mapping( placement, &mapped );
+    ostringstream mapping_str;
+    mapping_str << "{";
+    for ( int c = 0; c < columns; ++c ) {
+      mapping_str << ( c ? "," : "" ) << mapped[c] % width << "," << mapped[c] / width;
+    }
+    mapping_str << "}";
+    mapping_strs[r] = mapping_str.str( );
+  }
+
+  // the predicted saturation rate is bounded by the network channels and
+  // by the injection and ejection ports
+  vector<double> predicted( ranked.size( ) );
+  for ( size_t r = 0; r < ranked.size( ); ++r ) {
+    predicted[r] = 1.0 / max( scores[r].max_load, model.PortLoad( ) );
+  }
+
+  // confirm with real simulations, with the mapping of each placement
+  vector<double> confirmed( ranked.size( ), -1.0 );
+  for ( size_t r = 0; ( r < ranked.size( ) ) && ( (int)r < confirm ); ++r ) {
+    cout << "Confirming placement " << r + 1 << ": " << elevator_strs[r] << endl;
+    BookSimConfig probe_config( config );
+    probe_config.Assign( "elevator_file", string( "" ) );
+    probe_config.Assign( "elevator_assignment", string( "nearest" ) );
+    probe_config.Assign( "elevator_mapping_coords", mapping_strs[r] );
+    confirmed[r] = FindSaturationRate( probe_config );
+  }
+
+  for ( size_t r = 0; r < ranked.size( ); ++r ) {
+    cout << "  " << r + 1 << ": predicted saturation " << predicted[r]
+         << ", max channel load " << scores[r].max_load
+         << ", hops " << scores[r].hops;
+    if ( confirmed[r] >= 0.0 ) {
+      cout << ", simulated saturation " << confirmed[r];
+    }
+    cout << endl << "     elevators " << elevator_strs[r] << endl
+         << "     elevator_mapping_coords = " << mapping_strs[r] << ";" << endl;
+  }
+
+  string const out_file = config.GetStr( "placement_output_file" );
+  if ( !out_file.empty( ) ) {
+    ofstream out( out_file.c_str( ) );
+    if ( !out ) {
+      cerr << "Error: Could not open placement_output_file " << out_file << endl;
+      exit(-1);
+    }
+    out << "Rank,PredictedSaturation,MaxChannelLoad,Hops,SimulatedSaturation,"
+        << "Elevators,Mapping" << endl;
+    for ( size_t r = 0; r < ranked.size( ); ++r ) {
+      out << r + 1 << ',' << predicted[r] << ',' << scores[r].max_load << ','
+          << scores[r].hops << ',';
+      if ( confirmed[r] >= 0.0 ) {
+        out << confirmed[r];
+      }
+      out << ",\"" << elevator_strs[r] << "\",\"" << mapping_strs[r] << "\"" << endl;
+    }
+  }
+
+  return true;
+}
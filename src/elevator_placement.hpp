@@ -0,0 +1,13 @@
+// $Id$
+
+#ifndef _ELEVATOR_PLACEMENT_HPP_
+#define _ELEVATOR_PLACEMENT_HPP_
+
+#include "booksim_config.hpp"
+
+// sim_type = elevator_placement: search the placement of placement_elevators
+// elevator columns of a 3D UniTorus with an analytic channel-load model
+bool ElevatorPlacementEnabled( Configuration const & config );
+bool RunElevatorPlacement( BookSimConfig & config );
+
+#endif
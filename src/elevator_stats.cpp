@@ -0,0 +1,210 @@
+// $Id$
+
+/*elevator_stats.cpp
+ *
+ *Per-elevator traffic, vertical wait and detour statistics
+ *
+ */
+
+#include <sstream>
+#include <iomanip>
+
+#include "booksim.hpp"
+#include "elevator_stats.hpp"
+#include "flit.hpp"
+#include "globals.hpp"
+
+ElevatorStats::ElevatorStats( Module * parent, const string & name,
+                              vector<int> const & dim_sizes )
+  : Module( parent, name )
+{
+  if ( dim_sizes.size( ) < 3 ) {
+    Error( "Elevator statistics need a network with at least three dimensions." );
+  }
+  _dim_x = dim_sizes[0];
+  _dim_y = dim_sizes[1];
+  _nodes = 1;
+  for ( size_t d = 0; d < dim_sizes.size( ); ++d ) {
+    _nodes *= dim_sizes[d];
+  }
+
+  _period_served.resize( _nodes, 0 );
+  _served.resize( _nodes, 0 );
+  _period_wait.resize( _nodes );
+  _period_extra.resize( _nodes );
+  _wait.resize( _nodes );
+  _extra.resize( _nodes );
+  for ( int n = 0; n < _nodes; ++n ) {
+    ostringstream tmp_name;
+    tmp_name << "period_wait_" << n;
+    _period_wait[n] = new Stats( this, tmp_name.str( ), 1.0, 100 );
+    tmp_name.str( "" );
+    tmp_name << "period_extra_" << n;
+    _period_extra[n] = new Stats( this, tmp_name.str( ), 1.0, _dim_x + _dim_y );
+    tmp_name.str( "" );
+    tmp_name << "wait_" << n;
+    _wait[n] = new Stats( this, tmp_name.str( ), 1.0, 100 );
+    tmp_name.str( "" );
+    tmp_name << "extra_" << n;
+    _extra[n] = new Stats( this, tmp_name.str( ), 1.0, _dim_x + _dim_y );
+  }
+}
+
+ElevatorStats::~ElevatorStats( )
+{
+  for ( int n = 0; n < _nodes; ++n ) {
+    delete _period_wait[n];
+    delete _period_extra[n];
+    delete _wait[n];
+    delete _extra[n];
+  }
+}
+
+int ElevatorStats::_Column( int node ) const
+{
+  return node % ( _dim_x * _dim_y );
+}
+
+// hops on the unidirectional X and Y rings between the columns of two nodes
+int ElevatorStats::_PlanarHops( int src, int dest ) const
+{
+  int const sx = src % _dim_x;
+  int const sy = ( src / _dim_x ) % _dim_y;
+  int const dx = dest % _dim_x;
+  int const dy = ( dest / _dim_x ) % _dim_y;
+  return ( dx - sx + _dim_x ) % _dim_x + ( dy - sy + _dim_y ) % _dim_y;
+}
+
+void ElevatorStats::VerticalDeparture( int node, Flit const * f )
+{
+  _period_wait[node]->AddSample( GetSimTime( ) - f->rtime );
+
+  int const layer_size = _dim_x * _dim_y;
+  if ( ( node / layer_size ) == ( f->src / layer_size ) ) {
+    ++_period_served[node];
+    int const via = _PlanarHops( f->src, node ) + _PlanarHops( node, f->dest );
+    _period_extra[node]->AddSample( via - _PlanarHops( f->src, f->dest ) );
+  }
+}
+
+void ElevatorStats::EndPeriod( bool counted )
+{
+  for ( int n = 0; n < _nodes; ++n ) {
+    if ( counted ) {
+      _served[n] += _period_served[n];
+      _wait[n]->Merge( *_period_wait[n] );
+      _extra[n]->Merge( *_period_extra[n] );
+    }
+    _period_served[n] = 0;
+    _period_wait[n]->Clear( );
+    _period_extra[n]->Clear( );
+  }
+}
+
+void ElevatorStats::Clear( )
+{
+  EndPeriod( false );
+  for ( int n = 0; n < _nodes; ++n ) {
+    _served[n] = 0;
+    _wait[n]->Clear( );
+    _extra[n]->Clear( );
+  }
+}
+
+void ElevatorStats::_Sum( int column, vector<int> const & served,
+                          vector<Stats *> const & wait,
+                          vector<Stats *> const & extra,
+                          int * total_served, Stats * total_wait,
+                          Stats * total_extra ) const
+{
+  *total_served = 0;
+  total_wait->Clear( );
+  total_extra->Clear( );
+  for ( int n = 0; n < _nodes; ++n ) {
+    if ( ( column < 0 ) || ( _Column( n ) == column ) ) {
+      *total_served += served[n];
+      total_wait->Merge( *wait[n] );
+      total_extra->Merge( *extra[n] );
+    }
+  }
+}
+
+void ElevatorStats::WriteHeader( ostream & os, string const & prefix )
+{
+  os << prefix << "x,y,packets,wait_avg,wait_p50,wait_p99,wait_max,"
+     << "extra_hops_avg,extra_hops_max" << endl;
+}
+
+void ElevatorStats::_WriteRows( ostream & os, string const & prefix,
+                                vector<int> const & served,
+                                vector<Stats *> const & wait,
+                                vector<Stats *> const & extra ) const
+{
+  Stats column_wait( NULL, "column_wait", 1.0, 100 );
+  Stats column_extra( NULL, "column_extra", 1.0, _dim_x + _dim_y );
+  for ( int c = 0; c < _dim_x * _dim_y; ++c ) {
+    int column_served;
+    _Sum( c, served, wait, extra, &column_served, &column_wait, &column_extra );
+    if ( column_wait.NumSamples( ) == 0 ) {
+      continue;
+    }
+    os << prefix << ( c % _dim_x ) << ',' << ( c / _dim_x ) << ','
+       << column_served << ','
+       << column_wait.Average( ) << ','
+       << column_wait.Percentile( 0.5 ) << ','
+       << column_wait.Percentile( 0.99 ) << ','
+       << column_wait.Max( ) << ',';
+    if ( column_extra.NumSamples( ) > 0 ) {
+      os << column_extra.Average( ) << ',' << column_extra.Max( );
+    } else {
+      os << ',';
+    }
+    os << endl;
+  }
+}
+
+void ElevatorStats::WritePeriod( ostream & os, string const & prefix ) const
+{
+  _WriteRows( os, prefix, _period_served, _period_wait, _period_extra );
+}
+
+void ElevatorStats::WriteTotals( ostream & os, string const & prefix ) const
+{
+  _WriteRows( os, prefix, _served, _wait, _extra );
+}
+
+void ElevatorStats::Display( ostream & os ) const
+{
+  Stats total_wait( NULL, "total_wait", 1.0, 100 );
+  Stats total_extra( NULL, "total_extra", 1.0, _dim_x + _dim_y );
+  int total_served;
+  _Sum( -1, _served, _wait, _extra, &total_served, &total_wait, &total_extra );
+
+  os << "Elevator statistics (" << FullName( ) << "):" << endl;
+  os << "  x,y: packets, vertical wait avg / p99 / max, extra planar hops avg / max" << endl;
+  Stats column_wait( NULL, "column_wait", 1.0, 100 );
+  Stats column_extra( NULL, "column_extra", 1.0, _dim_x + _dim_y );
+  for ( int c = 0; c < _dim_x * _dim_y; ++c ) {
+    int column_served;
+    _Sum( c, _served, _wait, _extra, &column_served, &column_wait, &column_extra );
+    if ( column_wait.NumSamples( ) == 0 ) {
+      continue;
+    }
+    os << "  " << ( c % _dim_x ) << "," << ( c / _dim_x ) << ": "
+       << column_served << " ("
+       << setprecision( 3 ) << ( total_served > 0 ? 100.0 * column_served / total_served : 0.0 )
+       << "%), " << setprecision( 6 )
+       << column_wait.Average( ) << " / " << column_wait.Percentile( 0.99 )
+       << " / " << column_wait.Max( ) << ", ";
+    if ( column_extra.NumSamples( ) > 0 ) {
+      os << column_extra.Average( ) << " / " << column_extra.Max( );
+    } else {
+      os << "- / -";
+    }
+    os << endl;
+  }
+  os << "  all: " << total_served << ", "
+     << total_wait.Average( ) << " / " << total_wait.Percentile( 0.99 )
+     << " / " << total_wait.Max( ) << ", "
+     << total_extra.Average( ) << " / " << total_extra.Max( ) << endl;
+}
@@ -0,0 +1,77 @@
+// $Id$
+
+#ifndef _ELEVATOR_STATS_HPP_
+#define _ELEVATOR_STATS_HPP_
+
+#include <vector>
+#include <iostream>
+
+#include "module.hpp"
+#include "stats.hpp"
+
+class Flit;
+
+// Elevator usage of a 3D UniTorus (elevator_stats). The network reports
+// every head flit that leaves a router on a vertical channel; flits are
+// counted per router and summed per elevator column (x, y) when reported.
+//
+//  - packets served: packets that board the elevator, i.e. leave their
+//    source layer through it
+//  - vertical wait: cycles from the head flit's arrival at the router to
+//    its departure on the vertical port, including the router pipeline
+//  - extra planar hops: hops via the boarding column minus the hops of the
+//    minimal planar path, both on the unidirectional X/Y rings
+//
+// Each sample period is kept separately and added to the run totals by
+// EndPeriod; the drain at the end of a run counts as a last period.
+class ElevatorStats : public Module {
+
+  int _dim_x;
+  int _dim_y;
+  int _nodes;
+
+  vector<int> _period_served;
+  vector<Stats *> _period_wait;
+  vector<Stats *> _period_extra;
+
+  vector<int> _served;
+  vector<Stats *> _wait;
+  vector<Stats *> _extra;
+
+  int _PlanarHops( int src, int dest ) const;
+  int _Column( int node ) const;
+
+  // column totals of per-router statistics; all columns if column < 0
+  void _Sum( int column, vector<int> const & served,
+             vector<Stats *> const & wait, vector<Stats *> const & extra,
+             int * total_served, Stats * total_wait,
+             Stats * total_extra ) const;
+
+  void _WriteRows( ostream & os, string const & prefix,
+                   vector<int> const & served,
+                   vector<Stats *> const & wait,
+                   vector<Stats *> const & extra ) const;
+
+public:
+  ElevatorStats( Module * parent, const string & name,
+                 vector<int> const & dim_sizes );
+  ~ElevatorStats( );
+
+  // head flit f leaves router node on a vertical channel
+  void VerticalDeparture( int node, Flit const * f );
+
+  // add the current period to the totals (if counted) and clear it
+  void EndPeriod( bool counted );
+  // clear the current period and the totals, for the next simulation
+  void Clear( );
+
+  static void WriteHeader( ostream & os, string const & prefix = "" );
+  // one line per column with vertical traffic in the current period
+  void WritePeriod( ostream & os, string const & prefix = "" ) const;
+  // the same for the run totals
+  void WriteTotals( ostream & os, string const & prefix = "" ) const;
+
+  void Display( ostream & os = cout ) const;
+};
+
+#endif
@@ -0,0 +1,159 @@
+// $Id$
+
+/*event_trace.cpp
+ *
+ *Buffered binary trace of flit events
+ *
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "booksim.hpp"
+#include "event_trace.hpp"
+
+bool EventTrace::_enabled = false;
+unsigned EventTrace::_event_mask = 0;
+int EventTrace::_sample = 1;
+int EventTrace::_start = 0;
+int EventTrace::_end = -1;
+size_t EventTrace::_block = 4096;
+bool EventTrace::_compress = true;
+
+FILE * EventTrace::_out = NULL;
+mutex EventTrace::_lock;
+vector<EventTrace::_Buffer *> EventTrace::_buffers;
+thread_local EventTrace::_Buffer * EventTrace::_buffer = NULL;
+
+static char const * const _event_names[] = {
+  "inject", "route", "vc_alloc", "sw_alloc", "traverse", "eject"
+};
+
+void EventTrace::Open( Configuration const & config )
+{
+  string const filename = config.GetStr( "trace_out" );
+  if ( filename.empty( ) ) {
+    return;
+  }
+
+  _event_mask = 0;
+  vector<string> const events = config.GetStrArray( "trace_events" );
+  if ( events.empty( ) ) {
+    _event_mask = ( 1u << num_types ) - 1;
+  }
+  for ( size_t i = 0; i < events.size( ); ++i ) {
+    int type = 0;
+    while ( ( type < num_types ) && ( events[i] != _event_names[type] ) ) {
+      ++type;
+    }
+    if ( type == num_types ) {
+      cerr << "Error: Unknown trace event: " << events[i] << endl;
+      exit(-1);
+    }
+    _event_mask |= 1u << type;
+  }
+
+  _sample = config.GetInt( "trace_sample" );
+  _start = config.GetInt( "trace_start" );
+  _end = config.GetInt( "trace_end" );
+  _compress = ( config.GetInt( "trace_compress" ) > 0 );
+  int const block = config.GetInt( "trace_block" );
+  if ( block <= 0 ) {
+    cerr << "Error: trace_block must be positive." << endl;
+    exit(-1);
+  }
+  _block = block;
+
+  _out = fopen( filename.c_str( ), "wb" );
+  if ( !_out ) {
+    cerr << "Error: Could not open trace file " << filename << endl;
+    exit(-1);
+  }
+  fwrite( "BSEVTRC1", 1, 8, _out );
+  fflush( _out );
+  _enabled = true;
+}
+
+void EventTrace::Close( )
+{
+  if ( !_enabled ) {
+    return;
+  }
+  for ( size_t i = 0; i < _buffers.size( ); ++i ) {
+    _Flush( _buffers[i] );
+  }
+  lock_guard<mutex> lock( _lock );
+  for ( size_t i = 0; i < _buffers.size( ); ++i ) {
+    delete _buffers[i];
+  }
+  _buffers.clear( );
+  _buffer = NULL;
+  fclose( _out );
+  _out = NULL;
+  _enabled = false;
+}
+
+EventTrace::_Buffer * EventTrace::_NewBuffer( )
+{
+  _Buffer * const buffer = new _Buffer;
+  buffer->records.reserve( _block );
+  lock_guard<mutex> lock( _lock );
+  _buffers.push_back( buffer );
+  _buffer = buffer;
+  return buffer;
+}
+
+static inline void _PutVarint( vector<unsigned char> & out, int value )
+{
+  // zigzag, so small negative differences stay short
+  unsigned v = ( (unsigned)value << 1 ) ^ (unsigned)( value >> 31 );
+  while ( v >= 0x80 ) {
+    out.push_back( (unsigned char)( v | 0x80 ) );
+    v >>= 7;
+  }
+  out.push_back( (unsigned char)v );
+}
+
+void EventTrace::_Flush( _Buffer * buffer )
+{
+  vector<Record> & records = buffer->records;
+  if ( records.empty( ) ) {
+    return;
+  }
+
+  vector<unsigned char> payload;
+  unsigned char encoding = 0;
+  if ( _compress ) {
+    encoding = 1;
+    payload.reserve( records.size( ) * 8 );
+    Record prev;
+    memset( &prev, 0, sizeof( prev ) );
+    for ( size_t i = 0; i < records.size( ); ++i ) {
+      Record const & r = records[i];
+      _PutVarint( payload, r.time - prev.time );
+      _PutVarint( payload, r.id - prev.id );
+      _PutVarint( payload, r.pid - prev.pid );
+      _PutVarint( payload, r.node );
+      _PutVarint( payload, r.port );
+      _PutVarint( payload, r.vc );
+      payload.push_back( r.type );
+      payload.push_back( r.flags );
+      prev = r;
+    }
+  } else {
+    payload.resize( records.size( ) * sizeof( Record ) );
+    memcpy( &payload[0], &records[0], payload.size( ) );
+  }
+
+  unsigned const count = records.size( );
+  unsigned const size = payload.size( );
+  {
+    lock_guard<mutex> lock( _lock );
+    fwrite( &encoding, 1, 1, _out );
+    fwrite( &count, sizeof( count ), 1, _out );
+    fwrite( &size, sizeof( size ), 1, _out );
+    fwrite( &payload[0], 1, size, _out );
+  }
+  records.clear( );
+}
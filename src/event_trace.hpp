@@ -0,0 +1,122 @@
+// $Id$
+
+#ifndef _EVENT_TRACE_HPP_
+#define _EVENT_TRACE_HPP_
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <mutex>
+
+#include "config_utils.hpp"
+#include "flit.hpp"
+#include "globals.hpp"
+
+using namespace std;
+
+// Binary flit event trace (trace_out), a low-overhead alternative to the
+// text output of watched flits. Packets are sampled when they are created
+// (trace_sample, trace_start, trace_end); the flits of sampled packets have
+// Flit::trace set, and every event of such a flit appends a fixed-size
+// record to a buffer of the calling thread. Full buffers are written as
+// blocks of trace_block records, delta and varint encoded unless
+// trace_compress is 0. utils/trace2csv.py converts a trace to CSV.
+// Every simulation writes its own trace: the points of a sweep or a
+// saturation search go to trace_out.<point>, numbered in sweep (or probe)
+// order.
+//
+// File layout: the 8 byte magic "BSEVTRC1", then blocks of
+//   encoding (1 byte: 0 raw, 1 compressed), record count (uint32),
+//   payload size in bytes (uint32), payload.
+// A raw payload is an array of Record. A compressed payload stores per
+// record the differences of time, id and pid to the previous record of the
+// block and the values of node, port and vc as zigzag varints, followed by
+// the type and flags bytes. Blocks of different threads may interleave, so
+// records are only ordered by time within a block.
+class EventTrace {
+
+public:
+  enum EventType { inject = 0, route, vc_alloc, sw_alloc, traverse, eject,
+                   num_types };
+
+  struct Record {
+    int time;
+    int id;           // flit
+    int pid;          // packet
+    int node;         // router, or source / destination node
+    short port;       // input port for route, output port otherwise
+    short vc;
+    unsigned char type;
+    unsigned char flags;  // 1: head, 2: tail
+    short reserved;
+  };
+
+private:
+  struct _Buffer {
+    vector<Record> records;
+  };
+
+  static bool _enabled;
+  static unsigned _event_mask;
+  static int _sample;
+  static int _start;
+  static int _end;
+  static size_t _block;
+  static bool _compress;
+
+  static FILE * _out;
+  static mutex _lock;
+  static vector<_Buffer *> _buffers;
+  static thread_local _Buffer * _buffer;
+
+  static _Buffer * _NewBuffer( );
+  static void _Flush( _Buffer * buffer );
+
+public:
+  // set up tracing of one simulation from the configuration; no-op unless
+  // trace_out is set
+  static void Open( Configuration const & config );
+  // write all buffered records and close the trace at the end of the
+  // simulation; worker threads must be idle
+  static void Close( );
+
+  inline static bool Enabled( ) { return _enabled; }
+
+  // whether the packet created now should be traced
+  inline static bool Sample( int pid ) {
+    if ( !_enabled ) {
+      return false;
+    }
+    int const time = GetSimTime( );
+    return ( time >= _start ) && ( ( _end < 0 ) || ( time <= _end ) ) &&
+      ( ( _sample <= 1 ) || ( ( pid % _sample ) == 0 ) );
+  }
+
+  // callers check f->trace first, so untraced flits cost one test
+  inline static void Add( EventType type, Flit const * f, int node,
+                          int port = -1, int vc = -1 ) {
+    if ( !( _event_mask & ( 1u << type ) ) ) {
+      return;
+    }
+    _Buffer * buffer = _buffer;
+    if ( !buffer ) {
+      buffer = _NewBuffer( );
+    }
+    Record r;
+    r.time = GetSimTime( );
+    r.id = f->id;
+    r.pid = f->pid;
+    r.node = node;
+    r.port = port;
+    r.vc = vc;
+    r.type = type;
+    r.flags = ( f->head ? 1 : 0 ) | ( f->tail ? 2 : 0 );
+    r.reserved = 0;
+    buffer->records.push_back( r );
+    if ( buffer->records.size( ) >= _block ) {
+      _Flush( buffer );
+    }
+  }
+};
+
+#endif
@@ -37,9 +37,6 @@
 #include "booksim.hpp"
 #include "flit.hpp"
 
-stack<Flit *> Flit::_all;
-stack<Flit *> Flit::_free;
-
 ostream& operator<<( ostream& os, const Flit& f )
 {
   os << "  Flit ID: " << f.id << " (" << &f << ")" 
@@ -68,10 +65,12 @@ void Flit::Reset()
   ctime     = -1 ;
   itime     = -1 ;
   atime     = -1 ;
+  rtime     = -1 ;
   id        = -1 ;
   pid       = -1 ;
   hops      = 0 ;
   watch     = false ;
+  trace     = false ;
   record    = false ;
   intm = 0;
   src = -1;
@@ -83,25 +82,15 @@ void Flit::Reset()
 }  
 
 Flit * Flit::New() {
-  Flit * f;
-  if(_free.empty()) {
-    f = new Flit;
-    _all.push(f);
-  } else {
-    f = _free.top();
-    f->Reset();
-    _free.pop();
-  }
+  Flit * const f = ObjectPool<Flit>::New();
+  f->Reset();
   return f;
 }
 
 void Flit::Free() {
-  _free.push(this);
+  ObjectPool<Flit>::Free(this);
 }
 
 void Flit::FreeAll() {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
-  }
+  ObjectPool<Flit>::FreeAll();
 }
@@ -29,10 +29,10 @@
 #define _FLIT_HPP_
 
 #include <iostream>
-#include <stack>
 
 #include "booksim.hpp"
 #include "outputset.hpp"
+#include "pool.hpp"
 
 class Flit {
 
@@ -56,6 +56,8 @@ public:
   int  ctime;
   int  itime;
   int  atime;
+  // arrival at the router currently holding the flit
+  int  rtime;
 
   int  id;
   int  pid;
@@ -69,6 +71,8 @@ public:
 
   int  hops;
   bool watch;
+  // events are recorded in the binary trace (trace_out)
+  bool trace;
   int  subnetwork;
   
   // intermediate destination (if any)
@@ -91,12 +95,12 @@ public:
 
 private:
 
+  friend class ObjectPool<Flit>;
+  Flit * _next_free;
+
   Flit();
   ~Flit() {}
 
-  static stack<Flit *> _all;
-  static stack<Flit *> _free;
-
 };
 
 ostream& operator<<( ostream& os, const Flit& f );
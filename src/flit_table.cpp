@@ -0,0 +1,67 @@
+// $Id$
+
+/*flit_table.cpp
+ *
+ *Paged table of flits indexed by flit or packet ID
+ *
+ */
+
+#include "booksim.hpp"
+#include "flit_table.hpp"
+
+// make sure the page holding keys of the given page index exists
+void FlitTable::_Grow( int page )
+{
+  if ( _pages.empty( ) ) {
+    _first_page = page;
+  }
+  while ( page < _first_page ) {
+    _pages.push_front( vector<Flit *>( ) );
+    _live.push_front( 0 );
+    --_first_page;
+  }
+  while ( page >= _first_page + (int)_pages.size( ) ) {
+    _pages.push_back( vector<Flit *>( ) );
+    _live.push_back( 0 );
+  }
+  vector<Flit *> & entries = _pages[page - _first_page];
+  assert( entries.empty( ) );
+  if ( _spare.empty( ) ) {
+    entries.assign( _page_size, 0 );
+  } else {
+    entries.swap( _spare.back( ) );
+    _spare.pop_back( );
+  }
+}
+
+// recycle an empty page and drop unallocated pages at either end
+void FlitTable::_Release( int p )
+{
+  _spare.push_back( vector<Flit *>( ) );
+  _spare.back( ).swap( _pages[p] );
+  while ( !_pages.empty( ) && _pages.front( ).empty( ) ) {
+    _pages.pop_front( );
+    _live.pop_front( );
+    ++_first_page;
+  }
+  while ( !_pages.empty( ) && _pages.back( ).empty( ) ) {
+    _pages.pop_back( );
+    _live.pop_back( );
+  }
+}
+
+void FlitTable::GetFlits( vector<Flit *> * flits, int max_count ) const
+{
+  flits->clear( );
+  for ( size_t p = 0; p < _pages.size( ); ++p ) {
+    vector<Flit *> const & entries = _pages[p];
+    for ( size_t i = 0; i < entries.size( ); ++i ) {
+      if ( entries[i] ) {
+        if ( ( max_count >= 0 ) && ( (int)flits->size( ) >= max_count ) ) {
+          return;
+        }
+        flits->push_back( entries[i] );
+      }
+    }
+  }
+}
@@ -0,0 +1,75 @@
+// $Id$
+
+#ifndef _FLIT_TABLE_HPP_
+#define _FLIT_TABLE_HPP_
+
+#include <vector>
+#include <deque>
+#include <cassert>
+
+#include "flit.hpp"
+
+// Flits indexed by an integer key (flit or packet ID). The keys of flits in
+// flight are close to each other, so entries are kept in fixed-size pages
+// covering a sliding key range; pages are allocated on first use and
+// recycled once empty. Insert, Find and Erase are O(1) and iteration is in
+// key order, like the map this replaces.
+class FlitTable {
+
+  enum { _page_bits = 10, _page_size = 1 << _page_bits };
+
+  int _size;
+  int _first_page;
+  deque<vector<Flit *> > _pages; // empty vector: page not allocated
+  deque<int> _live;              // entries in use per page
+  vector<vector<Flit *> > _spare;
+
+  void _Grow( int page );
+  void _Release( int p );
+
+public:
+  FlitTable( ) : _size( 0 ), _first_page( 0 ) {}
+
+  inline int Size( ) const { return _size; }
+  inline bool Empty( ) const { return _size == 0; }
+
+  inline Flit * Find( int key ) const {
+    int const p = ( key >> _page_bits ) - _first_page;
+    if ( ( p < 0 ) || ( p >= (int)_pages.size( ) ) || _pages[p].empty( ) ) {
+      return 0;
+    }
+    return _pages[p][key & ( _page_size - 1 )];
+  }
+
+  inline void Insert( int key, Flit * f ) {
+    assert( f );
+    int p = ( key >> _page_bits ) - _first_page;
+    if ( _pages.empty( ) || ( p < 0 ) || ( p >= (int)_pages.size( ) ) ||
+         _pages[p].empty( ) ) {
+      _Grow( key >> _page_bits );
+      p = ( key >> _page_bits ) - _first_page;
+    }
+    Flit * & entry = _pages[p][key & ( _page_size - 1 )];
+    assert( !entry );
+    entry = f;
+    ++_live[p];
+    ++_size;
+  }
+
+  inline void Erase( int key ) {
+    int const p = ( key >> _page_bits ) - _first_page;
+    assert( ( p >= 0 ) && ( p < (int)_pages.size( ) ) && !_pages[p].empty( ) );
+    Flit * & entry = _pages[p][key & ( _page_size - 1 )];
+    assert( entry );
+    entry = 0;
+    --_size;
+    if ( --_live[p] == 0 ) {
+      _Release( p );
+    }
+  }
+
+  // all flits in key order
+  void GetFlits( vector<Flit *> * flits, int max_count = -1 ) const;
+};
+
+#endif
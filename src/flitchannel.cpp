@@ -36,9 +36,11 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 #include "router.hpp"
 #include "globals.hpp"
+#include "elevator_stats.hpp"
 
 // ----------------------------------------------------------------------
 //  $Author: jbalfour $
@@ -47,7 +49,9 @@
 // ----------------------------------------------------------------------
 FlitChannel::FlitChannel(Module * parent, string const & name, int classes)
 : Channel<Flit>(parent, name), _routerSource(NULL), _routerSourcePort(-1), 
-  _routerSink(NULL), _routerSinkPort(-1), _idle(0) {
+  _routerSink(NULL), _routerSinkPort(-1), _idle(0),
+  _track_utilization(false), _period_start(0), _period_flits(0),
+  _period_busy(0), _busy_until(0), _elevator_stats(NULL) {
   _active.resize(classes, 0);
 }
 
@@ -64,12 +68,42 @@ void FlitChannel::SetSink(Router const * const router, int port) {
 void FlitChannel::Send(Flit * f) {
   if(f) {
     ++_active[f->cl];
+    if(_track_utilization) {
+      // a flit occupies the channel for _delay cycles; overlapping flits
+      // only extend the current busy interval
+      int const now = GetSimTime();
+      int const end = now + _delay;
+      _period_busy += end - max(now, _busy_until);
+      _busy_until = end;
+      ++_period_flits;
+    }
+    if(_elevator_stats && f->head) {
+      _elevator_stats->VerticalDeparture(_routerSource->GetID(), f);
+    }
   } else {
     ++_idle;
   }
   Channel<Flit>::Send(f);
 }
 
+void FlitChannel::TrackUtilization() {
+  _track_utilization = true;
+  ResetUtilization();
+}
+
+void FlitChannel::ResetUtilization() {
+  int const now = GetSimTime();
+  _period_start = now;
+  _period_flits = 0;
+  // cycles of flits still in flight belong to the new period
+  _period_busy = max(_busy_until - now, 0);
+}
+
+int FlitChannel::GetPeriodBusyCycles() const {
+  // exclude the part of the current busy interval that lies in the future
+  return _period_busy - max(_busy_until - GetSimTime(), 0);
+}
+
 void FlitChannel::ReadInputs() {
   Flit const * const & f = _input;
   if(f && f->watch) {
@@ -89,3 +123,15 @@ void FlitChannel::WriteOutputs() {
 	       << "." << endl;
   }
 }
+
+void FlitChannel::SaveState(CheckpointWriter & writer) const {
+  Channel<Flit>::SaveState(writer);
+  writer.WriteInts(_active);
+  writer.WriteInt(_idle);
+}
+
+void FlitChannel::LoadState(CheckpointReader & reader) {
+  Channel<Flit>::LoadState(reader);
+  _active = reader.ReadInts();
+  _idle = reader.ReadInt();
+}
@@ -49,6 +49,7 @@
 using namespace std;
 
 class Router ;
+class ElevatorStats ;
 
 class FlitChannel : public Channel<Flit> {
 public:
@@ -72,12 +73,30 @@ public:
     return _active;
   }
 
+  // Utilization since the last reset (channel_stats_out): flits sent and
+  // cycles with at least one flit in flight on the channel
+  void TrackUtilization();
+  void ResetUtilization();
+  inline int GetPeriodFlits() const {
+    return _period_flits;
+  }
+  int GetPeriodBusyCycles() const;
+
+  // vertical channels of a UniTorus report head flits to the elevator
+  // statistics (elevator_stats)
+  void SetElevatorStats(ElevatorStats * stats) {
+    _elevator_stats = stats;
+  }
+
   // Send flit 
   virtual void Send(Flit * flit);
 
   virtual void ReadInputs();
   virtual void WriteOutputs();
 
+  virtual void SaveState(CheckpointWriter & writer) const;
+  virtual void LoadState(CheckpointReader & reader);
+
 private:
   
   ////////////////////////////////////////
@@ -94,6 +113,14 @@ private:
   // Statistics for Activity Factors
   vector<int> _active;
   int _idle;
+
+  bool _track_utilization;
+  int _period_start;
+  int _period_flits;
+  int _period_busy;
+  int _busy_until;
+
+  ElevatorStats * _elevator_stats;
 };
 
 #endif
@@ -55,12 +55,16 @@ extern std::vector<float> gDimPenalties;
 // Global dimension bandwidths for routing cost calculation  
 extern std::vector<int> gDimBandwidths;
 
+// Global dimension channel latencies
+extern std::vector<int> gDimLatencies;
+
 extern std::vector<std::vector<int>> gElevatorMapping;
 
 extern std::string gVerticalTopology;
 
 extern bool gTrace;
 
-extern std::ostream * gWatchOut;
+// per thread, see ThreadPool
+extern thread_local std::ostream * gWatchOut;
 
 #endif
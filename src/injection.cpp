@@ -29,6 +29,7 @@
 #include <vector>
 #include <cassert>
 #include <limits>
+#include <cmath>
 #include "random_utils.hpp"
 #include "injection.hpp"
 
@@ -53,6 +54,33 @@ void InjectionProcess::reset()
 
 }
 
+int InjectionProcess::next(int source)
+{
+  cout << "Error: Injection process does not support skip-ahead sampling."
+       << endl;
+  exit(-1);
+}
+
+// Number of failed trials before the first success of a Bernoulli(p)
+// sequence, sampled by inverting the geometric distribution
+static double _Geometric(double p)
+{
+  if(p >= 1.0) {
+    return 0.0;
+  }
+  if(p <= 0.0) {
+    return numeric_limits<double>::infinity();
+  }
+  double const u = 1.0 - RandomFloat(); // (0, 1]
+  return floor(log(u) / log1p(-p));
+}
+
+static int _ClampGap(double gap)
+{
+  return (gap >= (double)numeric_limits<int>::max()) ? 
+    numeric_limits<int>::max() : (int)gap;
+}
+
 InjectionProcess * InjectionProcess::New(string const & inject, int nodes, 
 					 double load, 
 					 Configuration const * const config)
@@ -146,6 +174,12 @@ bool BernoulliInjectionProcess::test(int source)
   return (RandomFloat() < _rate);
 }
 
+int BernoulliInjectionProcess::next(int source)
+{
+  assert((source >= 0) && (source < _nodes));
+  return _ClampGap(_Geometric(_rate));
+}
+
 //=============================================================
 
 OnOffInjectionProcess::OnOffInjectionProcess(int nodes, double rate, 
@@ -188,3 +222,45 @@ bool OnOffInjectionProcess::test(int source)
   // generate packet
   return _state[source] && (RandomFloat() < _r1);
 }
+
+int OnOffInjectionProcess::next(int source)
+{
+  assert((source >= 0) && (source < _nodes));
+
+  // Each test() first advances the state and then injects with probability
+  // _r1 if the source is on; sample the lengths of the off and on runs
+  // instead of stepping through them one cycle at a time.
+  double const on_event = _beta + (1.0 - _beta) * _r1;
+  double gap = 0.0;
+  while(gap < (double)numeric_limits<int>::max()) {
+    if(!_state[source]) {
+      // cycles spent off, then the cycle that turns the source on
+      gap += _Geometric(_alpha);
+      _state[source] = 1;
+      if(RandomFloat() < _r1) {
+	return _ClampGap(gap);
+      }
+      gap += 1.0;
+    } else {
+      // cycles staying on without injecting, then either an injection or
+      // a transition to off
+      gap += _Geometric(on_event);
+      if(RandomFloat() * on_event >= _beta) {
+	return _ClampGap(gap);
+      }
+      _state[source] = 0;
+      gap += 1.0;
+    }
+  }
+  return numeric_limits<int>::max();
+}
+
+void OnOffInjectionProcess::SaveState(CheckpointWriter & writer) const
+{
+  writer.WriteInts(_state);
+}
+
+void OnOffInjectionProcess::LoadState(CheckpointReader & reader)
+{
+  _state = reader.ReadInts();
+}
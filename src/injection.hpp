@@ -29,6 +29,7 @@
 #define _INJECTION_HPP_
 
 #include "config_utils.hpp"
+#include "checkpoint.hpp"
 
 using namespace std;
 
@@ -40,7 +41,16 @@ protected:
 public:
   virtual ~InjectionProcess() {}
   virtual bool test(int source) = 0;
+  // Skip-ahead sampling: next() returns the number of cycles without an
+  // injection before the next cycle that injects, consuming that many
+  // test() outcomes at once (numeric_limits<int>::max() if the source never
+  // injects again). Only processes for which can_skip() holds implement it.
+  virtual bool can_skip() const { return false; }
+  virtual int next(int source);
   virtual void reset();
+  // Checkpoints: per-source process state
+  virtual void SaveState(CheckpointWriter & writer) const {}
+  virtual void LoadState(CheckpointReader & reader) {}
   static InjectionProcess * New(string const & inject, int nodes, double load, 
 				Configuration const * const config = NULL);
 };
@@ -49,6 +59,8 @@ class BernoulliInjectionProcess : public InjectionProcess {
 public:
   BernoulliInjectionProcess(int nodes, double rate);
   virtual bool test(int source);
+  virtual bool can_skip() const { return true; }
+  virtual int next(int source);
 };
 
 class OnOffInjectionProcess : public InjectionProcess {
@@ -63,6 +75,10 @@ public:
 			double r1, vector<int> initial);
   virtual void reset();
   virtual bool test(int source);
+  virtual bool can_skip() const { return true; }
+  virtual int next(int source);
+  virtual void SaveState(CheckpointWriter & writer) const;
+  virtual void LoadState(CheckpointReader & reader);
 };
 
 #endif 
@@ -53,6 +53,10 @@
 #include "network.hpp"
 #include "injection.hpp"
 #include "power_module.hpp"
+#include "sweep.hpp"
+#include "elevator_placement.hpp"
+#include "analytic.hpp"
+#include "event_trace.hpp"
 
 
 
@@ -90,21 +94,24 @@ int gNodes;
 vector<int> gDimSizes;
 vector<float> gDimPenalties;
 vector<int> gDimBandwidths;
+vector<int> gDimLatencies;
 vector<vector<int>> gElevatorMapping;
 string gVerticalTopology;
 //generate nocviewer trace
 bool gTrace;
 
-ostream * gWatchOut;
+thread_local ostream * gWatchOut;
 
 
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Simulate( BookSimConfig const & config )
+bool Simulate( BookSimConfig const & config, SimResult * result_out )
 {
   vector<Network *> net;
 
+  EventTrace::Open( config );
+
   int subnets = config.GetInt("subnets");
   /*To include a new network, must register the network here
    *add an else if statement with the name of the network
@@ -138,6 +145,17 @@ bool Simulate( BookSimConfig const & config )
 
   cout<<"Total run time "<<total_time<<endl;
 
+  EventTrace::Close( );
+
+  if(result_out) {
+    result_out->stable = result;
+    result_out->latency = result ? trafficManager->GetOverallPacketLatency() : 0.0;
+    result_out->throughput = result ? trafficManager->GetOverallAcceptedPacketRate() : 0.0;
+    result_out->latency_ci = result ? trafficManager->GetOverallPacketLatencyCI() : 0.0;
+    result_out->throughput_ci = result ? trafficManager->GetOverallAcceptedPacketRateCI() : 0.0;
+    result_out->cycles = trafficManager->getTime();
+  }
+
   for (int i=0; i<subnets; ++i) {
 
     ///Power analysis
@@ -161,12 +179,30 @@ int main( int argc, char **argv )
 
   BookSimConfig config;
 
+  // --jobs N / -j N sets the number of parallel sweep workers; take it out
+  // of the argument list, as ParseArgs would read N as a config file
+  vector<char *> args;
+  int jobs = 0;
+  for ( int i = 0; i < argc; ++i ) {
+    string const arg = argv[i];
+    if ( ( ( arg == "--jobs" ) || ( arg == "-j" ) ) && ( i + 1 < argc ) ) {
+      jobs = atoi( argv[++i] );
+    } else if ( arg.compare( 0, 7, "--jobs=" ) == 0 ) {
+      jobs = atoi( arg.c_str( ) + 7 );
+    } else {
+      args.push_back( argv[i] );
+    }
+  }
 
-  if ( !ParseArgs( &config, argc, argv ) ) {
-    cerr << "Usage: " << argv[0] << " configfile... [param=value...]" << endl;
+  if ( !ParseArgs( &config, args.size(), &args[0] ) ) {
+    cerr << "Usage: " << argv[0] << " [--jobs N] configfile... [param=value...]" << endl;
     return 0;
  } 
 
+  if ( jobs > 0 ) {
+    config.Assign( "sweep_jobs", jobs );
+  }
+
   
   /*initialize routing, traffic, injection functions
    */
@@ -183,10 +219,21 @@ int main( int argc, char **argv )
   } else {
     gWatchOut = new ofstream(watch_out_file.c_str());
   }
-  
 
   /*configure and run the simulator
    */
-  bool result = Simulate( config );
+  bool result;
+  if ( AnalyticEnabled( config ) ) {
+    result = RunAnalytic( config );
+  } else if ( ElevatorPlacementEnabled( config ) ) {
+    result = RunElevatorPlacement( config );
+  } else if ( SaturationSearchEnabled( config ) ) {
+    result = RunSaturationSearch( config );
+  } else if ( SweepEnabled( config ) ) {
+    result = RunSweep( config );
+  } else {
+    result = Simulate( config );
+  }
+
   return result ? -1 : 0;
 }
@@ -34,6 +34,7 @@
 
 #include <cassert>
 #include <sstream>
+#include <algorithm>
 
 #include "booksim.hpp"
 #include "network.hpp"
@@ -48,6 +49,8 @@
 #include "anynet.hpp"
 #include "dragonfly.hpp"
 #include "unitorus.hpp"
+#include "iq_router.hpp"
+#include "buffer_monitor.hpp"
 
 
 Network::Network( const Configuration &config, const string & name ) :
@@ -57,10 +60,21 @@ Network::Network( const Configuration &config, const string & name ) :
   _nodes    = -1; 
   _channels = -1;
   _classes  = config.GetInt("classes");
+  _event_driven = (config.GetInt("event_driven") > 0);
+  _event_init = false;
+  int const threads = config.GetInt("sim_threads");
+  if ( threads < 1 ) {
+    ostringstream err;
+    err << "Invalid sim_threads: " << threads;
+    Error( err.str( ) );
+  }
+  _pool = ( threads > 1 ) ? new ThreadPool( threads ) : NULL;
+  _channel_stats_start = 0;
 }
 
 Network::~Network( )
 {
+  if ( _pool ) delete _pool;
   for ( int r = 0; r < _size; ++r ) {
     if ( _routers[r] ) delete _routers[r];
   }
@@ -135,6 +149,7 @@ void Network::_Alloc( )
 	  ( _channels != -1 ) );
 
   _routers.resize(_size);
+  _router_random.resize(_size);
   gNodes = _nodes;
 
   /*booksim used arrays of flits as the channels which makes have capacity of
@@ -183,8 +198,91 @@ void Network::_Alloc( )
   }
 }
 
+void Network::_InitEventKernel( )
+{
+  // every channel reports when it becomes busy; those feeding a router also
+  // wake it up once data arrives
+  for ( int s = 0; s < _nodes; ++s ) {
+    _inject[s]->SetActivityListener( this );
+    _inject_cred[s]->SetActivityListener( this );
+    _eject[s]->SetActivityListener( this );
+    _eject_cred[s]->SetActivityListener( this );
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    _chan[c]->SetActivityListener( this );
+    _chan_cred[c]->SetActivityListener( this );
+  }
+  for ( int r = 0; r < _size; ++r ) {
+    for ( int i = 0; i < _routers[r]->NumInputs( ); ++i ) {
+      _routers[r]->GetInputChannel( i )->SetActivityListener( this, r );
+    }
+    for ( int o = 0; o < _routers[r]->NumOutputs( ); ++o ) {
+      _routers[r]->GetOutputCredit( o )->SetActivityListener( this, r );
+    }
+  }
+
+  // start with all routers active; idle ones drop out after one cycle
+  _active_routers.resize( _size );
+  for ( int r = 0; r < _size; ++r ) {
+    _active_routers[r] = r;
+  }
+  _router_active.assign( _size, true );
+  _router_woken.assign( _size, false );
+
+  _event_init = true;
+}
+
+void Network::ChannelBusy( Channel<Flit> * channel )
+{
+  _busy_channels.push_back( static_cast<FlitChannel *>( channel ) );
+}
+
+void Network::ChannelBusy( Channel<Credit> * channel )
+{
+  _busy_credit_channels.push_back( channel );
+}
+
+void Network::WakeReceiver( int receiver )
+{
+  assert( ( receiver >= 0 ) && ( receiver < _size ) );
+  if ( !_router_woken[receiver] ) {
+    _router_woken[receiver] = true;
+    _woken_routers.push_back( receiver );
+  }
+}
+
 void Network::ReadInputs( )
 {
+  if ( _event_driven ) {
+    if ( !_event_init ) {
+      _InitEventKernel( );
+    }
+    for ( size_t i = 0; i < _busy_channels.size( ); ++i ) {
+      _busy_channels[i]->ReadInputs( );
+    }
+    for ( size_t i = 0; i < _busy_credit_channels.size( ); ++i ) {
+      _busy_credit_channels[i]->ReadInputs( );
+    }
+    // only routers with data waiting at an input can receive anything
+    bool added = false;
+    for ( size_t i = 0; i < _woken_routers.size( ); ++i ) {
+      int const r = _woken_routers[i];
+      _router_woken[r] = false;
+      _routers[r]->ReadInputs( );
+      if ( !_router_active[r] ) {
+        _router_active[r] = true;
+        _active_routers.push_back( r );
+        added = true;
+      }
+    }
+    _woken_routers.clear( );
+    // keep evaluating routers in order, so watch output matches the full loop
+    if ( added ) {
+      sort( _active_routers.begin( ), _active_routers.end( ) );
+    }
+    return;
+  }
+
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -192,17 +290,84 @@ void Network::ReadInputs( )
   }
 }
 
+// Evaluate one contiguous share of the (active) routers. Routers only
+// interact through channels, which are not touched during Evaluate, and
+// draw random numbers from their own stream.
+void Network::_EvaluateRouters( void * arg, int part, int parts )
+{
+  Network * const net = static_cast<Network *>( arg );
+  if ( net->_event_driven ) {
+    size_t const n = net->_active_routers.size( );
+    size_t const end = n * ( part + 1 ) / parts;
+    for ( size_t i = n * part / parts; i < end; ++i ) {
+      int const r = net->_active_routers[i];
+      RandomSelectStream( &net->_router_random[r] );
+      net->_routers[r]->Evaluate( );
+    }
+  } else {
+    int const end = net->_size * ( part + 1 ) / parts;
+    for ( int r = net->_size * part / parts; r < end; ++r ) {
+      RandomSelectStream( &net->_router_random[r] );
+      net->_routers[r]->Evaluate( );
+    }
+  }
+  RandomSelectStream( NULL );
+}
+
 void Network::Evaluate( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
-    (*iter)->Evaluate( );
+  // channels have nothing to evaluate
+  if ( _pool ) {
+    _pool->Run( _EvaluateRouters, this );
+  } else {
+    _EvaluateRouters( this, 0, 1 );
+  }
+}
+
+void Network::SeedRouters( long seed, int subnet )
+{
+  for ( int r = 0; r < _size; ++r ) {
+    _router_random[r].Seed( seed, subnet, r );
   }
 }
 
 void Network::WriteOutputs( )
 {
+  if ( _event_driven ) {
+    size_t active = 0;
+    for ( size_t i = 0; i < _active_routers.size( ); ++i ) {
+      int const r = _active_routers[i];
+      _routers[r]->WriteOutputs( );
+      if ( _routers[r]->IsIdle( ) ) {
+        _router_active[r] = false;
+      } else {
+        _active_routers[active++] = r;
+      }
+    }
+    _active_routers.resize( active );
+
+    // this includes channels that routers just sent on
+    size_t busy = 0;
+    for ( size_t i = 0; i < _busy_channels.size( ); ++i ) {
+      FlitChannel * const channel = _busy_channels[i];
+      channel->WriteOutputs( );
+      if ( channel->UpdateBusy( ) ) {
+        _busy_channels[busy++] = channel;
+      }
+    }
+    _busy_channels.resize( busy );
+    busy = 0;
+    for ( size_t i = 0; i < _busy_credit_channels.size( ); ++i ) {
+      CreditChannel * const channel = _busy_credit_channels[i];
+      channel->WriteOutputs( );
+      if ( channel->UpdateBusy( ) ) {
+        _busy_credit_channels[busy++] = channel;
+      }
+    }
+    _busy_credit_channels.resize( busy );
+    return;
+  }
+
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -210,6 +375,85 @@ void Network::WriteOutputs( )
   }
 }
 
+void Network::SaveState( CheckpointWriter & writer ) const
+{
+  for ( int s = 0; s < _nodes; ++s ) {
+    _inject[s]->SaveState( writer );
+    _inject_cred[s]->SaveState( writer );
+    _eject[s]->SaveState( writer );
+    _eject_cred[s]->SaveState( writer );
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    _chan[c]->SaveState( writer );
+    _chan_cred[c]->SaveState( writer );
+  }
+  for ( int r = 0; r < _size; ++r ) {
+    _routers[r]->SaveState( writer );
+    writer.WriteString( _router_random[r].GetState( ) );
+  }
+}
+
+void Network::LoadState( CheckpointReader & reader )
+{
+  for ( int s = 0; s < _nodes; ++s ) {
+    _inject[s]->LoadState( reader );
+    _inject_cred[s]->LoadState( reader );
+    _eject[s]->LoadState( reader );
+    _eject_cred[s]->LoadState( reader );
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    _chan[c]->LoadState( reader );
+    _chan_cred[c]->LoadState( reader );
+  }
+  for ( int r = 0; r < _size; ++r ) {
+    _routers[r]->LoadState( reader );
+    _router_random[r].SetState( reader.ReadString( ) );
+  }
+
+  if ( !_event_driven ) {
+    return;
+  }
+
+  // rebuild the event kernel from the loaded state: every channel with data
+  // is busy, and every router reads its inputs and is evaluated once before
+  // idle ones drop out again
+  if ( !_event_init ) {
+    _InitEventKernel( );
+  }
+  _busy_channels.clear( );
+  _busy_credit_channels.clear( );
+  for ( int s = 0; s < _nodes; ++s ) {
+    if ( _inject[s]->UpdateBusy( ) ) {
+      _busy_channels.push_back( _inject[s] );
+    }
+    if ( _inject_cred[s]->UpdateBusy( ) ) {
+      _busy_credit_channels.push_back( _inject_cred[s] );
+    }
+    if ( _eject[s]->UpdateBusy( ) ) {
+      _busy_channels.push_back( _eject[s] );
+    }
+    if ( _eject_cred[s]->UpdateBusy( ) ) {
+      _busy_credit_channels.push_back( _eject_cred[s] );
+    }
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    if ( _chan[c]->UpdateBusy( ) ) {
+      _busy_channels.push_back( _chan[c] );
+    }
+    if ( _chan_cred[c]->UpdateBusy( ) ) {
+      _busy_credit_channels.push_back( _chan_cred[c] );
+    }
+  }
+  _active_routers.resize( _size );
+  _woken_routers.resize( _size );
+  for ( int r = 0; r < _size; ++r ) {
+    _active_routers[r] = r;
+    _woken_routers[r] = r;
+  }
+  _router_active.assign( _size, true );
+  _router_woken.assign( _size, true );
+}
+
 void Network::WriteFlit( Flit *f, int source )
 {
   assert( ( source >= 0 ) && ( source < _nodes ) );
@@ -292,3 +536,76 @@ void Network::DumpNodeMap( ostream & os, string const & prefix ) const
        << _eject[s]->GetSource()->GetID() << ','
        << _inject[s]->GetSink()->GetID() << endl;
 }
+
+void Network::TrackChannelStats( )
+{
+  for(int c = 0; c < _channels; ++c) {
+    _chan[c]->TrackUtilization();
+  }
+  for(int r = 0; r < _size; ++r) {
+    IQRouter * const iq = dynamic_cast<IQRouter *>(_routers[r]);
+    if(iq) {
+      iq->TrackBufferOccupancy();
+    }
+  }
+  _channel_stats_start = GetSimTime();
+}
+
+void Network::ResetChannelStats( )
+{
+  for(int c = 0; c < _channels; ++c) {
+    _chan[c]->ResetUtilization();
+  }
+  for(int r = 0; r < _size; ++r) {
+    IQRouter * const iq = dynamic_cast<IQRouter *>(_routers[r]);
+    if(iq) {
+      iq->ResetBufferOccupancy();
+    }
+  }
+  _channel_stats_start = GetSimTime();
+}
+
+void Network::_WriteChannelKeyHeader( ostream & os ) const
+{
+  os << "channel,source_router,source_port";
+}
+
+void Network::_WriteChannelKey( ostream & os, int c ) const
+{
+  os << c << ',' << _chan[c]->GetSource()->GetID() << ','
+     << _chan[c]->GetSourcePort();
+}
+
+void Network::WriteChannelStatsHeader( ostream & os, string const & prefix ) const
+{
+  os << prefix;
+  _WriteChannelKeyHeader(os);
+  os << ",flits,busy_cycles,utilization,avg_occupancy,max_occupancy" << endl;
+}
+
+// One line per channel. Occupancy is that of the whole input buffer (all
+// VCs) at the sink router, and is left empty for routers without a buffer
+// monitor.
+void Network::WriteChannelStats( ostream & os, string const & prefix ) const
+{
+  int const cycles = GetSimTime() - _channel_stats_start;
+  for(int c = 0; c < _channels; ++c) {
+    FlitChannel const * const chan = _chan[c];
+    int const busy = chan->GetPeriodBusyCycles();
+    os << prefix;
+    _WriteChannelKey(os, c);
+    os << ',' << chan->GetPeriodFlits()
+       << ',' << busy
+       << ',' << ((cycles > 0) ? ((double)busy / (double)cycles) : 0.0);
+    IQRouter const * const iq = dynamic_cast<IQRouter const *>(chan->GetSink());
+    if(iq) {
+      BufferMonitor const * const bm = iq->GetBufferMonitor();
+      int const input = chan->GetSinkPort();
+      os << ',' << bm->AverageOccupancy(input)
+         << ',' << bm->MaxOccupancy(input);
+    } else {
+      os << ",,";
+    }
+    os << endl;
+  }
+}
@@ -41,11 +41,13 @@
 #include "channel.hpp"
 #include "config_utils.hpp"
 #include "globals.hpp"
+#include "thread_pool.hpp"
+#include "random_utils.hpp"
 
 typedef Channel<Credit> CreditChannel;
 
 
-class Network : public TimedModule {
+class Network : public TimedModule, public ActivityListener {
 protected:
 
   int _size;
@@ -66,10 +68,37 @@ protected:
 
   deque<TimedModule *> _timed_modules;
 
+  // event-driven kernel state: channels with data in flight, routers with
+  // pending work (kept in router order), and routers woken by new input
+  bool _event_driven;
+  bool _event_init;
+  vector<FlitChannel *> _busy_channels;
+  vector<CreditChannel *> _busy_credit_channels;
+  vector<int> _active_routers;
+  vector<bool> _router_active;
+  vector<int> _woken_routers;
+  vector<bool> _router_woken;
+
+  // routers are evaluated by sim_threads threads if more than one
+  ThreadPool * _pool;
+
+  // random number stream of every router, selected while it is evaluated
+  vector<RandomStream> _router_random;
+
+  // start of the current channel statistics period
+  int _channel_stats_start;
+
+  // columns identifying a channel in WriteChannelStats
+  virtual void _WriteChannelKeyHeader( ostream & os ) const;
+  virtual void _WriteChannelKey( ostream & os, int c ) const;
+
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
   void _Alloc( );
+  void _InitEventKernel( );
+
+  static void _EvaluateRouters( void * arg, int part, int parts );
 
 public:
   Network( const Configuration &config, const string & name );
@@ -94,10 +123,33 @@ public:
   virtual void Evaluate( );
   virtual void WriteOutputs( );
 
+  // seeds the random number stream of every router from the seed, the
+  // subnet and the router ID
+  void SeedRouters( long seed, int subnet );
+
+  virtual void ChannelBusy( Channel<Flit> * channel );
+  virtual void ChannelBusy( Channel<Credit> * channel );
+  virtual void WakeReceiver( int receiver );
+
+  // Checkpoints: channel contents and router state
+  void SaveState( CheckpointWriter & writer ) const;
+  void LoadState( CheckpointReader & reader );
+
   void Display( ostream & os = cout ) const;
   void DumpChannelMap( ostream & os = cout, string const & prefix = "" ) const;
   void DumpNodeMap( ostream & os = cout, string const & prefix = "" ) const;
 
+  // Per-channel utilization and occupancy of the input buffer the channel
+  // feeds, measured from TrackChannelStats or the last ResetChannelStats
+  void TrackChannelStats( );
+  void ResetChannelStats( );
+  void WriteChannelStatsHeader( ostream & os, string const & prefix = "" ) const;
+  void WriteChannelStats( ostream & os, string const & prefix = "" ) const;
+
+  // columns identifying network channel c, as in WriteChannelStats
+  void WriteChannelKeyHeader( ostream & os ) const { _WriteChannelKeyHeader(os); }
+  void WriteChannelKey( ostream & os, int c ) const { _WriteChannelKey(os, c); }
+
   int NumChannels() const {return _channels;}
   const vector<FlitChannel *> & GetInject() {return _inject;}
   FlitChannel * GetInject(int index) {return _inject[index];}
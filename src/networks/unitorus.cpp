@@ -14,6 +14,8 @@
 #include <cassert>
 #include <iostream>
 #include <cstdlib>
+#include <cctype>
+#include <fstream>
 #include <string>
 #include "unitorus.hpp"
 #include "random_utils.hpp"
@@ -21,7 +23,7 @@
 #include "routefunc.hpp"
 
 UniTorus::UniTorus( const Configuration &config, const string & name ) :
-Network( config, name )
+Network( config, name ), _elevator_stats( NULL )
 {
   _debug = config.GetInt("unitorus_debug");
   _ComputeSize( config );
@@ -41,6 +43,20 @@ Network( config, name )
   }
   
   _BuildNet( config );
+
+  if (config.GetInt("elevator_stats") > 0) {
+    _elevator_stats = new ElevatorStats(this, "elevator_stats", _dim_sizes);
+    for (int c = 0; c < _channels; ++c) {
+      if (_chan_dir[c][0] == 'z') {
+        _chan[c]->SetElevatorStats(_elevator_stats);
+      }
+    }
+  }
+}
+
+UniTorus::~UniTorus( )
+{
+  delete _elevator_stats;
 }
 
 void UniTorus::_ComputeSize( const Configuration &config )
@@ -82,7 +98,15 @@ void UniTorus::_ComputeSize( const Configuration &config )
     }
     _dim_sizes.push_back(dim_size);
   }
-  
+
+  // the router ports (X, Y, then Z or Z-up/Z-down, see _BuildNet), their
+  // lanes and the routing tables are laid out for exactly three dimensions
+  if (_dim_sizes.size() != 3) {
+    cerr << "Error: unitorus needs three dimensions (dim_sizes = {X,Y,Z}), found "
+         << _dim_sizes.size() << endl;
+    exit(-1);
+  }
+
   // Calculate total network size
   _size = 1;
   for (int i = 0; i < (int)_dim_sizes.size(); ++i) {
@@ -96,9 +120,10 @@ void UniTorus::_ComputeSize( const Configuration &config )
   gDimPenalties = _dim_penalty; // Set global dimension penalties for routing functions
   gDimBandwidths = _dim_bandwidth; // Set global dimension bandwidths for routing functions
   gVerticalTopology = _vertical_topology;
-  // Parse elevator mapping
+  // Parse elevator mapping; elevator_file and the generated assignments
+  // take precedence, so sweeps over sizes can override a literal mapping
   string elevator_mapping_str = config.GetStr("elevator_mapping_coords");
-  if (!elevator_mapping_str.empty()) {
+  if (!_AssignElevators(config) && !elevator_mapping_str.empty()) {
       _ParseElevatorMapping(elevator_mapping_str);
       gElevatorMapping = _nearest_elevator;
   }
@@ -309,6 +334,7 @@ void UniTorus::_ParseDirectionConfig( const Configuration &config )
   if (!latency_values.empty()) {
     _dim_latency = latency_values;
   }
+  gDimLatencies = _dim_latency; // Update global for routing functions
 
   // Parse and validate penalty (allows zero)
   string penalty_str = config.GetStr("dim_penalty");
@@ -323,20 +349,23 @@ void UniTorus::_ParseDirectionConfig( const Configuration &config )
   gVerticalTopology = _vertical_topology; // Update global for routing functions
   bool is_vertical_mesh = (gVerticalTopology == "mesh");
 
-  // Calculate total channels - one per dimension per node
-  // Bandwidth will affect channel capacity, not number of channels
+  // Calculate total channels - one per dimension per node and lane
+  // A dimension with bandwidth N is built from N parallel channels (lanes)
   if (is_vertical_mesh && _dim_sizes.size() > 2) {
     // For mesh: X + Y + Z-up + Z-down
-    int xy_channels = 2 * _size;  // X and Y dimensions
+    int xy_channels = (_dim_bandwidth[0] + _dim_bandwidth[1]) * _size;  // X and Y dimensions
     int nodes_per_layer = _dim_sizes[0] * _dim_sizes[1];
     int z_layers = _dim_sizes[2];
-    int z_up_channels = (z_layers - 1) * nodes_per_layer;
-    int z_down_channels = (z_layers - 1) * nodes_per_layer;
+    int z_up_channels = (z_layers - 1) * nodes_per_layer * _dim_bandwidth[2];
+    int z_down_channels = (z_layers - 1) * nodes_per_layer * _dim_bandwidth[2];
     _channels = xy_channels + z_up_channels + z_down_channels;
-    // For 3×3×2: 36 + 9 + 9 = 54 channels
+    // For 3×3×2 with unit bandwidth: 36 + 9 + 9 = 54 channels
   } else {
     // For torus: original calculation
-    _channels = _dim_sizes.size() * _size;  // 3 × 18 = 54
+    _channels = 0;
+    for (int dim = 0; dim < num_dims; ++dim) {
+      _channels += _dim_bandwidth[dim] * _size;  // 3 × 18 = 54 with unit bandwidth
+    }
   }
 
   if (_debug) {
@@ -412,12 +441,13 @@ void UniTorus::_BuildNet( const Configuration &config )
     }
 
     // Each router has n output ports (one per dimension) + 1 injection + 1 ejection
-    int net_ports = 2; // X, Y always
+    // and one additional port per extra lane of each dimension
+    int net_ports = _dim_bandwidth[0] + _dim_bandwidth[1]; // X, Y always
     if (is_vertical_mesh) {
-      if (coords[2] < _dim_sizes[2] - 1) net_ports++; // Z-up
-      if (coords[2] > 0) net_ports++;                 // Z-down
+      if (coords[2] < _dim_sizes[2] - 1) net_ports += _dim_bandwidth[2]; // Z-up
+      if (coords[2] > 0) net_ports += _dim_bandwidth[2];                 // Z-down
     } else {
-      net_ports++; // Z torus
+      net_ports += (_dim_sizes.size() > 2) ? _dim_bandwidth[2] : 1; // Z torus
     }
     int total_ports = net_ports + 1; // + PE
     if (_debug) cout << "DEBUG: Node " << node << " coords(" << coords[0] << "," << coords[1] << "," << coords[2] << ") gets " << total_ports << " ports" << endl;
@@ -440,77 +470,101 @@ void UniTorus::_BuildNet( const Configuration &config )
 
   // Connect all the channels after all routers are created
   int channel_counter = 0;
+  _chan_dir.resize(_channels);
+  _chan_lane.resize(_channels);
 
   if (_debug) {
     cout << "DEBUG: Starting channel connections, is_vertical_mesh = " << is_vertical_mesh << endl;
     cout << "DEBUG: _channels allocated = " << _channels << endl;
   }
 
-  for ( int node = 0; node < _size; ++node ) {
-    for ( int dim = 0; dim < (int)_dim_sizes.size(); ++dim ) {
+  // Lane 0 of every link is connected first, so the first net ports of each
+  // router keep the X, Y, Z (or Z-up, Z-down) order the routing functions
+  // rely on. The extra lanes follow in the same port order, and the PE port
+  // stays last.
+  for ( int pass = 0; pass < 2; ++pass ) {
+    for ( int node = 0; node < _size; ++node ) {
+      for ( int dim = 0; dim < (int)_dim_sizes.size(); ++dim ) {
+
+        int first_lane = (pass == 0) ? 0 : 1;
+        int last_lane = (pass == 0) ? 1 : _dim_bandwidth[dim];
       
-      if (dim == 2 && is_vertical_mesh) {
-        if (_debug) {
-          cout << "DEBUG: Processing Z-dimension for node " << node << " in mesh mode" << endl;
-        }
-        vector<int> coords = _NodeToCoords(node);
+        if (dim == 2 && is_vertical_mesh) {
+          if (_debug) {
+            cout << "DEBUG: Processing Z-dimension for node " << node << " in mesh mode" << endl;
+          }
+          vector<int> coords = _NodeToCoords(node);
         
-        // Z-up connection (if not at top layer)
-        if (coords[2] < _dim_sizes[2] - 1) {
-          int up_node = node + (_dim_sizes[0] * _dim_sizes[1]);
-          int up_channel = channel_counter;
+          // Z-up connection (if not at top layer)
+          for (int lane = first_lane; lane < last_lane && coords[2] < _dim_sizes[2] - 1; ++lane) {
+            int up_node = node + (_dim_sizes[0] * _dim_sizes[1]);
+            int up_channel = channel_counter;
           
-          if (up_channel >= _channels) {
-            cout << "ERROR: Z-up channel " << up_channel << " exceeds allocated channels " << _channels << endl;
-            exit(-1);
-          }
+            if (up_channel >= _channels) {
+              cout << "ERROR: Z-up channel " << up_channel << " exceeds allocated channels " << _channels << endl;
+              exit(-1);
+            }
           
-          _routers[node]->AddOutputChannel(_chan[up_channel], _chan_cred[up_channel]);
-          _routers[up_node]->AddInputChannel(_chan[up_channel], _chan_cred[up_channel]);
+            _routers[node]->AddOutputChannel(_chan[up_channel], _chan_cred[up_channel]);
+            _routers[up_node]->AddInputChannel(_chan[up_channel], _chan_cred[up_channel]);
           
-          _chan[up_channel]->SetLatency(_dim_latency[dim]);
-          _chan_cred[up_channel]->SetLatency(_dim_latency[dim]);
-          channel_counter++;
-        }
+            _chan[up_channel]->SetLatency(_dim_latency[dim]);
+            _chan_cred[up_channel]->SetLatency(_dim_latency[dim]);
+            _chan_dir[up_channel] = "z+";
+            _chan_lane[up_channel] = lane;
+            channel_counter++;
+          }
         
-        // Z-down connection (if not at bottom layer)
-        if (coords[2] > 0) {
-          int down_node = node - (_dim_sizes[0] * _dim_sizes[1]);
-          int down_channel = channel_counter;
+          // Z-down connection (if not at bottom layer)
+          for (int lane = first_lane; lane < last_lane && coords[2] > 0; ++lane) {
+            int down_node = node - (_dim_sizes[0] * _dim_sizes[1]);
+            int down_channel = channel_counter;
           
-          if (down_channel >= _channels) {
-            cout << "ERROR: Z-down channel " << down_channel << " exceeds allocated channels " << _channels << endl;
-            exit(-1);
-          }
+            if (down_channel >= _channels) {
+              cout << "ERROR: Z-down channel " << down_channel << " exceeds allocated channels " << _channels << endl;
+              exit(-1);
+            }
           
-          _routers[node]->AddOutputChannel(_chan[down_channel], _chan_cred[down_channel]);
-          _routers[down_node]->AddInputChannel(_chan[down_channel], _chan_cred[down_channel]);
+            _routers[node]->AddOutputChannel(_chan[down_channel], _chan_cred[down_channel]);
+            _routers[down_node]->AddInputChannel(_chan[down_channel], _chan_cred[down_channel]);
           
-          _chan[down_channel]->SetLatency(_dim_latency[dim]);
-          _chan_cred[down_channel]->SetLatency(_dim_latency[dim]);
-          channel_counter++;
-        }
+            _chan[down_channel]->SetLatency(_dim_latency[dim]);
+            _chan_cred[down_channel]->SetLatency(_dim_latency[dim]);
+            _chan_dir[down_channel] = "z-";
+            _chan_lane[down_channel] = lane;
+            channel_counter++;
+          }
         
-      } else {
-        // Normal X,Y dimension connections
-        int next_node = _NextNode( node, dim );
-        int channel = channel_counter;
+        } else {
+          // Normal X,Y dimension connections
+          for (int lane = first_lane; lane < last_lane; ++lane) {
+            int next_node = _NextNode( node, dim );
+            int channel = channel_counter;
 
-        if (_debug) {
-          cout << "DEBUG: Normal connection dim " << dim << " - node " << node 
-              << " -> node " << next_node << " via channel " << channel << endl;
-        }
+            if (_debug) {
+              cout << "DEBUG: Normal connection dim " << dim << " lane " << lane << " - node " << node 
+                  << " -> node " << next_node << " via channel " << channel << endl;
+            }
 
-        _routers[node]->AddOutputChannel(_chan[channel], _chan_cred[channel]);
-        _routers[next_node]->AddInputChannel(_chan[channel], _chan_cred[channel]);
+            _routers[node]->AddOutputChannel(_chan[channel], _chan_cred[channel]);
+            _routers[next_node]->AddInputChannel(_chan[channel], _chan_cred[channel]);
 
-        _chan[channel]->SetLatency( _dim_latency[dim] );
-        _chan_cred[channel]->SetLatency( _dim_latency[dim] );
-        channel_counter++;
+            _chan[channel]->SetLatency( _dim_latency[dim] );
+            _chan_cred[channel]->SetLatency( _dim_latency[dim] );
+            _chan_dir[channel] = (dim < 3) ? string(1, "xyz"[dim]) : "d" + to_string(dim);
+            _chan_lane[channel] = lane;
+            channel_counter++;
+          }
+        }
       }
     }
   }
 
+  if (channel_counter != _channels) {
+    cerr << "ERROR: Connected " << channel_counter << " channels but allocated " << _channels << endl;
+    exit(-1);
+  }
+
   
   // Add injection and ejection channels for all routers
   for ( int node = 0; node < _size; ++node ) {
@@ -523,6 +577,11 @@ void UniTorus::_BuildNet( const Configuration &config )
     _eject_cred[node]->SetLatency( 1 );
   }
 
+  // Routing tables depend on the final port layout of every router
+  map<string, tRoutingFunction>::const_iterator rf_iter =
+    gRoutingFunctionMap.find(config.GetStr("routing_function") + "_unitorus");
+  BuildUniTorusRoutes(config, _routers, (rf_iter != gRoutingFunctionMap.end()) ? rf_iter->second : NULL);
+
   // After ALL channel connections (including injection/ejection)
   if (_debug) {
     cout << "DEBUG: Final port usage validation:" << endl;
@@ -530,17 +589,17 @@ void UniTorus::_BuildNet( const Configuration &config )
       vector<int> coords = _NodeToCoords(node);
       
       // Count expected connections for this router
-      int expected_inputs = 2;  // X, Y inputs
-      int expected_outputs = 2; // X, Y outputs
+      int expected_inputs = _dim_bandwidth[0] + _dim_bandwidth[1];  // X, Y inputs
+      int expected_outputs = _dim_bandwidth[0] + _dim_bandwidth[1]; // X, Y outputs
       
       if (is_vertical_mesh) {
-        if (coords[2] < _dim_sizes[2] - 1) expected_outputs++; // Z-up output
-        if (coords[2] > 0) expected_outputs++;                 // Z-down output
-        if (coords[2] > 0) expected_inputs++;                  // Z-down input 
-        if (coords[2] < _dim_sizes[2] - 1) expected_inputs++;  // Z-up input
+        if (coords[2] < _dim_sizes[2] - 1) expected_outputs += _dim_bandwidth[2]; // Z-up output
+        if (coords[2] > 0) expected_outputs += _dim_bandwidth[2];                 // Z-down output
+        if (coords[2] > 0) expected_inputs += _dim_bandwidth[2];                  // Z-down input 
+        if (coords[2] < _dim_sizes[2] - 1) expected_inputs += _dim_bandwidth[2];  // Z-up input
       } else {
-        expected_inputs++;  // Z input
-        expected_outputs++; // Z output  
+        expected_inputs += (_dim_sizes.size() > 2) ? _dim_bandwidth[2] : 1;  // Z input
+        expected_outputs += (_dim_sizes.size() > 2) ? _dim_bandwidth[2] : 1; // Z output  
       }
       
       expected_inputs++;  // PE injection
@@ -653,6 +712,229 @@ void UniTorus::_ParseElevatorMapping(const string& mapping_str) {
     gElevatorMapping = _nearest_elevator;
 }
 
+// Rows of a CSV elevator file with the given number of integer fields; an
+// optional header row (e.g. "x,y") and empty lines are skipped
+vector<vector<int> > UniTorus::_ReadElevatorFile( const string & filename,
+                                                  int fields,
+                                                  vector<int> const & dim_sizes )
+{
+  ifstream in( filename.c_str( ) );
+  if ( !in ) {
+    cerr << "Error: Could not open elevator_file " << filename << endl;
+    exit(-1);
+  }
+  vector<vector<int> > rows;
+  string line;
+  int line_num = 0;
+  while ( getline( in, line ) ) {
+    ++line_num;
+    size_t const first = line.find_first_not_of( " \t\r" );
+    if ( first == string::npos ) {
+      continue;
+    }
+    if ( ( line_num == 1 ) && !isdigit( line[first] ) ) {
+      continue;
+    }
+    vector<int> row;
+    istringstream tokens( line );
+    string token;
+    while ( getline( tokens, token, ',' ) ) {
+      char * end;
+      long const value = strtol( token.c_str( ), &end, 10 );
+      if ( ( end == token.c_str( ) ) ||
+           ( token.find_first_not_of( " \t\r", end - token.c_str( ) ) != string::npos ) ) {
+        cerr << "Error: Invalid value \"" << token << "\" on line " << line_num
+             << " of elevator_file " << filename << endl;
+        exit(-1);
+      }
+      row.push_back( value );
+    }
+    if ( (int)row.size( ) != fields ) {
+      cerr << "Error: Expected " << fields << " values on line " << line_num
+           << " of elevator_file " << filename << ", found " << row.size( ) << endl;
+      exit(-1);
+    }
+    for ( int i = 0; i < fields; ++i ) {
+      if ( ( row[i] < 0 ) || ( row[i] >= dim_sizes[i % 2] ) ) {
+        cerr << "Error: Coordinate " << row[i] << " on line " << line_num
+             << " of elevator_file " << filename << " is outside of the "
+             << dim_sizes[0] << "x" << dim_sizes[1] << " layer" << endl;
+        exit(-1);
+      }
+    }
+    rows.push_back( row );
+  }
+  return rows;
+}
+
+// Position of an offset (dx, dy) among all offsets with the same number of
+// hops in the middle-out search of utils/elevator/map.py: the most diagonal
+// offsets come first
+static int _MiddleOutRank( int dx, int dy )
+{
+  int const half = ( dx + dy + 1 ) / 2;
+  return ( dx >= half ) ? 2 * ( dx - half ) : 2 * ( half - dx ) - 1;
+}
+
+// Index of the elevator nearest to column (x, y) on the unidirectional X and
+// Y rings (ties in middle-out order), only considering elevators in the
+// same tile x tile tile if tile is positive; -1 if there is none
+int UniTorus::NearestElevator( int x, int y, int width, int height,
+                               vector<vector<int> > const & elevators, int tile )
+{
+  int best = -1;
+  int best_hops = 0;
+  int best_rank = 0;
+  for ( int e = 0; e < (int)elevators.size( ); ++e ) {
+    int const ex = elevators[e][0];
+    int const ey = elevators[e][1];
+    if ( tile && ( ( ex / tile != x / tile ) || ( ey / tile != y / tile ) ) ) {
+      continue;
+    }
+    int const dx = ( ex - x + width ) % width;
+    int const dy = ( ey - y + height ) % height;
+    int const rank = _MiddleOutRank( dx, dy );
+    if ( ( best < 0 ) || ( dx + dy < best_hops ) ||
+         ( ( dx + dy == best_hops ) && ( rank < best_rank ) ) ) {
+      best = e;
+      best_hops = dx + dy;
+      best_rank = rank;
+    }
+  }
+  return best;
+}
+
+// Builds the elevator mapping from elevator_assignment, instead of a
+// literal elevator_mapping_coords table:
+//  - nearest: every column uses the elevator of elevator_file (x,y rows)
+//    with the fewest hops on the unidirectional X and Y rings; ties go to
+//    the more diagonal path, in the order of utils/elevator/map.py
+//  - tiled: the layer is cut into elevator_tile x elevator_tile tiles and
+//    every column uses the nearest elevator of its tile; without an
+//    elevator_file, each tile gets one at its last column (highest x and y)
+//  - checkerboard: columns with an even x + y are elevators, all other
+//    columns use their +X neighbour (their +Y neighbour in the last column
+//    of an odd width, where +X wraps to a column of the same parity)
+//  - table: elevator_file has an x,y,elevator_x,elevator_y row per column
+// Returns false if nearest or table is selected without an elevator_file.
+bool UniTorus::AssignElevators( const Configuration &config,
+                                vector<int> const & dim_sizes,
+                                vector<vector<int> > * mapping )
+{
+  string const assignment = config.GetStr( "elevator_assignment" );
+  string const filename = config.GetStr( "elevator_file" );
+  bool const generated = ( assignment == "tiled" ) || ( assignment == "checkerboard" );
+  if ( filename.empty( ) && !generated ) {
+    if ( ( assignment != "nearest" ) && ( assignment != "table" ) ) {
+      cerr << "Error: Unknown elevator_assignment " << assignment << endl;
+      exit(-1);
+    }
+    return false;
+  }
+
+  int const width = dim_sizes[0];
+  int const height = dim_sizes[1];
+  int const columns = width * height;
+  vector<vector<int> > & nearest = *mapping;
+  nearest.assign( columns, vector<int>( ) );
+
+  if ( assignment == "table" ) {
+    vector<vector<int> > const rows = _ReadElevatorFile( filename, 4, dim_sizes );
+    for ( size_t i = 0; i < rows.size( ); ++i ) {
+      int const c = rows[i][1] * width + rows[i][0];
+      if ( !nearest[c].empty( ) ) {
+        cerr << "Error: Column (" << rows[i][0] << "," << rows[i][1]
+             << ") is listed twice in elevator_file " << filename << endl;
+        exit(-1);
+      }
+      nearest[c] = { rows[i][2], rows[i][3] };
+    }
+    for ( int c = 0; c < columns; ++c ) {
+      if ( nearest[c].empty( ) ) {
+        cerr << "Error: Column (" << c % width << "," << c / width
+             << ") has no elevator in elevator_file " << filename << endl;
+        exit(-1);
+      }
+    }
+  } else if ( assignment == "checkerboard" ) {
+    for ( int c = 0; c < columns; ++c ) {
+      int const x = c % width;
+      int const y = c / width;
+      if ( ( ( x + y ) % 2 ) == 0 ) {
+        nearest[c] = { x, y };
+      } else if ( ( ( ( x + 1 ) % width + y ) % 2 ) == 0 ) {
+        nearest[c] = { ( x + 1 ) % width, y };
+      } else {
+        // last column of an odd width, so x is even and y is odd: y + 1 is
+        // even or wraps to row 0, an elevator one hop away either way
+        nearest[c] = { x, ( y + 1 ) % height };
+      }
+    }
+  } else {
+    vector<vector<int> > elevators;
+    int tile = 0;
+    if ( assignment == "tiled" ) {
+      tile = config.GetInt( "elevator_tile" );
+      if ( tile < 1 ) {
+        cerr << "Error: elevator_tile must be positive." << endl;
+        exit(-1);
+      }
+    } else if ( assignment != "nearest" ) {
+      cerr << "Error: Unknown elevator_assignment " << assignment << endl;
+      exit(-1);
+    }
+    if ( !filename.empty( ) ) {
+      elevators = _ReadElevatorFile( filename, 2, dim_sizes );
+    } else {
+      for ( int y = tile - 1; y < height + tile - 1; y += tile ) {
+        for ( int x = tile - 1; x < width + tile - 1; x += tile ) {
+          elevators.push_back( { min( x, width - 1 ), min( y, height - 1 ) } );
+        }
+      }
+    }
+    if ( elevators.empty( ) ) {
+      cerr << "Error: elevator_file " << filename << " lists no elevators." << endl;
+      exit(-1);
+    }
+
+    for ( int c = 0; c < columns; ++c ) {
+      int const x = c % width;
+      int const y = c / width;
+      int const best = NearestElevator( x, y, width, height, elevators, tile );
+      if ( best < 0 ) {
+        cerr << "Error: The tile of column (" << x << "," << y
+             << ") has no elevator in elevator_file " << filename << endl;
+        exit(-1);
+      }
+      nearest[c] = elevators[best];
+    }
+  }
+
+  return true;
+}
+
+bool UniTorus::_AssignElevators( const Configuration &config )
+{
+  if ( !AssignElevators( config, _dim_sizes, &_nearest_elevator ) ) {
+    return false;
+  }
+  gElevatorMapping = _nearest_elevator;
+
+  if ( _debug ) {
+    int const width = _dim_sizes[0];
+    int const height = _dim_sizes[1];
+    cout << "Elevator mapping (" << config.GetStr( "elevator_assignment" ) << "):" << endl;
+    for ( int y = 0; y < height; ++y ) {
+      for ( int x = 0; x < width; ++x ) {
+        vector<int> const & e = _nearest_elevator[y * width + x];
+        cout << " " << e[0] << "," << e[1];
+      }
+      cout << endl;
+    }
+  }
+  return true;
+}
+
 const vector<vector<int>>& UniTorus::GetNearestElevatorMapping() const {
     return _nearest_elevator;
 }
@@ -688,6 +970,20 @@ vector<int> UniTorus::_NodeToCoords( int node ) const
   return coords;
 }
 
+void UniTorus::_WriteChannelKeyHeader( ostream & os ) const
+{
+  os << "x,y,z,dir,lane";
+}
+
+// channels are keyed by the coordinates of the router driving them
+void UniTorus::_WriteChannelKey( ostream & os, int c ) const
+{
+  vector<int> coords = _NodeToCoords(_chan[c]->GetSource()->GetID());
+  coords.resize(3, 0);
+  os << coords[0] << ',' << coords[1] << ',' << coords[2] << ','
+     << _chan_dir[c] << ',' << _chan_lane[c];
+}
+
 int UniTorus::_CoordsToNode( const vector<int>& coords ) const
 {
   int node = 0;
@@ -4,6 +4,7 @@
 #define _UNITORUS_HPP_
 
 #include "network.hpp"
+#include "elevator_stats.hpp"
 #include <vector>
 
 class UniTorus : public Network {
@@ -16,6 +17,13 @@ class UniTorus : public Network {
   vector<float> _dim_penalty;
   vector<vector<int>> _nearest_elevator; 
   string _vertical_topology;
+
+  // direction ("x", "y", "z", "z+" or "z-") and lane of every channel
+  vector<string> _chan_dir;
+  vector<int> _chan_lane;
+
+  // usage of the vertical channels, if elevator_stats is set
+  ElevatorStats * _elevator_stats;
   
   // Debug flag
   bool _debug;
@@ -24,6 +32,10 @@ class UniTorus : public Network {
   void _BuildNet( const Configuration &config );
   void _ParseDirectionConfig( const Configuration &config );
   void _ParseElevatorMapping( const string& mapping_str );
+  bool _AssignElevators( const Configuration &config );
+  static vector<vector<int> > _ReadElevatorFile( const string & filename,
+                                                 int fields,
+                                                 vector<int> const & dim_sizes );
 
   // Unidirectional helper functions (only positive direction)
   int _NextChannel( int node, int dim );
@@ -33,12 +45,27 @@ class UniTorus : public Network {
   vector<int> _NodeToCoords( int node ) const;
   int _CoordsToNode( const vector<int>& coords ) const;
 
+  virtual void _WriteChannelKeyHeader( ostream & os ) const;
+  virtual void _WriteChannelKey( ostream & os, int c ) const;
+
 public:
   UniTorus( const Configuration &config, const string & name );
+  ~UniTorus( );
   static void RegisterRoutingFunctions();
 
   const vector<vector<int>>& GetNearestElevatorMapping() const;
 
+  // elevator assignment of elevator_assignment = nearest (and tiled), also
+  // used by the elevator placement search
+  static int NearestElevator( int x, int y, int width, int height,
+                              vector<vector<int> > const & elevators,
+                              int tile = 0 );
+  // mapping of elevator_file / elevator_assignment for the given dim_sizes;
+  // false if the configuration has none (a literal elevator_mapping_coords)
+  static bool AssignElevators( const Configuration &config,
+                               vector<int> const & dim_sizes,
+                               vector<vector<int> > * mapping );
+
   int GetN( ) const;
   int GetDimSize( int dim ) const;
   const vector<int>& GetDimSizes( ) const;
@@ -47,6 +74,8 @@ public:
 
   double Capacity( ) const;
 
+  ElevatorStats * GetElevatorStats( ) const { return _elevator_stats; }
+
   void InsertRandomFaults( const Configuration &config );
 
 };
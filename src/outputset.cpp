@@ -38,9 +38,45 @@
 #include "booksim.hpp"
 #include "outputset.hpp"
 
+OutputSet::OutputSet( )
+  : _elements( _inline ), _size( 0 ), _capacity( _inline_size )
+{
+}
+
+OutputSet::OutputSet( OutputSet const & other )
+  : _elements( _inline ), _size( 0 ), _capacity( _inline_size )
+{
+  *this = other;
+}
+
+OutputSet & OutputSet::operator=( OutputSet const & other )
+{
+  if ( this != &other ) {
+    if ( other._size > _capacity ) {
+      if ( _elements != _inline ) {
+        delete [] _elements;
+      }
+      _elements = new sSetElement[other._capacity];
+      _capacity = other._capacity;
+    }
+    for ( int i = 0; i < other._size; ++i ) {
+      _elements[i] = other._elements[i];
+    }
+    _size = other._size;
+  }
+  return *this;
+}
+
+OutputSet::~OutputSet( )
+{
+  if ( _elements != _inline ) {
+    delete [] _elements;
+  }
+}
+
 void OutputSet::Clear( )
 {
-  _outputs.clear( );
+  _size = 0;
 }
 
 void OutputSet::Add( int output_port, int vc, int pri  )
@@ -50,47 +86,60 @@ void OutputSet::Add( int output_port, int vc, int pri  )
 
 void OutputSet::AddRange( int output_port, int vc_start, int vc_end, int pri )
 {
+  // higher priorities first; an element with the same priority wins
+  int pos = 0;
+  while ( ( pos < _size ) && ( _elements[pos].pri > pri ) ) {
+    ++pos;
+  }
+  if ( ( pos < _size ) && ( _elements[pos].pri == pri ) ) {
+    return;
+  }
 
-  sSetElement s;
+  if ( _size == _capacity ) {
+    sSetElement * const elements = new sSetElement[2 * _capacity];
+    for ( int i = 0; i < _size; ++i ) {
+      elements[i] = _elements[i];
+    }
+    if ( _elements != _inline ) {
+      delete [] _elements;
+    }
+    _elements = elements;
+    _capacity *= 2;
+  }
 
+  for ( int i = _size; i > pos; --i ) {
+    _elements[i] = _elements[i - 1];
+  }
+  sSetElement & s = _elements[pos];
   s.vc_start = vc_start;
   s.vc_end   = vc_end;
   s.pri      = pri;
   s.output_port = output_port;
-  _outputs.insert( s );
+  ++_size;
 }
 
 //legacy support, for performance, just use GetSet()
 int OutputSet::NumVCs( int output_port ) const
 {
   int total = 0;
-  set<sSetElement>::const_iterator i = _outputs.begin( );
-  while(i!=_outputs.end( )){
+  for ( const_iterator i = begin( ); i != end( ); ++i ) {
     if(i->output_port == output_port){
       total += (i->vc_end - i->vc_start + 1);
     }
-    i++;
   }
   return total;
 }
 
 bool OutputSet::OutputEmpty( int output_port ) const
 {
-  set<sSetElement>::const_iterator i = _outputs.begin( );
-  while(i!=_outputs.end( )){
+  for ( const_iterator i = begin( ); i != end( ); ++i ) {
     if(i->output_port == output_port){
       return false;
     }
-    i++;
   }
   return true;
 }
 
-
-const set<OutputSet::sSetElement> & OutputSet::GetSet() const{
-  return _outputs;
-}
-
 //legacy support, for performance, just use GetSet()
 int OutputSet::GetVC( int output_port, int vc_index, int *pri ) const
 {
@@ -101,8 +150,7 @@ int OutputSet::GetVC( int output_port, int vc_index, int *pri ) const
   
   if ( pri ) { *pri = -1; }
 
-  set<sSetElement>::const_iterator i = _outputs.begin( );
-  while(i!=_outputs.end( )){
+  for ( const_iterator i = begin( ); i != end( ); ++i ) {
     if(i->output_port == output_port){
       range = i->vc_end - i->vc_start + 1;
       if ( remaining >= range ) {
@@ -115,7 +163,6 @@ int OutputSet::GetVC( int output_port, int vc_index, int *pri ) const
 	break;
       }
     }
-    i++;
   }
   return vc;
 }
@@ -128,11 +175,11 @@ bool OutputSet::GetPortVC( int *out_port, int *out_vc ) const
   bool single_output = false;
   int  used_outputs  = 0;
 
-  set<sSetElement>::const_iterator i = _outputs.begin( );
-  if(i!=_outputs.end( )){
+  const_iterator i = begin( );
+  if(i!=end( )){
     used_outputs = i->output_port;
   }
-  while(i!=_outputs.end( )){
+  while(i!=end( )){
 
     if ( i->vc_start == i->vc_end ) {
       *out_vc   = i->vc_start;
@@ -28,8 +28,10 @@
 #ifndef _OUTPUTSET_HPP_
 #define _OUTPUTSET_HPP_
 
-#include <set>
-
+// Route candidates, ordered by decreasing priority; like the std::set this
+// used to be, at most one element is kept per priority (the first one
+// added). Elements are stored inline unless a routing function produces
+// more than _inline_size of them, so routing does not touch the heap.
 class OutputSet {
 
 
@@ -41,6 +43,13 @@ public:
     int output_port;
   };
 
+  typedef sSetElement const * const_iterator;
+
+  OutputSet( );
+  OutputSet( OutputSet const & other );
+  OutputSet & operator=( OutputSet const & other );
+  ~OutputSet( );
+
   void Clear( );
   void Add( int output_port, int vc, int pri = 0 );
   void AddRange( int output_port, int vc_start, int vc_end, int pri = 0 );
@@ -48,19 +57,22 @@ public:
   bool OutputEmpty( int output_port ) const;
   int NumVCs( int output_port ) const;
   
-  const set<sSetElement> & GetSet() const;
+  // elements can be iterated over directly
+  inline const OutputSet & GetSet() const { return *this; }
+  inline const_iterator begin( ) const { return _elements; }
+  inline const_iterator end( ) const { return _elements + _size; }
+  inline int size( ) const { return _size; }
+  inline bool empty( ) const { return _size == 0; }
 
   int  GetVC( int output_port,  int vc_index, int *pri = 0 ) const;
   bool GetPortVC( int *out_port, int *out_vc ) const;
 private:
-  set<sSetElement> _outputs;
-};
+  enum { _inline_size = 8 };
 
-inline bool operator<(const OutputSet::sSetElement & se1, 
-	       const OutputSet::sSetElement & se2) {
-  return se1.pri > se2.pri; // higher priorities first!
-}
+  sSetElement * _elements;
+  int _size;
+  int _capacity;
+  sSetElement _inline[_inline_size];
+};
 
 #endif
-
-
@@ -0,0 +1,132 @@
+// $Id$
+
+/*packet_trace.cpp
+ *
+ *Memory-mapped packet trace reader for trace-driven injection
+ *
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "packet_trace.hpp"
+
+static char const _magic[] = "BSPKTRC1";
+static off_t const _header_size = 8;
+
+PacketTrace::PacketTrace( string const & filename, size_t window )
+  : _filename( filename ), _map( NULL ), _map_offset( 0 ), _map_size( 0 )
+{
+  _fd = open( filename.c_str( ), O_RDONLY );
+  if ( _fd < 0 ) {
+    cerr << "Error: Could not open packet trace " << filename << endl;
+    exit(-1);
+  }
+  struct stat st;
+  if ( fstat( _fd, &st ) != 0 ) {
+    cerr << "Error: Could not stat packet trace " << filename << endl;
+    exit(-1);
+  }
+  _file_size = st.st_size;
+
+  char magic[_header_size];
+  if ( ( pread( _fd, magic, _header_size, 0 ) != _header_size ) ||
+       ( memcmp( magic, _magic, _header_size ) != 0 ) ) {
+    cerr << "Error: " << filename << " is not a packet trace." << endl;
+    exit(-1);
+  }
+  if ( ( _file_size - _header_size ) % sizeof( Record ) ) {
+    cerr << "Error: Packet trace " << filename << " is truncated." << endl;
+    exit(-1);
+  }
+
+  // whole pages, and large enough to hold a record at any page offset
+  size_t const page = sysconf( _SC_PAGESIZE );
+  _window = ( ( window + page - 1 ) / page ) * page;
+  if ( _window < 2 * page ) {
+    _window = 2 * page;
+  }
+
+  Rewind( );
+}
+
+PacketTrace::~PacketTrace( )
+{
+  _Unmap( );
+  close( _fd );
+}
+
+void PacketTrace::_Unmap( )
+{
+  if ( _map ) {
+    munmap( _map, _map_size );
+    _map = NULL;
+    _map_size = 0;
+  }
+}
+
+void PacketTrace::_Map( off_t offset )
+{
+  _Unmap( );
+  size_t const page = sysconf( _SC_PAGESIZE );
+  _map_offset = ( offset / page ) * page;
+  _map_size = _window;
+  if ( (off_t)_map_size > _file_size - _map_offset ) {
+    _map_size = _file_size - _map_offset;
+  }
+  void * const map = mmap( NULL, _map_size, PROT_READ, MAP_PRIVATE, _fd,
+                           _map_offset );
+  if ( map == MAP_FAILED ) {
+    cerr << "Error: Could not map packet trace " << _filename
+         << " at offset " << _map_offset << endl;
+    exit(-1);
+  }
+  _map = (char *)map;
+  madvise( _map, _map_size, MADV_SEQUENTIAL );
+}
+
+void PacketTrace::_Fetch( )
+{
+  _has_next = ( _pos + (off_t)sizeof( Record ) <= _file_size );
+  if ( !_has_next ) {
+    _Unmap( );
+    return;
+  }
+  if ( !_map || ( _pos < _map_offset ) ||
+       ( _pos + sizeof( Record ) > _map_offset + _map_size ) ) {
+    _Map( _pos );
+  }
+  memcpy( &_next, _map + ( _pos - _map_offset ), sizeof( Record ) );
+}
+
+void PacketTrace::Rewind( )
+{
+  Seek( 0 );
+}
+
+long PacketTrace::Position( ) const
+{
+  return ( _pos - _header_size ) / sizeof( Record );
+}
+
+void PacketTrace::Seek( long position )
+{
+  if ( ( position < 0 ) || ( position > NumRecords( ) ) ) {
+    cerr << "Error: Position " << position << " is outside of packet trace "
+         << _filename << endl;
+    exit(-1);
+  }
+  _pos = _header_size + position * sizeof( Record );
+  _Fetch( );
+}
+
+long PacketTrace::NumRecords( ) const
+{
+  return ( _file_size - _header_size ) / sizeof( Record );
+}
@@ -0,0 +1,65 @@
+// $Id$
+
+#ifndef _PACKET_TRACE_HPP_
+#define _PACKET_TRACE_HPP_
+
+#include <string>
+#include <sys/types.h>
+
+using namespace std;
+
+// Packet trace for trace-driven injection (packet_trace). The file is read
+// sequentially through a sliding memory-mapped window of packet_trace_window
+// bytes, so traces larger than memory can be replayed; pages behind the
+// window are unmapped as it advances.
+//
+// File layout: the 8 byte magic "BSPKTRC1", then an array of Record, sorted
+// by time. utils/csv2packettrace.py writes traces from CSV.
+class PacketTrace {
+
+public:
+  struct Record {
+    int time;   // cycle the packet is created
+    int src;
+    int dest;
+    int size;   // flits
+    int type;   // Flit::FlitType
+  };
+
+private:
+  string _filename;
+  int _fd;
+  off_t _file_size;
+  size_t _window;
+
+  // mapped window [_map_offset, _map_offset + _map_size) of the file
+  char * _map;
+  off_t _map_offset;
+  size_t _map_size;
+
+  off_t _pos;          // file offset of the next record
+  Record _next;
+  bool _has_next;
+
+  void _Map( off_t offset );
+  void _Unmap( );
+  void _Fetch( );
+
+public:
+  PacketTrace( string const & filename, size_t window );
+  ~PacketTrace( );
+
+  // next record, or NULL at the end of the trace
+  inline Record const * Peek( ) const { return _has_next ? &_next : NULL; }
+  inline void Pop( ) { _pos += sizeof( Record ); _Fetch( ); }
+
+  void Rewind( );
+
+  // Checkpoints: index of the next record
+  long Position( ) const;
+  void Seek( long position );
+
+  long NumRecords( ) const;
+};
+
+#endif
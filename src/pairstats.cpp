@@ -0,0 +1,94 @@
+// $Id$
+
+/*pairstats.cpp
+ *
+ *Dense per source/destination pair latency statistics
+ *
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "booksim.hpp"
+#include "pairstats.hpp"
+
+PairStats::PairStats( Module * parent, const string & name, int nodes,
+                      bool sketch )
+  : Module( parent, name ), _nodes( nodes ), _sketch( sketch )
+{
+  Clear( );
+}
+
+void PairStats::Clear( )
+{
+  _Entry const empty = { 0, 0, 0, 0.0 };
+  _entries.assign( _nodes * _nodes, empty );
+  if ( _sketch ) {
+    _sketch_hist.assign( _nodes * _nodes * sketch_buckets, 0 );
+  }
+}
+
+int PairStats::_SketchBucket( int val )
+{
+  if ( val < 1 ) {
+    return 0;
+  }
+  int const b = 32 - __builtin_clz( (unsigned int)val );
+  return ( b < sketch_buckets ) ? b : ( sketch_buckets - 1 );
+}
+
+double PairStats::Percentile( int src, int dest, double q ) const
+{
+  int const p = src * _nodes + dest;
+  _Entry const & e = _entries[p];
+  if ( !_sketch || ( e.count == 0 ) ) {
+    return numeric_limits<double>::quiet_NaN( );
+  }
+  double const rank = fmax( ceil( q * (double)e.count ), 1.0 );
+  double count = 0.0;
+  for ( int b = 0; b < sketch_buckets; ++b ) {
+    count += _sketch_hist[p * sketch_buckets + b];
+    if ( count >= rank ) {
+      double const high = ldexp( 1.0, b ) - 1.0;
+      return fmax( fmin( high, (double)e.max ), (double)e.min );
+    }
+  }
+  return (double)e.max;
+}
+
+void PairStats::WriteCSV( ostream & os, const string & prefix ) const
+{
+  for ( int i = 0; i < _nodes; ++i ) {
+    for ( int j = 0; j < _nodes; ++j ) {
+      _Entry const & e = _entries[i * _nodes + j];
+      if ( e.count == 0 ) {
+        continue;
+      }
+      os << prefix << "," << i << "," << j << "," << e.count << ","
+         << e.sum / (double)e.count << "," << e.min << "," << e.max;
+      if ( _sketch ) {
+        os << "," << Percentile( i, j, 0.5 )
+           << "," << Percentile( i, j, 0.9 )
+           << "," << Percentile( i, j, 0.99 );
+      }
+      os << '\n';
+    }
+  }
+}
+
+void PairStats::WriteBinary( ostream & os ) const
+{
+  int const header[2] = { _nodes, _sketch ? (int)sketch_buckets : 0 };
+  os.write( (char const *)header, sizeof( header ) );
+  for ( size_t p = 0; p < _entries.size( ); ++p ) {
+    _Entry const & e = _entries[p];
+    os.write( (char const *)&e.count, sizeof( e.count ) );
+    os.write( (char const *)&e.min, sizeof( e.min ) );
+    os.write( (char const *)&e.max, sizeof( e.max ) );
+    os.write( (char const *)&e.sum, sizeof( e.sum ) );
+  }
+  if ( _sketch && !_sketch_hist.empty( ) ) {
+    os.write( (char const *)&_sketch_hist[0],
+              _sketch_hist.size( ) * sizeof( int ) );
+  }
+}
@@ -0,0 +1,93 @@
+// $Id$
+
+#ifndef _PAIRSTATS_HPP_
+#define _PAIRSTATS_HPP_
+
+#include <vector>
+#include <iostream>
+
+#include "module.hpp"
+
+// Latency statistics for every source/destination pair (pair_stats). A
+// single Stats module per pair costs a name, a histogram and a heap
+// allocation each, which does not scale to networks with hundreds of
+// nodes; PairStats instead keeps one compact entry per pair in a single
+// contiguous array. The optional sketch (pair_stats_sketch) adds a
+// power-of-two histogram per pair for coarse percentiles.
+class PairStats : public Module {
+
+public:
+  // power-of-two sketch buckets: bucket 0 holds samples below 1, bucket b
+  // samples in [2^(b-1), 2^b), and the last bucket everything above
+  enum { sketch_buckets = 16 };
+
+private:
+  struct _Entry {
+    int count;
+    int min;
+    int max;
+    double sum;
+  };
+
+  int _nodes;
+  bool _sketch;
+
+  vector<_Entry> _entries;
+  vector<int> _sketch_hist;
+
+  static int _SketchBucket( int val );
+
+public:
+  PairStats( Module * parent, const string & name, int nodes,
+             bool sketch = false );
+
+  void Clear( );
+
+  inline void AddSample( int src, int dest, int val ) {
+    int const p = src * _nodes + dest;
+    _Entry & e = _entries[p];
+    if ( e.count == 0 ) {
+      e.min = val;
+      e.max = val;
+    } else {
+      e.min = ( val < e.min ) ? val : e.min;
+      e.max = ( val > e.max ) ? val : e.max;
+    }
+    ++e.count;
+    e.sum += (double)val;
+    if ( _sketch ) {
+      ++_sketch_hist[p * sketch_buckets + _SketchBucket( val )];
+    }
+  }
+
+  int NumSamples( int src, int dest ) const {
+    return _entries[src * _nodes + dest].count;
+  }
+  double Average( int src, int dest ) const {
+    _Entry const & e = _entries[src * _nodes + dest];
+    return e.sum / (double)e.count;
+  }
+  int Min( int src, int dest ) const {
+    return _entries[src * _nodes + dest].min;
+  }
+  int Max( int src, int dest ) const {
+    return _entries[src * _nodes + dest].max;
+  }
+
+  bool HasSketch( ) const { return _sketch; }
+
+  // upper bound of the sketch bucket holding the q-quantile, clamped to the
+  // pair's min and max; NaN without samples or without a sketch
+  double Percentile( int src, int dest, double q ) const;
+
+  // one line per pair with samples:
+  // <prefix>,src,dest,count,avg,min,max[,p50,p90,p99]
+  void WriteCSV( ostream & os, const string & prefix ) const;
+
+  // nodes and sketch buckets (0 without sketch) as ints, followed by count,
+  // min and max (int) and sum (double) for all nodes^2 pairs in row-major
+  // order, followed by the nodes^2 x sketch_buckets sketch counts (int)
+  void WriteBinary( ostream & os ) const;
+};
+
+#endif
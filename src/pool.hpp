@@ -0,0 +1,116 @@
+// $Id$
+
+#ifndef _POOL_HPP_
+#define _POOL_HPP_
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+// Pool for the simulator's short-lived objects (flits, credits, reply
+// records). Objects are constructed in contiguous chunks and are never
+// destroyed individually; free objects are linked through T::_next_free.
+// Each thread keeps its own free list, so only allocating a new chunk takes
+// a lock. FreeAll() releases whole chunks and must not be called while
+// worker threads (sim_threads) still hold free objects.
+template<class T>
+class ObjectPool {
+
+  enum { _chunk_size = 256 };
+
+  // Outstanding count of one thread. Only the owning thread writes it, so
+  // updates are plain loads and stores rather than locked read-modify-write
+  // operations. Counters are registered on first use and kept for the
+  // lifetime of the process, so counts of finished threads still add up.
+  struct _Counter {
+    std::atomic<long> count;
+    _Counter( ) : count( 0 ) { }
+  };
+
+  static void _Count( long n ) {
+    _Counter * c = _counter;
+    if ( !c ) {
+      c = new _Counter;
+      std::lock_guard<std::mutex> lock( _lock );
+      _counters.push_back( c );
+      _counter = c;
+    }
+    c->count.store( c->count.load( std::memory_order_relaxed ) + n,
+                    std::memory_order_relaxed );
+  }
+
+  static std::vector<T *> _chunks;
+  static std::vector<_Counter *> _counters;
+  static std::mutex _lock;
+  static thread_local T * _free;
+  static thread_local _Counter * _counter;
+
+  static T * _NewChunk( ) {
+    T * const chunk = new T[_chunk_size];
+    std::lock_guard<std::mutex> lock( _lock );
+    _chunks.push_back( chunk );
+    return chunk;
+  }
+
+public:
+
+  static T * New( ) {
+    if ( !_free ) {
+      T * const chunk = _NewChunk( );
+      for ( int i = 0; i < _chunk_size - 1; ++i ) {
+        chunk[i]._next_free = &chunk[i + 1];
+      }
+      chunk[_chunk_size - 1]._next_free = 0;
+      _free = chunk;
+    }
+    T * const obj = _free;
+    _free = obj->_next_free;
+    _Count( 1 );
+    return obj;
+  }
+
+  static void Free( T * obj ) {
+    _Count( -1 );
+    obj->_next_free = _free;
+    _free = obj;
+  }
+
+  static void FreeAll( ) {
+    std::lock_guard<std::mutex> lock( _lock );
+    for ( size_t i = 0; i < _chunks.size( ); ++i ) {
+      delete [] _chunks[i];
+    }
+    _chunks.clear( );
+    _free = 0;
+    for ( size_t i = 0; i < _counters.size( ); ++i ) {
+      _counters[i]->count.store( 0, std::memory_order_relaxed );
+    }
+  }
+
+  // objects handed out and not freed yet
+  static long Outstanding( ) {
+    std::lock_guard<std::mutex> lock( _lock );
+    long total = 0;
+    for ( size_t i = 0; i < _counters.size( ); ++i ) {
+      total += _counters[i]->count.load( std::memory_order_relaxed );
+    }
+    return total;
+  }
+  // objects constructed so far
+  static long Allocated( ) {
+    std::lock_guard<std::mutex> lock( _lock );
+    return (long)_chunks.size( ) * _chunk_size;
+  }
+  static long Chunks( ) {
+    std::lock_guard<std::mutex> lock( _lock );
+    return _chunks.size( );
+  }
+};
+
+template<class T> std::vector<T *> ObjectPool<T>::_chunks;
+template<class T> std::vector<typename ObjectPool<T>::_Counter *> ObjectPool<T>::_counters;
+template<class T> std::mutex ObjectPool<T>::_lock;
+template<class T> thread_local T * ObjectPool<T>::_free = 0;
+template<class T> thread_local typename ObjectPool<T>::_Counter * ObjectPool<T>::_counter = 0;
+
+#endif
@@ -28,11 +28,17 @@
 #include "buffer_monitor.hpp"
 
 #include "flit.hpp"
+#include "globals.hpp"
 
 BufferMonitor::BufferMonitor( int inputs, int classes ) 
-: _cycles(0), _inputs(inputs), _classes(classes) {
+: _cycles(0), _inputs(inputs), _classes(classes),
+  _track_occupancy(false), _period_start(0) {
   _reads.resize(inputs * classes, 0) ;
   _writes.resize(inputs * classes, 0) ;
+  _occupancy.resize(inputs, 0) ;
+  _max_occupancy.resize(inputs, 0) ;
+  _last_change.resize(inputs, 0) ;
+  _occupancy_sum.resize(inputs, 0.0) ;
 }
 
 int BufferMonitor::index( int input, int cl ) const {
@@ -45,12 +51,49 @@ void BufferMonitor::cycle() {
   _cycles++ ;
 }
 
-void BufferMonitor::write( int input, Flit const * f ) {
+void BufferMonitor::write( int input, Flit const * f, int occupancy ) {
   _writes[ index(input, f->cl) ]++ ;
+  if ( _track_occupancy ) {
+    _UpdateOccupancy( input, occupancy ) ;
+  }
 }
 
-void BufferMonitor::read( int input, Flit const * f ) {
+void BufferMonitor::read( int input, Flit const * f, int occupancy ) {
   _reads[ index(input, f->cl) ]++ ;
+  if ( _track_occupancy ) {
+    _UpdateOccupancy( input, occupancy ) ;
+  }
+}
+
+void BufferMonitor::_UpdateOccupancy( int input, int occupancy ) {
+  assert(occupancy >= 0);
+  int const now = GetSimTime() ;
+  _occupancy_sum[input] += (double)_occupancy[input] * (double)(now - _last_change[input]) ;
+  _last_change[input] = now ;
+  _occupancy[input] = occupancy ;
+  if ( occupancy > _max_occupancy[input] ) {
+    _max_occupancy[input] = occupancy ;
+  }
+}
+
+void BufferMonitor::ResetOccupancy( vector<int> const & occupancy ) {
+  assert((int)occupancy.size() == _inputs);
+  int const now = GetSimTime() ;
+  _period_start = now ;
+  _occupancy = occupancy ;
+  _max_occupancy = occupancy ;
+  _last_change.assign(_inputs, now) ;
+  _occupancy_sum.assign(_inputs, 0.0) ;
+}
+
+double BufferMonitor::AverageOccupancy( int input ) const {
+  int const now = GetSimTime() ;
+  if ( now <= _period_start ) {
+    return (double)_occupancy[input] ;
+  }
+  double const sum = _occupancy_sum[input] +
+    (double)_occupancy[input] * (double)(now - _last_change[input]) ;
+  return sum / (double)(now - _period_start) ;
 }
 
 void BufferMonitor::display(ostream & os) const {
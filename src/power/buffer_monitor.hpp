@@ -41,12 +41,35 @@ class BufferMonitor {
   int  _classes ;
   vector<int> _reads ;
   vector<int> _writes ;
+
+  // Occupancy of each input buffer (all VCs), only kept when enabled by
+  // TrackOccupancy. The time integral is updated on every read and write,
+  // so the average is exact even for routers the event-driven kernel
+  // skips while they are idle.
+  bool _track_occupancy ;
+  int  _period_start ;
+  vector<int> _occupancy ;
+  vector<int> _max_occupancy ;
+  vector<int> _last_change ;
+  vector<double> _occupancy_sum ;
+  void _UpdateOccupancy( int input, int occupancy ) ;
+
   int index( int input, int cl ) const ;
 public:
   BufferMonitor( int inputs, int classes ) ;
   void cycle() ;
-  void write( int input, Flit const * f ) ;
-  void read( int input, Flit const * f ) ;
+  // occupancy is the number of flits in the input buffer after the access
+  void write( int input, Flit const * f, int occupancy = -1 ) ;
+  void read( int input, Flit const * f, int occupancy = -1 ) ;
+
+  void TrackOccupancy( bool track ) { _track_occupancy = track; }
+  // start a new measurement period with the given current occupancies
+  void ResetOccupancy( vector<int> const & occupancy ) ;
+  // time-averaged and maximum occupancy of an input since the last reset
+  double AverageOccupancy( int input ) const ;
+  inline int MaxOccupancy( int input ) const {
+    return _max_occupancy[input];
+  }
   inline const vector<int> & GetReads() const {
     return _reads;
   }
@@ -27,12 +27,41 @@
 
 #include "random_utils.hpp"
 #include <algorithm>
+#include <sstream>
 #include <cassert>
 
+thread_local RandomStream * gRandomStream = NULL;
+
+void RandomStream::Seed( long seed, int subnet, int id ) {
+  std::seed_seq seq{ (unsigned)seed, (unsigned)( seed >> 32 ), (unsigned)subnet, (unsigned)id };
+  _gen.seed( seq );
+}
+
+std::string RandomStream::GetState( ) const {
+  std::ostringstream os;
+  os << _gen;
+  return os.str( );
+}
+
+void RandomStream::SetState( std::string const & state ) {
+  std::istringstream is( state );
+  is >> _gen;
+  assert( !is.fail( ) );
+}
+
 extern long ran_x[];
 extern double ran_u[];
 #define KK 100
 
+// buffered values and read positions, see rng.c and rng-double.c
+#define QUALITY 1009
+extern long ran_arr_buf[];
+extern long ran_arr_dummy, ran_arr_started;
+extern long * ran_arr_ptr;
+extern double ranf_arr_buf[];
+extern double ranf_arr_dummy, ranf_arr_started;
+extern double * ranf_arr_ptr;
+
 void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u ) {
   save_x.assign(ran_x, ran_x + KK);
   save_u.assign(ran_u, ran_u + KK);
@@ -44,3 +73,47 @@ void RestoreRandomState( std::vector<long> const & save_x, std::vector<double> c
   assert(save_u.size() == KK);
   std::copy(save_u.begin(), save_u.end(), ran_u);
 }
+
+// read positions are stored as an offset into the buffer, or -1 / -2 for
+// the "started" / "not started" sentinels
+template<typename T>
+static long _EncodePointer( T const * ptr, T const * buf, T const * dummy, T const * started ) {
+  if ( ptr == dummy ) {
+    return -2;
+  } else if ( ptr == started ) {
+    return -1;
+  }
+  assert( ( ptr >= buf ) && ( ptr <= buf + QUALITY ) );
+  return ptr - buf;
+}
+
+template<typename T>
+static T * _DecodePointer( long code, T * buf, T * dummy, T * started ) {
+  if ( code == -2 ) {
+    return dummy;
+  } else if ( code == -1 ) {
+    return started;
+  }
+  assert( ( code >= 0 ) && ( code <= QUALITY ) );
+  return buf + code;
+}
+
+void SaveRandomStreams( std::vector<long> & save_x, std::vector<double> & save_u ) {
+  save_x.assign(ran_x, ran_x + KK);
+  save_x.insert(save_x.end(), ran_arr_buf, ran_arr_buf + QUALITY);
+  save_x.push_back(_EncodePointer(ran_arr_ptr, ran_arr_buf, &ran_arr_dummy, &ran_arr_started));
+  save_u.assign(ran_u, ran_u + KK);
+  save_u.insert(save_u.end(), ranf_arr_buf, ranf_arr_buf + QUALITY);
+  save_u.push_back(_EncodePointer(ranf_arr_ptr, ranf_arr_buf, &ranf_arr_dummy, &ranf_arr_started));
+}
+
+void RestoreRandomStreams( std::vector<long> const & save_x, std::vector<double> const & save_u ) {
+  assert(save_x.size() == KK + QUALITY + 1);
+  std::copy(save_x.begin(), save_x.begin() + KK, ran_x);
+  std::copy(save_x.begin() + KK, save_x.begin() + KK + QUALITY, ran_arr_buf);
+  ran_arr_ptr = _DecodePointer(save_x.back(), ran_arr_buf, &ran_arr_dummy, &ran_arr_started);
+  assert(save_u.size() == KK + QUALITY + 1);
+  std::copy(save_u.begin(), save_u.begin() + KK, ran_u);
+  std::copy(save_u.begin() + KK, save_u.begin() + KK + QUALITY, ranf_arr_buf);
+  ranf_arr_ptr = _DecodePointer((long)save_u.back(), ranf_arr_buf, &ranf_arr_dummy, &ranf_arr_started);
+}
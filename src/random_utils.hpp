@@ -29,6 +29,8 @@
 #define _RANDOM_UTILS_HPP_
 
 #include <vector>
+#include <string>
+#include <random>
 
 // interface to Knuth's RANARRAY RNG
 void   ran_start(long seed);
@@ -36,6 +38,32 @@ long   ran_next( );
 void   ranf_start(long seed);
 double ranf_next( );
 
+// Independent random number stream. While a stream is selected on a thread,
+// ran_next and ranf_next (and so all the functions below) draw from it
+// instead of the global generators on that thread. Every router has its own
+// stream, selected while the router is evaluated, so its draws do not depend
+// on the order in which routers are evaluated or on sim_threads.
+class RandomStream {
+  std::mt19937 _gen;
+public:
+  void Seed( long seed, int subnet, int id );
+  // in [0,2^30) as ran_next, and in [0,1) as ranf_next
+  inline long NextLong( ) { return (long)( _gen( ) >> 2 ); }
+  inline double NextDouble( ) {
+    return ( (double)( _gen( ) >> 5 ) * 67108864.0 + (double)( _gen( ) >> 6 ) ) /
+      9007199254740992.0;
+  }
+  std::string GetState( ) const;
+  void SetState( std::string const & state );
+};
+
+extern thread_local RandomStream * gRandomStream;
+
+// selects the stream of the calling thread, NULL for the global generators
+inline void RandomSelectStream( RandomStream * stream ) {
+  gRandomStream = stream;
+}
+
 inline void RandomSeed( long seed ) {
   ran_start( seed );
   ranf_start( seed );
@@ -66,4 +94,10 @@ void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u )
 // Restores the generator state from previously saved values
 void RestoreRandomState( std::vector<long> const & save_x, std::vector<double> const & save_u );
 
+// Saves the complete state of both generators, including the buffered
+// values and read positions that SaveRandomState leaves out; restoring it
+// continues the exact same random number streams (used for checkpoints)
+void SaveRandomStreams( std::vector<long> & save_x, std::vector<double> & save_u );
+void RestoreRandomStreams( std::vector<long> const & save_x, std::vector<double> const & save_u );
+
 #endif
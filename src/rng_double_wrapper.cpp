@@ -28,7 +28,12 @@
 #define main rng_double_main
 #include "rng-double.c"
 
+#include "random_utils.hpp"
+
 double ranf_next( )
 {
+  if ( gRandomStream ) {
+    return gRandomStream->NextDouble( );
+  }
   return ranf_arr_next( );
 }
@@ -28,7 +28,12 @@
 #define main rng_main
 #include "rng.c"
 
+#include "random_utils.hpp"
+
 long ran_next( )
 {
+  if ( gRandomStream ) {
+    return gRandomStream->NextLong( );
+  }
   return ran_arr_next( );
 }
@@ -37,6 +37,8 @@
  */
 
 #include <map>
+#include <algorithm>
+#include <limits>
 #include <cstdlib>
 #include <cassert>
 
@@ -1913,6 +1915,390 @@ void chaos_mesh( const Router *r, const Flit *f,
 
 //=============================================================
 
+// Tables for the UniTorus routing functions, built once per network by
+// BuildUniTorusRoutes() so that routing does not have to extract
+// coordinates or allocate on every hop
+struct UniTorusTables {
+  int nodes;
+  int stride;                  // coordinates per node (at least X, Y, Z)
+  vector<int> coords;
+  vector<int> elevator;        // X, Y of the nearest elevator per node
+  vector<int> eject_port;
+  vector<int> lanes;           // per node and base net port
+  vector<int> lane_port;       // first extra lane port, per node and base port
+  vector<float> dim_penalty;
+  vector<float> dim_bonus;     // bandwidth bonus per dimension
+  tRoutingFunction route_fn;   // function the route table was built for
+  vector<short> route;         // (cur, dest) -> out_port * 4 + VC half
+  // adaptive_elevator_unitorus: the elevator_candidates nearest elevator
+  // columns of every column (y * X + x) that can be reached without
+  // crossing a cut link, nearest first, padded with -1
+  int candidates_per_column;
+  vector<int> candidates;
+  float congestion_weight;     // hops per flit queued at the output
+  int cut_x;                   // X links leaving this X are cut
+  vector<int> cut_y;           // Y links leaving this Y are cut, per X
+  // src_dst_elevator_unitorus: elevator column per (source column,
+  // destination column), empty if the network is too large for a table
+  vector<int> elevator_columns;
+  int planar_cost[2];          // cost of an X and of a Y hop
+  vector<short> pair_elevator;
+};
+static UniTorusTables _unitorus;
+
+// number of base net ports: X, Y, then Z-up/Z-down (mesh) or Z (torus)
+static const int _unitorus_base_ports = 4;
+
+// Output port of dim_order_unitorus, and which half of the VC range to use
+// (0: all, 1: lower half for the direct path, 2: upper half for wraparound)
+static int _DimOrderUniTorusPort(int cur, int dest, int *vc_half)
+{
+  int const * const cur_coords = &_unitorus.coords[cur * _unitorus.stride];
+  int const * const dest_coords = &_unitorus.coords[dest * _unitorus.stride];
+
+  // Find dimension with lowest cost that needs routing (penalty-aware routing)
+  int dim_to_route = -1;
+  float min_cost = -1.0f;
+  for (int dim = 0; dim < gN; ++dim) {
+    int const cur_coord = cur_coords[dim];
+    int const dest_coord = dest_coords[dim];
+    if (cur_coord != dest_coord) {
+      // Calculate distance in this dimension
+      int distance;
+      if (cur_coord < dest_coord) {
+        distance = dest_coord - cur_coord; // Direct path
+      } else {
+        distance = gDimSizes[dim] - cur_coord + dest_coord; // Wraparound path
+      }
+      // Total cost = base distance + penalty - bandwidth bonus
+      float cost = (float)distance + _unitorus.dim_penalty[dim] - _unitorus.dim_bonus[dim];
+      // Choose dimension with lowest cost (or first one if costs are equal)
+      if (dim_to_route < 0 || cost < min_cost) {
+        dim_to_route = dim;
+        min_cost = cost;
+      }
+    }
+  }
+
+  if (dim_to_route < 0) {
+    // At destination
+    *vc_half = 0;
+    return _unitorus.eject_port[cur];
+  }
+
+  // Use different VC sets based on whether we're wrapping around
+  *vc_half = (cur_coords[dim_to_route] < dest_coords[dim_to_route]) ? 1 : 2;
+  // Always route in positive direction (dimension number is the port)
+  return dim_to_route;
+}
+
+// Output port of dim_order_3d_elevator_unitorus towards the given elevator
+// column (y * X + x)
+static int _Elevator3DPort(int cur, int dest, int elevator)
+{
+  if (cur == dest) {
+    return _unitorus.eject_port[cur]; // PE is always the last port
+  }
+
+  int const * const cur_coords = &_unitorus.coords[cur * _unitorus.stride];
+  int const * const dest_coords = &_unitorus.coords[dest * _unitorus.stride];
+
+  if (cur_coords[2] != dest_coords[2]) {
+    int const elevator_x = elevator % gDimSizes[0];
+    int const elevator_y = elevator / gDimSizes[0];
+    if (cur_coords[0] == elevator_x && cur_coords[1] == elevator_y) { // At elevator - choose up or down port
+      if (gVerticalTopology == "mesh" && cur_coords[2] > 0 && cur_coords[2] < gDimSizes[2] - 1) {
+        // This router has separate Z-up and Z-down ports (middle layer)
+        return (cur_coords[2] < dest_coords[2]) ? 2 : 3;
+      }
+      return 2; // This router has only one Z port (top/bottom layer)
+    }
+    // Not at elevator - route to elevator using X,Y (X first)
+    return (cur_coords[0] != elevator_x) ? 0 : 1;
+  }
+
+  // Z matches - do 2D X,Y routing
+  return (cur_coords[0] != dest_coords[0]) ? 0 : 1;
+}
+
+// hops from one column of a layer to another on the unidirectional X and
+// Y rings
+static int _UniTorusPlanarDistance(int from, int to)
+{
+  int const width = gDimSizes[0];
+  int const height = gDimSizes[1];
+  return (to % width - from % width + width) % width +
+    (to / width - from / width + height) % height;
+}
+
+// elevator column of the static mapping of a node
+static int _MappedElevator(int node)
+{
+  return _unitorus.elevator[2 * node + 1] * gDimSizes[0] + _unitorus.elevator[2 * node];
+}
+
+// columns that any column of the static mapping uses as its elevator; the
+// layer-0 routers use the same mapping as every other layer
+static void _FindElevatorColumns()
+{
+  int const columns = gDimSizes[0] * gDimSizes[1];
+  vector<bool> is_elevator(columns, false);
+  for (int c = 0; c < columns; ++c) {
+    is_elevator[_MappedElevator(c)] = true;
+  }
+  _unitorus.elevator_columns.clear();
+  for (int e = 0; e < columns; ++e) {
+    if (is_elevator[e]) {
+      _unitorus.elevator_columns.push_back(e);
+    }
+  }
+}
+
+// whether the X, Y path from one column to another crosses no cut link
+static bool _UniTorusUncut(int from, int to)
+{
+  int const width = gDimSizes[0];
+  int const height = gDimSizes[1];
+  int const dx = (to % width - from % width + width) % width;
+  int const dy = (to / width - from / width + height) % height;
+  int const cut_y = _unitorus.cut_y[to % width];
+  return ((_unitorus.cut_x - from % width + width) % width >= dx) &&
+    ((cut_y - from / width + height) % height >= dy);
+}
+
+static void _BuildElevatorCandidates(Configuration const & config)
+{
+  int const columns = gDimSizes[0] * gDimSizes[1];
+  int const k = config.GetInt("elevator_candidates");
+  if (k < 1) {
+    cerr << "Error: elevator_candidates must be positive." << endl;
+    exit(-1);
+  }
+  _unitorus.candidates_per_column = k;
+  _unitorus.congestion_weight = config.GetFloat("elevator_congestion_weight");
+
+  // cut the X links leaving the last X that has an elevator, and in each
+  // such X the Y links leaving its last elevator: from every column, the
+  // first elevator ahead in X, then Y order is reached without crossing a
+  // cut link
+  int const width = gDimSizes[0];
+  _unitorus.cut_x = -1;
+  _unitorus.cut_y.assign(width, -1);
+  for (size_t i = 0; i < _unitorus.elevator_columns.size(); ++i) {
+    int const e = _unitorus.elevator_columns[i];
+    _unitorus.cut_x = max(_unitorus.cut_x, e % width);
+    _unitorus.cut_y[e % width] = max(_unitorus.cut_y[e % width], e / width);
+  }
+
+  // ties go to the column's own mapping, then to the lower column
+  _unitorus.candidates.assign(columns * k, -1);
+  vector<pair<int, int> > by_distance;
+  for (int c = 0; c < columns; ++c) {
+    int const mapped = _MappedElevator(c);
+    by_distance.clear();
+    for (size_t i = 0; i < _unitorus.elevator_columns.size(); ++i) {
+      int const e = _unitorus.elevator_columns[i];
+      if (!_UniTorusUncut(c, e)) {
+        continue;
+      }
+      int const key = 2 * _UniTorusPlanarDistance(c, e) + ((e == mapped) ? 0 : 1);
+      by_distance.push_back(make_pair(key, e));
+    }
+    int const n = min(k, (int)by_distance.size());
+    partial_sort(by_distance.begin(), by_distance.begin() + n, by_distance.end());
+    for (int i = 0; i < n; ++i) {
+      _unitorus.candidates[c * k + i] = by_distance[i].second;
+    }
+  }
+}
+
+// cost of the planar part of a path from one column to another on the
+// unidirectional X and Y rings
+static int _UniTorusPlanarCost(int from, int to)
+{
+  int const width = gDimSizes[0];
+  int const height = gDimSizes[1];
+  return _unitorus.planar_cost[0] * ((to % width - from % width + width) % width) +
+    _unitorus.planar_cost[1] * ((to / width - from / width + height) % height);
+}
+
+// Elevator column with the lowest planar cost from the source column to it
+// and from it to the destination column; the vertical part is the same for
+// every elevator. Every elevator inside the rectangle spanned by source and
+// destination has the minimal cost, so ties are common: they go to the
+// elevator nearest to the source (which spreads the load like the static
+// mapping does), then to the source column's own mapping, then to the
+// lower column.
+static int _BestPairElevator(int src_column, int dest_column)
+{
+  int best = _MappedElevator(src_column);
+  int best_to = _UniTorusPlanarCost(src_column, best);
+  int best_cost = best_to + _UniTorusPlanarCost(best, dest_column);
+  for (size_t i = 0; i < _unitorus.elevator_columns.size(); ++i) {
+    int const e = _unitorus.elevator_columns[i];
+    int const to = _UniTorusPlanarCost(src_column, e);
+    int const cost = to + _UniTorusPlanarCost(e, dest_column);
+    if ((cost < best_cost) || ((cost == best_cost) && (to < best_to))) {
+      best = e;
+      best_to = to;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
+static void _BuildPairElevators(Configuration const & config)
+{
+  string const cost = config.GetStr("elevator_pair_cost");
+  if (cost == "hops") {
+    _unitorus.planar_cost[0] = 1;
+    _unitorus.planar_cost[1] = 1;
+  } else if (cost == "latency") {
+    _unitorus.planar_cost[0] = gDimLatencies[0];
+    _unitorus.planar_cost[1] = gDimLatencies[1];
+  } else {
+    cerr << "Error: Unknown elevator_pair_cost " << cost
+         << " (expected hops or latency)." << endl;
+    exit(-1);
+  }
+
+  // like the route table, the pair table is only kept while it is small;
+  // larger networks search the elevators once per packet at injection
+  int const columns = gDimSizes[0] * gDimSizes[1];
+  _unitorus.pair_elevator.clear();
+  if ((long)columns * columns > (1L << 22) ||
+      (long)columns * columns * _unitorus.elevator_columns.size() > (1L << 30)) {
+    return;
+  }
+  _unitorus.pair_elevator.resize(columns * columns);
+  for (int s = 0; s < columns; ++s) {
+    for (int d = 0; d < columns; ++d) {
+      _unitorus.pair_elevator[s * columns + d] = _BestPairElevator(s, d);
+    }
+  }
+}
+
+void BuildUniTorusRoutes(Configuration const & config,
+                         vector<Router *> const & routers,
+                         tRoutingFunction route_fn)
+{
+  int const nodes = routers.size();
+  int const dims = gDimSizes.size();
+  bool const is_vertical_mesh = (gVerticalTopology == "mesh");
+
+  _unitorus.nodes = nodes;
+  _unitorus.stride = max(dims, 3);
+  _unitorus.coords.assign(nodes * _unitorus.stride, 0);
+  _unitorus.elevator.resize(2 * nodes);
+  _unitorus.eject_port.resize(nodes);
+  _unitorus.lanes.assign(nodes * _unitorus_base_ports, 1);
+  _unitorus.lane_port.assign(nodes * _unitorus_base_ports, 0);
+
+  // Higher bandwidth makes dimension more attractive (lower cost)
+  _unitorus.dim_penalty.resize(dims);
+  _unitorus.dim_bonus.resize(dims);
+  for (int dim = 0; dim < dims; ++dim) {
+    _unitorus.dim_penalty[dim] = (dim < (int)gDimPenalties.size()) ? gDimPenalties[dim] : 0.0f;
+    _unitorus.dim_bonus[dim] = (dim < (int)gDimBandwidths.size()) ? (float)gDimBandwidths[dim] - 1.0f : 0.0f;
+  }
+
+  int missing_elevators = 0;
+  for (int node = 0; node < nodes; ++node) {
+    int * const coords = &_unitorus.coords[node * _unitorus.stride];
+    int divisor = 1;
+    for (int dim = 0; dim < dims; ++dim) {
+      coords[dim] = (node / divisor) % gDimSizes[dim];
+      divisor *= gDimSizes[dim];
+    }
+
+    int grid_pos = coords[1] * gDimSizes[0] + coords[0]; // y * width + x
+    if (grid_pos < (int)gElevatorMapping.size()) {
+      _unitorus.elevator[2 * node] = gElevatorMapping[grid_pos][0];
+      _unitorus.elevator[2 * node + 1] = gElevatorMapping[grid_pos][1];
+    } else {
+      // Fallback: use node's own X,Y coordinates
+      _unitorus.elevator[2 * node] = coords[0];
+      _unitorus.elevator[2 * node + 1] = coords[1];
+      ++missing_elevators;
+    }
+
+    _unitorus.eject_port[node] = routers[node]->NumOutputs() - 1;
+
+    // A dimension with bandwidth N is built from N parallel channels: lane 0
+    // is the regular net port (X, Y, then Z or Z-up/Z-down), and the
+    // remaining lanes of all net ports follow in the same order, ahead of
+    // the PE port.
+    int port_dims[_unitorus_base_ports];
+    int net_ports = 0;
+    port_dims[net_ports++] = 0;
+    port_dims[net_ports++] = 1;
+    if (dims > 2) {
+      if (is_vertical_mesh) {
+        if (coords[2] < gDimSizes[2] - 1) port_dims[net_ports++] = 2; // Z-up
+        if (coords[2] > 0) port_dims[net_ports++] = 2;                // Z-down
+      } else {
+        port_dims[net_ports++] = 2;
+      }
+    }
+    int lane_port = net_ports;
+    for (int p = 0; p < net_ports; ++p) {
+      int const i = node * _unitorus_base_ports + p;
+      if (port_dims[p] < (int)gDimBandwidths.size()) {
+        _unitorus.lanes[i] = gDimBandwidths[port_dims[p]];
+      }
+      _unitorus.lane_port[i] = lane_port;
+      lane_port += _unitorus.lanes[i] - 1;
+    }
+  }
+  bool const uses_elevators = (route_fn == &dim_order_3d_elevator_unitorus) ||
+    (route_fn == &adaptive_elevator_unitorus) ||
+    (route_fn == &src_dst_elevator_unitorus);
+  if (missing_elevators > 0 && uses_elevators) {
+    cout << "WARNING: " << missing_elevators << " nodes have no elevator mapping,"
+         << " using their own X,Y coordinates" << endl;
+  }
+
+  _unitorus.candidates.clear();
+  _unitorus.pair_elevator.clear();
+  if (uses_elevators && dims > 2) {
+    _FindElevatorColumns();
+  }
+  if (route_fn == &adaptive_elevator_unitorus && dims > 2) {
+    _BuildElevatorCandidates(config);
+  }
+  if (route_fn == &src_dst_elevator_unitorus && dims > 2) {
+    _BuildPairElevators(config);
+  }
+
+  // the full route table is 2 bytes per node pair; beyond a few MB the
+  // lookup would miss in cache anyway, so compute from the tables above
+  _unitorus.route_fn = NULL;
+  _unitorus.route.clear();
+  if ((long)nodes * nodes > (1L << 22)) {
+    return;
+  }
+  if (route_fn == &dim_order_unitorus) {
+    _unitorus.route.resize(nodes * nodes);
+    for (int cur = 0; cur < nodes; ++cur) {
+      for (int dest = 0; dest < nodes; ++dest) {
+        int vc_half;
+        int const port = _DimOrderUniTorusPort(cur, dest, &vc_half);
+        _unitorus.route[cur * nodes + dest] = port * 4 + vc_half;
+      }
+    }
+    _unitorus.route_fn = route_fn;
+  } else if (route_fn == &dim_order_3d_elevator_unitorus && dims > 2) {
+    _unitorus.route.resize(nodes * nodes);
+    for (int cur = 0; cur < nodes; ++cur) {
+      for (int dest = 0; dest < nodes; ++dest) {
+        _unitorus.route[cur * nodes + dest] =
+          _Elevator3DPort(cur, dest, _MappedElevator(cur)) * 4;
+      }
+    }
+    _unitorus.route_fn = route_fn;
+  }
+}
+
 // 3D routing for unidirectional 2D torus + vertical mesh with elevators
 // Z-first priority: route to elevator if Z doesn't match, otherwise normal 2D routing
 
@@ -1939,48 +2325,373 @@ void dim_order_3d_elevator_unitorus(const Router *r, const Flit *f, int in_chann
     vcEnd = gWriteReplyEndVC;
   }
   assert(((f->vc >= vcBegin) && (f->vc <= vcEnd)) || (inject && (f->vc < 0)));
-  int out_port;
 
-  if(inject) {
-    out_port = -1;
+  outputs->Clear();
+  if (inject) {
+    outputs->AddRange(-1, vcBegin, vcEnd);
+    return;
+  }
+
+  int cur = r->GetID();
+  int dest = f->dest;
+  int out_port;
+  if (_unitorus.route_fn == &dim_order_3d_elevator_unitorus) {
+    out_port = _unitorus.route[cur * _unitorus.nodes + dest] / 4;
   } else {
-    int cur = r->GetID();
-    int dest = f->dest;
-    bool is_vertical_mesh = (gVerticalTopology == "mesh");
-    bool use_single_z_port = (!is_vertical_mesh) || (gDimSizes[2] <= 2);
-    if (cur == dest) {
-      // Check if we're using 5-port (mesh) or 4-port (torus) system
-      out_port = r->NumOutputs() - 1; // PE is always the last port
+    out_port = _Elevator3DPort(cur, dest, _MappedElevator(cur));
+  }
+
+  AddUniTorusLanes(outputs, cur, f->pid, out_port, vcBegin, vcEnd);
+}
+
+// Elevator routing like dim_order_3d_elevator_unitorus, but the elevator
+// depends on both the source and the destination column: at injection, the
+// elevator with the lowest planar cost via it (elevator_pair_cost) is looked
+// up and stamped into f->intm (f->ph = 0 marks it as set), and every later
+// hop routes towards that column.
+void src_dst_elevator_unitorus(const Router *r, const Flit *f, int in_channel,
+                               OutputSet *outputs, bool inject)
+{
+  int vcBegin = 0, vcEnd = gNumVCs-1;
+  if (f->type == Flit::READ_REQUEST) {
+    vcBegin = gReadReqBeginVC;
+    vcEnd = gReadReqEndVC;
+  } else if (f->type == Flit::WRITE_REQUEST) {
+    vcBegin = gWriteReqBeginVC;
+    vcEnd = gWriteReqEndVC;
+  } else if (f->type == Flit::READ_REPLY) {
+    vcBegin = gReadReplyBeginVC;
+    vcEnd = gReadReplyEndVC;
+  } else if (f->type == Flit::WRITE_REPLY) {
+    vcBegin = gWriteReplyBeginVC;
+    vcEnd = gWriteReplyEndVC;
+  }
+  assert(((f->vc >= vcBegin) && (f->vc <= vcEnd)) || (inject && (f->vc < 0)));
+
+  if ((f->ph < 0) && (gDimSizes.size() > 2)) {
+    int const columns = gDimSizes[0] * gDimSizes[1];
+    int const src_column = f->src % columns;
+    int const dest_column = f->dest % columns;
+    if (_unitorus.pair_elevator.empty()) {
+      f->intm = _BestPairElevator(src_column, dest_column);
     } else {
-      vector<int> cur_coords = NodeToCoords3D(cur);
-      vector<int> dest_coords = NodeToCoords3D(dest);
-      
-      if (cur_coords[2] != dest_coords[2]) {
-        vector<int> elevator_coords = GetNearestElevator(cur);
-        //cout << "Node " << cur << " coords(" << cur_coords[0] << "," << cur_coords[1] << "," << cur_coords[2] << ") maps to elevator (" << elevator_coords[0] << "," << elevator_coords[1] << ")" << endl;
-        if (cur_coords[0] == elevator_coords[0] && cur_coords[1] == elevator_coords[1]) { // At elevator - choose up or down port
-          if (r->NumOutputs() == 5) { // This router has separate Z-up and Z-down ports (middle layer)
-            if (cur_coords[2] < dest_coords[2]) {
-              out_port = 2; // Z-up
-            } else {
-              out_port = 3; // Z-down
-            }
-          } else {
-            out_port = 2; // This router has only one Z port (top/bottom layer)
-          }
-        } else {
-          // Not at elevator - route to elevator using X,Y
-          out_port = Route2D_ToElevator(cur_coords, elevator_coords, vcBegin, vcEnd);
-        }
-      } else {
-        // Z matches - do 2D X,Y routing
-        out_port = Route2D_ToDestination(cur_coords, dest_coords, vcBegin, vcEnd);
+      f->intm = _unitorus.pair_elevator[src_column * columns + dest_column];
+    }
+    f->ph = 0;
+  }
+
+  outputs->Clear();
+  if (inject) {
+    outputs->AddRange(-1, vcBegin, vcEnd);
+    return;
+  }
+
+  int const cur = r->GetID();
+  int const out_port = _Elevator3DPort(cur, f->dest, f->intm);
+
+  if (f->watch) {
+    *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
+               << "Source/destination elevator: elevator column " << f->intm
+               << ", output port " << out_port
+               << " for flit " << f->id
+               << " (input port " << in_channel
+               << ", destination " << f->dest << ")"
+               << "." << endl;
+  }
+
+  AddUniTorusLanes(outputs, cur, f->pid, out_port, vcBegin, vcEnd);
+}
+
+// Z port of a router at an elevator: mesh routers in middle layers have
+// separate Z-up and Z-down ports, all others a single one
+static int _ElevatorVerticalPort(int const * cur_coords, int const * dest_coords)
+{
+  if (gVerticalTopology == "mesh" && cur_coords[2] > 0 && cur_coords[2] < gDimSizes[2] - 1) {
+    return (cur_coords[2] < dest_coords[2]) ? 2 : 3;
+  }
+  return 2;
+}
+
+// Port from a column of the current layer towards another column (X first),
+// and whether the hop is on the wraparound part of its ring
+static int _UniTorusPlanarPort(int from, int to, bool *wrap)
+{
+  int const width = gDimSizes[0];
+  if ((from % width) != (to % width)) {
+    *wrap = (from % width) > (to % width);
+    return 0;
+  }
+  *wrap = (from / width) > (to / width);
+  return 1;
+}
+
+// Flits queued at the next router behind an output, averaged over its lanes
+static float _UniTorusCongestion(const Router *r, int port)
+{
+  int const node = r->GetID();
+  int lanes = 1;
+  int lane_port = 0;
+  if (port < _unitorus_base_ports) {
+    lanes = _unitorus.lanes[node * _unitorus_base_ports + port];
+    lane_port = _unitorus.lane_port[node * _unitorus_base_ports + port];
+  }
+  int used = r->GetUsedCredit(port);
+  for (int lane = 1; lane < lanes; ++lane) {
+    used += r->GetUsedCredit(lane_port + lane - 1);
+  }
+  return (float)used / lanes;
+}
+
+// Choose the elevator column of a flit in its source layer among the
+// candidates of the current column. The cost is the planar distance via the
+// elevator (to it, then from it to the destination column) plus the
+// weighted congestion of the first hop. A flit that already has an
+// elevator only switches to one that is at most as far away, so every hop
+// brings it closer to its elevator and it cannot circle the layer, and
+// once it has taken a Y hop (y_hops) only to one in the same X, so that X
+// hops always come first.
+static int _ChooseElevator(const Router *r, int const * cur_coords,
+                           int const * dest_coords, int current, bool y_hops)
+{
+  int const column = cur_coords[1] * gDimSizes[0] + cur_coords[0];
+  int const dest_column = dest_coords[1] * gDimSizes[0] + dest_coords[0];
+  int const limit = (current >= 0) ? _UniTorusPlanarDistance(column, current) :
+    numeric_limits<int>::max();
+
+  float congestion[3] = { -1.0f, -1.0f, -1.0f }; // X, Y, Z
+  int best = -1;
+  float best_cost = 0.0f;
+  int const * const candidates =
+    &_unitorus.candidates[column * _unitorus.candidates_per_column];
+  for (int i = -1; i < _unitorus.candidates_per_column; ++i) {
+    // the current choice first, so that it wins ties
+    int const e = (i < 0) ? current : candidates[i];
+    if (e < 0) {
+      continue;
+    }
+    int const distance = _UniTorusPlanarDistance(column, e);
+    if (distance > limit) {
+      continue;
+    }
+    int port;
+    int slot;
+    if (e == column) {
+      port = _ElevatorVerticalPort(cur_coords, dest_coords);
+      slot = 2;
+    } else {
+      bool wrap;
+      port = _UniTorusPlanarPort(column, e, &wrap);
+      if (y_hops && (port == 0)) {
+        continue;
       }
+      slot = port;
+    }
+    if (congestion[slot] < 0.0f) {
+      congestion[slot] = _UniTorusCongestion(r, port);
     }
+    float const cost = distance + _UniTorusPlanarDistance(e, dest_column) +
+      _unitorus.congestion_weight * congestion[slot];
+    if ((best < 0) || (cost < best_cost)) {
+      best = e;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
+// Elevator routing for the unidirectional torus with adaptive elevator
+// selection. In its source layer, a packet (re)chooses its elevator among
+// the elevator_candidates nearest ones at every hop (see _ChooseElevator)
+// and routes towards it in X, Y order; it then travels vertically and
+// finishes with minimal adaptive routing in the destination layer, taking
+// the less congested of the X and Y outputs that bring it closer. The
+// chosen column is kept in f->intm; f->ph only marks that f->intm is set.
+//
+// Source layer hops (phase 0) never cross a cut link (see
+// _BuildElevatorCandidates) and take their X hops before their Y hops, so
+// they cannot form a cycle by themselves and need no escape VCs. The
+// first two VCs of each message class are the escape VCs of the vertical
+// hops and the hops in the destination layer (phase 1), one per dateline
+// class; they are only offered on the dimension order port, so they form
+// dimension order routing with datelines. The remaining VCs of the class
+// are adaptive and used by all hops at a higher priority than the escape
+// VCs. Phase 1 packets can always drain through the escape VCs, and phase
+// 0 packets only wait on each other in the order of the cut rings, so the
+// routing is deadlock-free with only two escape VCs. The VC allocator has
+// to honor priorities (e.g. separable_input_first) for the adaptive VCs to
+// be preferred.
+void adaptive_elevator_unitorus(const Router *r, const Flit *f, int in_channel,
+                                OutputSet *outputs, bool inject)
+{
+  int vcBegin = 0, vcEnd = gNumVCs-1;
+  if (f->type == Flit::READ_REQUEST) {
+    vcBegin = gReadReqBeginVC;
+    vcEnd = gReadReqEndVC;
+  } else if (f->type == Flit::WRITE_REQUEST) {
+    vcBegin = gWriteReqBeginVC;
+    vcEnd = gWriteReqEndVC;
+  } else if (f->type == Flit::READ_REPLY) {
+    vcBegin = gReadReplyBeginVC;
+    vcEnd = gReadReplyEndVC;
+  } else if (f->type == Flit::WRITE_REPLY) {
+    vcBegin = gWriteReplyBeginVC;
+    vcEnd = gWriteReplyEndVC;
+  }
+  assert(((f->vc >= vcBegin) && (f->vc <= vcEnd)) || (inject && (f->vc < 0)));
+
+  int const escape_vcs = 2;
+  if (vcEnd - vcBegin + 1 <= escape_vcs) {
+    cerr << "Error: adaptive_elevator routing needs more than " << escape_vcs
+         << " VCs per message class." << endl;
+    exit(-1);
   }
 
   outputs->Clear();
-  outputs->AddRange(out_port, vcBegin, vcEnd);
+  if (inject) {
+    outputs->AddRange(-1, vcBegin, vcEnd);
+    return;
+  }
+
+  int const cur = r->GetID();
+  int const dest = f->dest;
+  if (cur == dest) {
+    outputs->AddRange(_unitorus.eject_port[cur], vcBegin, vcEnd);
+    return;
+  }
+
+  int const * const cur_coords = &_unitorus.coords[cur * _unitorus.stride];
+  int const * const dest_coords = &_unitorus.coords[dest * _unitorus.stride];
+  int const * const src_coords = &_unitorus.coords[f->src * _unitorus.stride];
+  int const column = cur_coords[1] * gDimSizes[0] + cur_coords[0];
+
+  if (f->ph < 0) {
+    f->ph = 0;
+    f->intm = -1;
+  }
+
+  int target;
+  int phase = 1;
+  if (cur_coords[2] == dest_coords[2]) {
+    target = dest_coords[1] * gDimSizes[0] + dest_coords[0];
+  } else {
+    if (cur_coords[2] == src_coords[2]) {
+      // X hops come first, so the packet has taken a Y hop in the source
+      // layer iff its row differs from the source's
+      f->intm = _ChooseElevator(r, cur_coords, dest_coords, f->intm,
+                                cur_coords[1] != src_coords[1]);
+      phase = 0;
+    }
+    target = f->intm;
+    assert((target == column) || (phase == 0));
+  }
+
+  int const * const lanes = &_unitorus.lanes[cur * _unitorus_base_ports];
+
+  if ((target == column) && (cur_coords[2] != dest_coords[2])) {
+    // vertical hop; a vertical mesh only uses the direct escape VC, so
+    // both are free, and a vertical torus is a unidirectional ring as well
+    int const out_port = _ElevatorVerticalPort(cur_coords, dest_coords);
+    bool const wrap = (gVerticalTopology != "mesh") && (cur_coords[2] > dest_coords[2]);
+    if (f->watch) {
+      *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
+                 << "Adaptive elevator: elevator column " << f->intm
+                 << ", vertical output port " << out_port
+                 << " for flit " << f->id
+                 << " (input port " << in_channel
+                 << ", destination " << f->dest << ")"
+                 << "." << endl;
+    }
+    AddUniTorusLanes(outputs, cur, f->pid, out_port, vcBegin + escape_vcs, vcEnd,
+                     lanes[out_port]);
+    AddUniTorusLanes(outputs, cur, f->pid, out_port,
+                     ((gVerticalTopology == "mesh") || wrap) ? vcBegin : vcBegin + 1,
+                     wrap ? vcBegin : vcBegin + 1);
+    return;
+  }
+
+  if (phase == 0) {
+    bool wrap;
+    int const out_port = _UniTorusPlanarPort(column, target, &wrap);
+    if (f->watch) {
+      *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
+                 << "Adaptive elevator: elevator column " << f->intm
+                 << ", output port " << out_port
+                 << " for flit " << f->id
+                 << " (input port " << in_channel
+                 << ", destination " << f->dest << ")"
+                 << "." << endl;
+    }
+    AddUniTorusLanes(outputs, cur, f->pid, out_port, vcBegin + escape_vcs, vcEnd);
+    return;
+  }
+
+  // planar phase 1 hop: the adaptive VCs of both minimal ports, the less
+  // congested one first, and the escape VC of the X, Y order port. A
+  // packet uses the first escape VC of a ring while it still has to wrap
+  // around it and the second one after that; minimal hops never add X
+  // offset once it is 0, so the escape VCs are taken in increasing order
+  // of (X or Y, escape VC, position on the ring), also across adaptive hops.
+  int ports[2];
+  int count = 0;
+  for (int d = 0; d < 2; ++d) {
+    if (cur_coords[d] != dest_coords[d]) {
+      ports[count++] = d;
+    }
+  }
+  assert(count > 0);
+  if ((count == 2) &&
+      (_UniTorusCongestion(r, 1) < _UniTorusCongestion(r, 0))) {
+    swap(ports[0], ports[1]);
+  }
+
+  int const escape_port = (cur_coords[0] != dest_coords[0]) ? 0 : 1;
+  int const escape_vc = (cur_coords[escape_port] > dest_coords[escape_port]) ?
+    vcBegin : vcBegin + 1;
+
+  if (f->watch) {
+    *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
+               << "Adaptive elevator: output port " << ports[0];
+    if (count == 2) {
+      *gWatchOut << " or " << ports[1];
+    }
+    *gWatchOut << ", escape VC " << escape_vc
+               << " for flit " << f->id
+               << " (input port " << in_channel
+               << ", destination " << f->dest << ")"
+               << "." << endl;
+  }
+
+  int const pri_step = max(lanes[0], lanes[1]);
+  for (int i = 0; i < count; ++i) {
+    AddUniTorusLanes(outputs, cur, f->pid, ports[i], vcBegin + escape_vcs, vcEnd,
+                     (count - i) * pri_step);
+  }
+  AddUniTorusLanes(outputs, cur, f->pid, escape_port, escape_vc, escape_vc);
+}
+
+// Add a UniTorus net port and all of its lanes to the output set.
+// Packets are striped across lanes by packet id; the other lanes get lower
+// priorities so the VC allocator can still fall back to them.
+void AddUniTorusLanes(OutputSet *outputs, int node, int pid, int port,
+                      int vcBegin, int vcEnd, int pri_base)
+{
+  int lanes = 1;
+  int lane_port = 0;
+  if (port >= 0 && port < _unitorus_base_ports) {
+    lanes = _unitorus.lanes[node * _unitorus_base_ports + port];
+    lane_port = _unitorus.lane_port[node * _unitorus_base_ports + port];
+  }
+  if (lanes <= 1) {
+    outputs->AddRange(port, vcBegin, vcEnd, pri_base);
+    return;
+  }
+
+  int preferred = pid % lanes;
+  for (int lane = 0; lane < lanes; ++lane) {
+    int pri = pri_base + lanes - 1 - ((lane - preferred + lanes) % lanes);
+    int lane_out = (lane == 0) ? port : lane_port + lane - 1;
+    outputs->AddRange(lane_out, vcBegin, vcEnd, pri);
+  }
 }
 
 // Convert node ID to 3D coordinates using consistent method
@@ -2117,98 +2828,46 @@ void dim_order_unitorus( const Router *r, const Flit *f, int in_channel,
   }
   assert(((f->vc >= vcBegin) && (f->vc <= vcEnd)) || (inject && (f->vc < 0)));
 
-  int out_port;
+  outputs->Clear();
+  if (inject) {
+    outputs->AddRange(-1, vcBegin, vcEnd);
+    return;
+  }
 
-  if(inject) {
-    out_port = -1;
+  int cur = r->GetID();
+  int dest = f->dest;
+  int out_port;
+  int vc_half;
+  if (_unitorus.route_fn == &dim_order_unitorus) {
+    int const entry = _unitorus.route[cur * _unitorus.nodes + dest];
+    out_port = entry / 4;
+    vc_half = entry % 4;
   } else {
-    int cur = r->GetID();
-    int dest = f->dest;
-
-    // Find dimension with lowest cost that needs routing (penalty-aware routing)
-    int dim_to_route = -1;
-    float min_cost = -1.0f;
-    
-    for (int dim = 0; dim < gN; ++dim) {
-      // Calculate current and destination coordinates for this dimension
-      int divisor = 1;
-      for (int d = 0; d < dim; ++d) {
-        divisor *= gDimSizes[d];
-      }
-      
-      int cur_coord = (cur / divisor) % gDimSizes[dim];
-      int dest_coord = (dest / divisor) % gDimSizes[dim];
-      
-      if (cur_coord != dest_coord) {
-        // This dimension needs routing - calculate routing cost
-        
-        // Calculate distance in this dimension
-        int distance;
-        if (cur_coord < dest_coord) {
-          distance = dest_coord - cur_coord; // Direct path
-        } else {
-          distance = gDimSizes[dim] - cur_coord + dest_coord; // Wraparound path
-        }
-        
-        // Total cost = base distance + penalty - bandwidth bonus
-        // Higher bandwidth makes dimension more attractive (lower cost)
-        float penalty = (dim < (int)gDimPenalties.size()) ? gDimPenalties[dim] : 0.0f;
-        float bandwidth_bonus = (dim < (int)gDimBandwidths.size()) ? (float)gDimBandwidths[dim] - 1.0f : 0.0f;
-        float cost = (float)distance + penalty - bandwidth_bonus;
-        
-        // Choose dimension with lowest cost (or first one if costs are equal)
-        if (dim_to_route < 0 || cost < min_cost) {
-          dim_to_route = dim;
-          min_cost = cost;
-        }
-      }
-    }
+    out_port = _DimOrderUniTorusPort(cur, dest, &vc_half);
+  }
 
-    if (dim_to_route >= 0) {
-      // In unidirectional torus, we can only move in positive direction
-      // If destination is "behind" us, we need to go the long way around
-      int divisor = 1;
-      for (int d = 0; d < dim_to_route; ++d) {
-        divisor *= gDimSizes[d];
-      }
-      
-      int cur_coord = (cur / divisor) % gDimSizes[dim_to_route];
-      int dest_coord = (dest / divisor) % gDimSizes[dim_to_route];
-      
-      // Always route in positive direction (dimension number is the port)
-      out_port = dim_to_route;
-      
-      // Apply virtual channel partitioning for deadlock avoidance
-      // Use different VC sets based on whether we're wrapping around
-      if (cur_coord < dest_coord) {
-        // Direct path (no wraparound)
-        // Use first half of VCs
-        vcEnd = vcBegin + (vcEnd - vcBegin) / 2;
-      } else {
-        // Wraparound path (cur > dest, going the long way)
-        // Use second half of VCs
-        vcBegin = vcBegin + (vcEnd - vcBegin + 1) / 2;
-      }
-    } else {
-      // At destination
-      out_port = gN; // Eject port
-    }
+  // Apply virtual channel partitioning for deadlock avoidance
+  if (vc_half == 1) {
+    // Direct path (no wraparound): use first half of VCs
+    vcEnd = vcBegin + (vcEnd - vcBegin) / 2;
+  } else if (vc_half == 2) {
+    // Wraparound path (cur > dest, going the long way): use second half of VCs
+    vcBegin = vcBegin + (vcEnd - vcBegin + 1) / 2;
+  }
 
-    if (f->watch) {
-      *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
-                 << "Unidirectional DOR: Adding VC range [" 
-                 << vcBegin << "," 
-                 << vcEnd << "]"
-                 << " at output port " << out_port
-                 << " for flit " << f->id
-                 << " (input port " << in_channel
-                 << ", destination " << f->dest << ")"
-                 << "." << endl;
-    }
+  if (f->watch) {
+    *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
+               << "Unidirectional DOR: Adding VC range [" 
+               << vcBegin << "," 
+               << vcEnd << "]"
+               << " at output port " << out_port
+               << " for flit " << f->id
+               << " (input port " << in_channel
+               << ", destination " << f->dest << ")"
+               << "." << endl;
   }
  
-  outputs->Clear();
-  outputs->AddRange(out_port, vcBegin, vcEnd);
+  AddUniTorusLanes(outputs, cur, f->pid, out_port, vcBegin, vcEnd);
 }
 
 //=============================================================
@@ -2271,6 +2930,8 @@ void InitializeRoutingMap( const Configuration & config )
 
   gRoutingFunctionMap["dim_order_3d_elevator_unitorus"] = &dim_order_3d_elevator_unitorus;
   gRoutingFunctionMap["dim_order_unitorus"] = &dim_order_unitorus;
+  gRoutingFunctionMap["adaptive_elevator_unitorus"] = &adaptive_elevator_unitorus;
+  gRoutingFunctionMap["src_dst_elevator_unitorus"] = &src_dst_elevator_unitorus;
 
   gRoutingFunctionMap["dim_order_mesh"]  = &dim_order_mesh;
   gRoutingFunctionMap["dim_order_ni_mesh"]  = &dim_order_ni_mesh;
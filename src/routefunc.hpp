@@ -50,6 +50,10 @@ void dim_order_unitorus( const Router *r, const Flit *f, int in_channel,
                          OutputSet *outputs, bool inject );
 void dim_order_3d_elevator_unitorus(const Router *r, const Flit *f, 
                                    int in_channel, OutputSet* outputs, bool inject);
+void adaptive_elevator_unitorus(const Router *r, const Flit *f,
+                                int in_channel, OutputSet* outputs, bool inject);
+void src_dst_elevator_unitorus(const Router *r, const Flit *f,
+                               int in_channel, OutputSet* outputs, bool inject);
 
 // Helper function declarations  
 vector<int> NodeToCoords3D(int node);
@@ -60,5 +64,13 @@ int Route2D_ToDestination(const vector<int>& cur_coords, const vector<int>& dest
                          int& vcBegin, int& vcEnd);
 int Route_X_Dimension(int cur_x, int dest_x, int& vcBegin, int& vcEnd);
 int Route_Y_Dimension(int cur_y, int dest_y, int& vcBegin, int& vcEnd);
+void AddUniTorusLanes(OutputSet *outputs, int node, int pid, int port,
+                      int vcBegin, int vcEnd, int pri_base = 0);
+
+// Precompute per-node coordinates, lanes and, if the network is small
+// enough, the full route table of the given UniTorus routing function
+void BuildUniTorusRoutes(Configuration const & config,
+                         vector<Router *> const & routers,
+                         tRoutingFunction route_fn);
 
 #endif
@@ -33,6 +33,7 @@
 #include <iomanip>
 #include <cstdlib>
 #include <cassert>
+#include <cmath>
 #include <limits>
 
 #include "globals.hpp"
@@ -46,6 +47,7 @@
 #include "allocator.hpp"
 #include "switch_monitor.hpp"
 #include "buffer_monitor.hpp"
+#include "event_trace.hpp"
 
 IQRouter::IQRouter( Configuration const & config, Module *parent, 
 		    string const & name, int id, int inputs, int outputs )
@@ -208,6 +210,21 @@ IQRouter::~IQRouter( )
   delete _switchMonitor;
 }
   
+void IQRouter::TrackBufferOccupancy( )
+{
+  _bufferMonitor->TrackOccupancy(true);
+  ResetBufferOccupancy();
+}
+
+void IQRouter::ResetBufferOccupancy( )
+{
+  vector<int> occupancy(_inputs);
+  for(int i = 0; i < _inputs; ++i) {
+    occupancy[i] = _buf[i]->GetOccupancy();
+  }
+  _bufferMonitor->ResetOccupancy(occupancy);
+}
+  
 void IQRouter::AddOutputChannel(FlitChannel * channel, CreditChannel * backchannel)
 {
   int alloc_delay = _speculative ? max(_vc_alloc_delay, _sw_alloc_delay) : (_vc_alloc_delay + _sw_alloc_delay);
@@ -288,6 +305,29 @@ void IQRouter::WriteOutputs( )
   _SendCredits( );
 }
 
+bool IQRouter::IsIdle( ) const
+{
+  if(_active) {
+    return false;
+  }
+  // with a fractional speedup, skipped cycles would change how internal
+  // steps line up with external ones
+  if(_internal_speedup != floor(_internal_speedup)) {
+    return false;
+  }
+  for(int output = 0; output < _outputs; ++output) {
+    if(!_output_buffer[output].empty()) {
+      return false;
+    }
+  }
+  for(int input = 0; input < _inputs; ++input) {
+    if(!_credit_buffer[input].empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 
 //------------------------------------------------------------------------------
 // read inputs
@@ -310,6 +350,7 @@ bool IQRouter::_ReceiveFlits( )
 		   << " from channel at input " << input
 		   << "." << endl;
       }
+      f->rtime = GetSimTime();
       _in_queue_flits.insert(make_pair(input, f));
       activity = true;
     }
@@ -374,7 +415,7 @@ void IQRouter::_InputQueuing( )
     if(f->head) ++_active_packets[f->cl][input];
 #endif
 
-    _bufferMonitor->write(input, f) ;
+    _bufferMonitor->write(input, f, cur_buf->GetOccupancy()) ;
 
     if(cur_buf->GetState(vc) == VC::idle) {
       assert(cur_buf->FrontFlit(vc) == f);
@@ -394,6 +435,9 @@ void IQRouter::_InputQueuing( )
 	}
 	cur_buf->SetRouteSet(vc, &f->la_route_set);
 	cur_buf->SetState(vc, VC::vc_alloc);
+	if(f->trace) {
+	  EventTrace::Add(EventTrace::route, f, GetID(), input, vc);
+	}
 	if(_speculative) {
 	  _sw_alloc_vcs.push_back(make_pair(-1, make_pair(make_pair(input, vc),
 							  -1)));
@@ -437,7 +481,7 @@ void IQRouter::_InputQueuing( )
     BufferState * const dest_buf = _next_buf[output];
     
 #ifdef TRACK_FLOWS
-    for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+    for(Credit::VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
       int const vc = *iter;
       assert(!_outstanding_classes[output][vc].empty());
       int cl = _outstanding_classes[output][vc].front();
@@ -534,6 +578,9 @@ void IQRouter::_RouteUpdate( )
 
     cur_buf->Route(vc, _rf, this, f, input);
     cur_buf->SetState(vc, VC::vc_alloc);
+    if(f->trace) {
+      EventTrace::Add(EventTrace::route, f, GetID(), input, vc);
+    }
     if(_speculative) {
       _sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second, -1)));
     }
@@ -593,7 +640,7 @@ void IQRouter::_VCAllocEvaluate( )
     assert(route_set);
 
     int const out_priority = cur_buf->GetPriority(vc);
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    OutputSet const & setlist = route_set->GetSet();
 
     bool elig = false;
     bool cred = false;
@@ -601,7 +648,7 @@ void IQRouter::_VCAllocEvaluate( )
 
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(OutputSet::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
 
@@ -898,6 +945,9 @@ void IQRouter::_VCAllocUpdate( )
 	
       cur_buf->SetOutput(vc, match_output, match_vc);
       cur_buf->SetState(vc, VC::active);
+      if(f->trace) {
+	EventTrace::Add(EventTrace::vc_alloc, f, GetID(), match_output, match_vc);
+      }
       if(!_speculative) {
 	_sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first, -1)));
       }
@@ -1067,6 +1117,9 @@ void IQRouter::_SWHoldUpdate( )
 		   << "." << endl;
       }
       
+      if(f->trace) {
+	EventTrace::Add(EventTrace::sw_alloc, f, GetID(), output, match_vc);
+      }
       cur_buf->RemoveFlit(vc);
 
 #ifdef TRACK_FLOWS
@@ -1074,7 +1127,7 @@ void IQRouter::_SWHoldUpdate( )
       if(f->tail) --_active_packets[f->cl][input];
 #endif
 
-      _bufferMonitor->read(input, f) ;
+      _bufferMonitor->read(input, f, cur_buf->GetOccupancy()) ;
       
       f->hops++;
       f->vc = match_vc;
@@ -1397,11 +1450,11 @@ void IQRouter::_SWAllocEvaluate( )
     OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
     assert(route_set);
     
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    OutputSet const & setlist = route_set->GetSet();
     
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(OutputSet::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
       
@@ -1741,7 +1794,7 @@ void IQRouter::_SWAllocEvaluate( )
 	  OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
 	  assert(route_set);
 
-	  set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	  OutputSet const & setlist = route_set->GetSet();
 
 	  bool busy = true;
 	  bool full = true;
@@ -1749,7 +1802,7 @@ void IQRouter::_SWAllocEvaluate( )
 
 	  assert(!_noq || (setlist.size() == 1));
 
-	  for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	  for(OutputSet::const_iterator iset = setlist.begin();
 	      iset != setlist.end();
 	      ++iset) {
 	    if(iset->output_port == output) {
@@ -1896,11 +1949,11 @@ void IQRouter::_SWAllocUpdate( )
 	int match_prio = numeric_limits<int>::min();
 
 	const OutputSet * route_set = cur_buf->GetRouteSet(vc);
-	set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	OutputSet const & setlist = route_set->GetSet();
 	
 	assert(!_noq || (setlist.size() == 1));
 	
-	for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	for(OutputSet::const_iterator iset = setlist.begin();
 	    iset != setlist.end();
 	    ++iset) {
 	  if(iset->output_port == output) {
@@ -1977,6 +2030,9 @@ void IQRouter::_SWAllocUpdate( )
 		   << "." << endl;
       }
 
+      if(f->trace) {
+	EventTrace::Add(EventTrace::sw_alloc, f, GetID(), output, match_vc);
+      }
       cur_buf->RemoveFlit(vc);
 
 #ifdef TRACK_FLOWS
@@ -1984,7 +2040,7 @@ void IQRouter::_SWAllocUpdate( )
       if(f->tail) --_active_packets[f->cl][input];
 #endif
 
-      _bufferMonitor->read(input, f) ;
+      _bufferMonitor->read(input, f, cur_buf->GetOccupancy()) ;
 
       f->hops++;
       f->vc = match_vc;
@@ -2254,7 +2310,10 @@ void IQRouter::_SendFlits( )
 		    << " to channel at output " << output
 		    << "." << endl;
       if(gTrace) {
-	cout << "Outport " << output << endl << "Stop Mark" << endl;
+	cout << "Outport " << output << '\n' << "Stop Mark" << '\n';
+      }
+      if(f->trace) {
+	EventTrace::Add(EventTrace::traverse, f, GetID(), output, f->vc);
       }
       _output_channels[output]->Send( f );
     }
@@ -2350,18 +2409,16 @@ void IQRouter::_UpdateNOQ(int input, int vc, Flit const * f) {
   assert(f);
   assert(f->vc == vc);
   assert(f->head);
-  set<OutputSet::sSetElement> sl = f->la_route_set.GetSet();
-  assert(sl.size() == 1);
-  int out_port = sl.begin()->output_port;
+  assert(f->la_route_set.size() == 1);
+  int out_port = f->la_route_set.begin()->output_port;
   const FlitChannel * channel = _output_channels[out_port];
   const Router * router = channel->GetSink();
   if(router) {
     int in_channel = channel->GetSinkPort();
     OutputSet nos;
     _rf(router, f, in_channel, &nos, false);
-    sl = nos.GetSet();
-    assert(sl.size() == 1);
-    OutputSet::sSetElement const & se = *sl.begin();
+    assert(nos.size() == 1);
+    OutputSet::sSetElement const & se = *nos.begin();
     int next_output_port = se.output_port;
     assert(next_output_port >= 0);
     assert(_noq_next_output_port[input][vc] < 0);
@@ -2383,3 +2440,235 @@ void IQRouter::_UpdateNOQ(int input, int vc, Flit const * f) {
     }
   }
 }
+
+//------------------------------------------------------------------------------
+// checkpoints
+//------------------------------------------------------------------------------
+
+// VC allocation and switch hold/allocation queues share one entry layout
+typedef deque<pair<int, pair<pair<int, int>, int> > > tVCQueue;
+
+static void _SaveVCQueue( CheckpointWriter & writer, tVCQueue const & q )
+{
+  writer.WriteInt( q.size( ) );
+  for ( tVCQueue::const_iterator iter = q.begin( ); iter != q.end( ); ++iter ) {
+    writer.WriteInt( iter->first );
+    writer.WriteInt( iter->second.first.first );
+    writer.WriteInt( iter->second.first.second );
+    writer.WriteInt( iter->second.second );
+  }
+}
+
+static void _LoadVCQueue( CheckpointReader & reader, tVCQueue & q )
+{
+  q.clear( );
+  int const size = reader.ReadInt( );
+  for ( int i = 0; i < size; ++i ) {
+    int const time = reader.ReadInt( );
+    int const first = reader.ReadInt( );
+    int const second = reader.ReadInt( );
+    int const third = reader.ReadInt( );
+    q.push_back( make_pair( time, make_pair( make_pair( first, second ), third ) ) );
+  }
+}
+
+void IQRouter::SaveState( CheckpointWriter & writer ) const
+{
+#ifdef TRACK_FLOWS
+  Error( "Checkpoints are not supported with TRACK_FLOWS." );
+#endif
+
+  writer.WriteDouble( _partial_internal_cycles );
+  writer.WriteBool( _active );
+
+  writer.WriteInt( _in_queue_flits.size( ) );
+  for ( map<int, Flit *>::const_iterator iter = _in_queue_flits.begin( );
+        iter != _in_queue_flits.end( ); ++iter ) {
+    writer.WriteInt( iter->first );
+    writer.Write( iter->second );
+  }
+
+  writer.WriteInt( _proc_credits.size( ) );
+  for ( deque<pair<int, pair<Credit *, int> > >::const_iterator iter = _proc_credits.begin( );
+        iter != _proc_credits.end( ); ++iter ) {
+    writer.WriteInt( iter->first );
+    writer.Write( iter->second.first );
+    writer.WriteInt( iter->second.second );
+  }
+
+  writer.WriteInt( _route_vcs.size( ) );
+  for ( deque<pair<int, pair<int, int> > >::const_iterator iter = _route_vcs.begin( );
+        iter != _route_vcs.end( ); ++iter ) {
+    writer.WriteInt( iter->first );
+    writer.WriteInt( iter->second.first );
+    writer.WriteInt( iter->second.second );
+  }
+
+  _SaveVCQueue( writer, _vc_alloc_vcs );
+  _SaveVCQueue( writer, _sw_hold_vcs );
+  _SaveVCQueue( writer, _sw_alloc_vcs );
+
+  writer.WriteInt( _crossbar_flits.size( ) );
+  for ( deque<pair<int, pair<Flit *, pair<int, int> > > >::const_iterator iter = _crossbar_flits.begin( );
+        iter != _crossbar_flits.end( ); ++iter ) {
+    writer.WriteInt( iter->first );
+    writer.Write( iter->second.first );
+    writer.WriteInt( iter->second.second.first );
+    writer.WriteInt( iter->second.second.second );
+  }
+
+  writer.WriteInt( _out_queue_credits.size( ) );
+  for ( map<int, Credit *>::const_iterator iter = _out_queue_credits.begin( );
+        iter != _out_queue_credits.end( ); ++iter ) {
+    writer.WriteInt( iter->first );
+    writer.Write( iter->second );
+  }
+
+  for ( int i = 0; i < _inputs; ++i ) {
+    _buf[i]->SaveState( writer );
+  }
+  for ( int j = 0; j < _outputs; ++j ) {
+    _next_buf[j]->SaveState( writer );
+  }
+
+  if ( _vc_allocator ) {
+    _vc_allocator->SaveState( writer );
+  }
+  _sw_allocator->SaveState( writer );
+  if ( _spec_sw_allocator ) {
+    _spec_sw_allocator->SaveState( writer );
+  }
+
+  writer.WriteInts( _vc_rr_offset );
+  writer.WriteInts( _sw_rr_offset );
+
+  for ( int j = 0; j < _outputs; ++j ) {
+    queue<Flit *> q = _output_buffer[j];
+    writer.WriteInt( q.size( ) );
+    for ( ; !q.empty( ); q.pop( ) ) {
+      writer.Write( q.front( ) );
+    }
+  }
+  for ( int i = 0; i < _inputs; ++i ) {
+    queue<Credit *> q = _credit_buffer[i];
+    writer.WriteInt( q.size( ) );
+    for ( ; !q.empty( ); q.pop( ) ) {
+      writer.Write( q.front( ) );
+    }
+  }
+
+  writer.WriteInts( _switch_hold_in );
+  writer.WriteInts( _switch_hold_out );
+  writer.WriteInts( _switch_hold_vc );
+
+  for ( int i = 0; i < _inputs; ++i ) {
+    writer.WriteInts( _noq_next_output_port[i] );
+    writer.WriteInts( _noq_next_vc_start[i] );
+    writer.WriteInts( _noq_next_vc_end[i] );
+  }
+}
+
+void IQRouter::LoadState( CheckpointReader & reader )
+{
+#ifdef TRACK_FLOWS
+  Error( "Checkpoints are not supported with TRACK_FLOWS." );
+#endif
+
+  _partial_internal_cycles = reader.ReadDouble( );
+  _active = reader.ReadBool( );
+
+  _in_queue_flits.clear( );
+  int size = reader.ReadInt( );
+  for ( int n = 0; n < size; ++n ) {
+    int const input = reader.ReadInt( );
+    reader.Read( _in_queue_flits[input] );
+  }
+
+  _proc_credits.clear( );
+  size = reader.ReadInt( );
+  for ( int n = 0; n < size; ++n ) {
+    int const time = reader.ReadInt( );
+    Credit * c;
+    reader.Read( c );
+    int const output = reader.ReadInt( );
+    _proc_credits.push_back( make_pair( time, make_pair( c, output ) ) );
+  }
+
+  _route_vcs.clear( );
+  size = reader.ReadInt( );
+  for ( int n = 0; n < size; ++n ) {
+    int const time = reader.ReadInt( );
+    int const input = reader.ReadInt( );
+    int const vc = reader.ReadInt( );
+    _route_vcs.push_back( make_pair( time, make_pair( input, vc ) ) );
+  }
+
+  _LoadVCQueue( reader, _vc_alloc_vcs );
+  _LoadVCQueue( reader, _sw_hold_vcs );
+  _LoadVCQueue( reader, _sw_alloc_vcs );
+
+  _crossbar_flits.clear( );
+  size = reader.ReadInt( );
+  for ( int n = 0; n < size; ++n ) {
+    int const time = reader.ReadInt( );
+    Flit * f;
+    reader.Read( f );
+    int const input = reader.ReadInt( );
+    int const output = reader.ReadInt( );
+    _crossbar_flits.push_back( make_pair( time, make_pair( f, make_pair( input, output ) ) ) );
+  }
+
+  _out_queue_credits.clear( );
+  size = reader.ReadInt( );
+  for ( int n = 0; n < size; ++n ) {
+    int const input = reader.ReadInt( );
+    reader.Read( _out_queue_credits[input] );
+  }
+
+  for ( int i = 0; i < _inputs; ++i ) {
+    _buf[i]->LoadState( reader );
+  }
+  for ( int j = 0; j < _outputs; ++j ) {
+    _next_buf[j]->LoadState( reader );
+  }
+
+  if ( _vc_allocator ) {
+    _vc_allocator->LoadState( reader );
+  }
+  _sw_allocator->LoadState( reader );
+  if ( _spec_sw_allocator ) {
+    _spec_sw_allocator->LoadState( reader );
+  }
+
+  _vc_rr_offset = reader.ReadInts( );
+  _sw_rr_offset = reader.ReadInts( );
+
+  for ( int j = 0; j < _outputs; ++j ) {
+    _output_buffer[j] = queue<Flit *>( );
+    size = reader.ReadInt( );
+    for ( int n = 0; n < size; ++n ) {
+      Flit * f;
+      reader.Read( f );
+      _output_buffer[j].push( f );
+    }
+  }
+  for ( int i = 0; i < _inputs; ++i ) {
+    _credit_buffer[i] = queue<Credit *>( );
+    size = reader.ReadInt( );
+    for ( int n = 0; n < size; ++n ) {
+      Credit * c;
+      reader.Read( c );
+      _credit_buffer[i].push( c );
+    }
+  }
+
+  _switch_hold_in = reader.ReadInts( );
+  _switch_hold_out = reader.ReadInts( );
+  _switch_hold_vc = reader.ReadInts( );
+
+  for ( int i = 0; i < _inputs; ++i ) {
+    _noq_next_output_port[i] = reader.ReadInts( );
+    _noq_next_vc_start[i] = reader.ReadInts( );
+    _noq_next_vc_end[i] = reader.ReadInts( );
+  }
+}
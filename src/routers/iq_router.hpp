@@ -160,6 +160,11 @@ public:
 
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
+
+  virtual bool IsIdle( ) const;
+
+  virtual void SaveState( CheckpointWriter & writer ) const;
+  virtual void LoadState( CheckpointReader & reader );
   
   void Display( ostream & os = cout ) const;
 
@@ -178,6 +183,10 @@ public:
   SwitchMonitor const * const GetSwitchMonitor() const {return _switchMonitor;}
   BufferMonitor const * const GetBufferMonitor() const {return _bufferMonitor;}
 
+  // input buffer occupancy for the channel statistics (channel_stats_out)
+  void TrackBufferOccupancy( );
+  void ResetBufferOccupancy( );
+
 };
 
 #endif
@@ -125,6 +125,16 @@ bool Router::IsFaultyOutput( int c ) const
   return _channel_faults[c];
 }
 
+void Router::SaveState( CheckpointWriter & writer ) const
+{
+  Error( "Router type does not support checkpoints." );
+}
+
+void Router::LoadState( CheckpointReader & reader )
+{
+  Error( "Router type does not support checkpoints." );
+}
+
 /*Router constructor*/
 Router *Router::NewRouter( const Configuration& config,
 			   Module *parent, const string & name, int id,
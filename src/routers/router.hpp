@@ -110,11 +110,24 @@ public:
     assert((output >= 0) && (output < _outputs));
     return _output_channels[output];
   }
+  inline CreditChannel * GetOutputCredit( int output ) const {
+    assert((output >= 0) && (output < _outputs));
+    return _output_credits[output];
+  }
 
   virtual void ReadInputs( ) = 0;
   virtual void Evaluate( );
   virtual void WriteOutputs( ) = 0;
 
+  // true if Evaluate() and WriteOutputs() would do nothing until new flits
+  // or credits arrive; lets the event-driven kernel skip the router
+  virtual bool IsIdle( ) const { return false; }
+
+  // Checkpoints (checkpoint_save / checkpoint_load); router types that do
+  // not override these cannot be checkpointed
+  virtual void SaveState( CheckpointWriter & writer ) const;
+  virtual void LoadState( CheckpointReader & reader );
+
   void OutChannelFault( int c, bool fault = true );
   bool IsFaultyOutput( int c ) const;
 
@@ -56,6 +56,7 @@ void Stats::Clear( )
   _sample_squared_sum = 0.0;
 
   _hist.assign(_num_bins, 0);
+  _log_hist.clear();
 
   _min = numeric_limits<double>::quiet_NaN();
   _max = -numeric_limits<double>::quiet_NaN();
@@ -112,6 +113,86 @@ void Stats::AddSample( double val )
   b = (b >= _num_bins) ? (_num_bins - 1) : b;
 
   _hist[b]++;
+
+  int const lb = _LogBucket( val );
+  if ( lb >= (int)_log_hist.size( ) ) {
+    _log_hist.resize( lb + 1, 0 );
+  }
+  _log_hist[lb]++;
+}
+
+int Stats::_LogBucket( double val )
+{
+  int const sub_buckets = 1 << _log_sub_buckets;
+  // clamp to [0, INT_MAX]; NaN ends up in bucket 0
+  double const clamped = fmin( fmax( floor( val ), 0.0 ),
+                               (double)numeric_limits<int>::max( ) );
+  unsigned int const v = (unsigned int)clamped;
+  if ( v < (unsigned int)sub_buckets ) {
+    return v;
+  }
+  int const msb = 31 - __builtin_clz( v );
+  int const shift = msb - _log_sub_buckets + 1;
+  return sub_buckets + ( shift - 1 ) * ( sub_buckets / 2 ) +
+    (int)( v >> shift ) - sub_buckets / 2;
+}
+
+// largest value that falls into bucket b
+double Stats::_LogBucketHigh( int b )
+{
+  int const sub_buckets = 1 << _log_sub_buckets;
+  if ( b < sub_buckets ) {
+    return (double)b;
+  }
+  int const shift = ( b - sub_buckets ) / ( sub_buckets / 2 ) + 1;
+  int const offset = ( b - sub_buckets ) % ( sub_buckets / 2 ) + sub_buckets / 2;
+  return ldexp( (double)( offset + 1 ), shift ) - 1.0;
+}
+
+double Stats::Percentile( double q ) const
+{
+  if ( _num_samples == 0 ) {
+    return numeric_limits<double>::quiet_NaN();
+  }
+  // rank of the sample, counting from 1
+  double const rank = fmax( ceil( q * (double)_num_samples ), 1.0 );
+  double count = 0.0;
+  for ( size_t b = 0; b < _log_hist.size( ); ++b ) {
+    count += _log_hist[b];
+    if ( count >= rank ) {
+      return fmax( fmin( _LogBucketHigh( b ), _max ), _min );
+    }
+  }
+  return _max;
+}
+
+void Stats::Merge( Stats const & other )
+{
+  if ( other._num_samples == 0 ) {
+    return;
+  }
+
+  _num_samples += other._num_samples;
+  _sample_sum += other._sample_sum;
+  _sample_squared_sum += other._sample_squared_sum;
+
+  _max = !(other._max <= _max) ? other._max : _max;
+  _min = !(other._min >= _min) ? other._min : _min;
+
+  if ( ( _num_bins == other._num_bins ) && ( _bin_size == other._bin_size ) ) {
+    for ( int b = 0; b < _num_bins; ++b ) {
+      _hist[b] += other._hist[b];
+    }
+  } else {
+    Error( "Cannot merge statistics with different bins." );
+  }
+
+  if ( other._log_hist.size( ) > _log_hist.size( ) ) {
+    _log_hist.resize( other._log_hist.size( ), 0 );
+  }
+  for ( size_t b = 0; b < other._log_hist.size( ); ++b ) {
+    _log_hist[b] += other._log_hist[b];
+  }
 }
 
 void Stats::Display( ostream & os ) const
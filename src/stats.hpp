@@ -44,6 +44,17 @@ class Stats : public Module {
 
   vector<int> _hist;
 
+  // Log-linear histogram for percentiles (as in HDR histograms): values
+  // below 2^_log_sub_buckets get a bucket each; above that, every power of
+  // two is split into 2^(_log_sub_buckets-1) equal buckets, which bounds the
+  // relative error to 2^-(_log_sub_buckets-1). Samples are truncated to
+  // integers. Buckets are allocated up to the largest sample seen.
+  enum { _log_sub_buckets = 7 };
+  vector<int> _log_hist;
+
+  static int _LogBucket( double val );
+  static double _LogBucketHigh( int b );
+
 public:
   Stats( Module *parent, const string &name,
 	 double bin_size = 1.0, int num_bins = 10 );
@@ -58,6 +69,14 @@ public:
   double SquaredSum( ) const;
   int    NumSamples( ) const;
 
+  // value below which a fraction q of the samples lies (0 <= q <= 1),
+  // exact up to the bucket resolution; NaN if there are no samples
+  double Percentile( double q ) const;
+
+  // add the samples of another statistic, e.g. of a previous sample
+  // period or of another subnet
+  void Merge( Stats const & other );
+
   void AddSample( double val );
   inline void AddSample( int val ) {
     AddSample( (double)val );
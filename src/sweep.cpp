@@ -0,0 +1,647 @@
+// $Id$
+
+/*sweep.cpp
+ *
+ * In-process parameter sweep, replacing sweep_unitorus.sh
+ *
+ * The sweep reuses the parsed configuration and rebuilds the networks and
+ * traffic manager for every point, iterating over traffic pattern, VC
+ * count, vertical topology and injection rate (innermost). Results are
+ * written in the CSV format of results_unitorus.csv, followed by the 95%
+ * confidence half-widths of latency and throughput. As soon as a
+ * point turns out unstable, the remaining (higher) injection rates of
+ * that configuration are skipped.
+ *
+ * With sweep_jobs > 1 (or booksim --jobs N), points are run in forked
+ * worker processes, so every point gets its own copy of the simulator's
+ * global state (dimension globals, VC ranges, flit/credit pools, RNG).
+ * Workers report their result through a pipe; rows are written in sweep
+ * order regardless of completion order, and points beyond an unstable
+ * rate are discarded, so the CSV matches a sequential run.
+ *
+ * sim_type = saturation_search runs the same configurations, but instead
+ * of a fixed list of rates it brackets the saturation point (doubling the
+ * rate from saturation_min_rate until latency_thres is exceeded), bisects
+ * down to saturation_precision and finally samples a few points below the
+ * knee. Each probe is an ordinary latency simulation.
+ *
+ */
+
+#include "booksim.hpp"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <map>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "sweep.hpp"
+#include "routefunc.hpp"
+
+// Expand a list of values where each element is either a number or a
+// min:max:step range, e.g. {0.01:0.5:0.01} or {0.1,0.2,0.3}
+vector<double> ExpandSweepRange( string const & data )
+{
+  vector<double> values;
+  vector<string> const tokens = tokenize_str( data );
+  for ( size_t i = 0; i < tokens.size( ); ++i ) {
+    string const & token = tokens[i];
+    size_t const first = token.find( ':' );
+    if ( first == string::npos ) {
+      values.push_back( atof( token.c_str( ) ) );
+      continue;
+    }
+    size_t const second = token.find( ':', first + 1 );
+    if ( second == string::npos ) {
+      cerr << "Invalid sweep range \"" << token
+           << "\", expected min:max:step" << endl;
+      exit(-1);
+    }
+    double const min_val = atof( token.substr( 0, first ).c_str( ) );
+    double const max_val = atof( token.substr( first + 1, second - first - 1 ).c_str( ) );
+    double const step = atof( token.substr( second + 1 ).c_str( ) );
+    if ( ( step <= 0.0 ) || ( max_val < min_val ) ) {
+      cerr << "Invalid sweep range \"" << token << "\"" << endl;
+      exit(-1);
+    }
+    // compute the number of steps up front to avoid accumulating rounding
+    // errors; the small slack makes the upper bound inclusive like seq(1)
+    int const steps = (int)floor( ( max_val - min_val ) / step + 1e-6 );
+    for ( int s = 0; s <= steps; ++s ) {
+      values.push_back( min_val + s * step );
+    }
+  }
+  return values;
+}
+
+bool SweepEnabled( Configuration const & config )
+{
+  return !config.GetStr( "sweep_injection_rate" ).empty( );
+}
+
+struct SweepGroup {
+  string traffic;
+  string dim_sizes; // empty to keep the configured size
+  string size;      // Size column
+  int    vcs;
+  string vertical_topology;
+};
+
+struct SweepPoint {
+  int group;
+  int rate;    // index into the rate list
+};
+
+// trace file of a point, so that sweep points, including those run by
+// parallel workers, get a file each
+static string _PointTrace( string const & trace_out, int point )
+{
+  ostringstream point_trace;
+  point_trace << trace_out << '.' << point;
+  return point_trace.str( );
+}
+
+static void _RunPoint( BookSimConfig & config, SweepGroup const & group,
+                       double rate, int point, SimResult * result )
+{
+  config.Assign( "traffic", group.traffic );
+  if ( !group.dim_sizes.empty( ) ) {
+    config.Assign( "dim_sizes", group.dim_sizes );
+  }
+  config.Assign( "num_vcs", group.vcs );
+  config.Assign( "vertical_topology", group.vertical_topology );
+
+  // VC ranges are derived from num_vcs
+  InitializeRoutingMap( config );
+
+  // clear the vector form so the scalar rate takes effect
+  config.Assign( "injection_rate", string( "" ) );
+  config.Assign( "injection_rate", rate );
+
+  string const trace_out = config.GetStr( "trace_out" );
+  if ( !trace_out.empty( ) ) {
+    config.Assign( "trace_out", _PointTrace( trace_out, point ) );
+  }
+
+  Simulate( config, result );
+
+  config.Assign( "trace_out", trace_out );
+
+  result->stable = result->stable &&
+    !std::isnan( result->latency ) && !std::isnan( result->throughput );
+}
+
+// Run a point in a child process; returns the child's pid and the read end
+// of the pipe its result will arrive on
+static pid_t _ForkPoint( BookSimConfig & config, SweepGroup const & group,
+                         double rate, int point, int * fd )
+{
+  int pipe_fd[2];
+  if ( pipe( pipe_fd ) < 0 ) {
+    cerr << "Could not create pipe for sweep worker" << endl;
+    exit(-1);
+  }
+
+  // don't let the child inherit (and print again) pending output
+  cout.flush( );
+  cerr.flush( );
+
+  pid_t const pid = fork( );
+  if ( pid < 0 ) {
+    cerr << "Could not fork sweep worker" << endl;
+    exit(-1);
+  }
+
+  if ( pid == 0 ) {
+    close( pipe_fd[0] );
+    // per-point simulation output would interleave arbitrarily
+    if ( !freopen( "/dev/null", "w", stdout ) ) {
+      _exit(-1);
+    }
+    SimResult result;
+    _RunPoint( config, group, rate, point, &result );
+    cout.flush( );
+    ssize_t const written = write( pipe_fd[1], &result, sizeof( result ) );
+    close( pipe_fd[1] );
+    _exit( ( written == (ssize_t)sizeof( result ) ) ? 0 : -1 );
+  }
+
+  close( pipe_fd[1] );
+  *fd = pipe_fd[0];
+  return pid;
+}
+
+// Kill a worker whose point is no longer needed; its partial trace, if
+// any, is removed along with it
+static void _StopWorker( Configuration const & config, pid_t pid, int point,
+                         int fd )
+{
+  kill( pid, SIGTERM );
+  waitpid( pid, NULL, 0 );
+  close( fd );
+  string const trace_out = config.GetStr( "trace_out" );
+  if ( !trace_out.empty( ) ) {
+    remove( _PointTrace( trace_out, point ).c_str( ) );
+  }
+}
+
+// the Size column is the dimension list, quoted since it contains commas
+static string _SizeString( Configuration const & config )
+{
+  ostringstream size_str;
+  vector<int> const dim_sizes = config.GetIntArray( "dim_sizes" );
+  if ( dim_sizes.empty( ) ) {
+    size_str << config.GetInt( "k" );
+  }
+  for ( size_t d = 0; d < dim_sizes.size( ); ++d ) {
+    size_str << ( d ? "," : "" ) << dim_sizes[d];
+  }
+  return size_str.str( );
+}
+
+// Configurations to run, in sweep order
+static vector<SweepGroup> _SweepGroups( Configuration const & config )
+{
+  vector<string> traffics = config.GetStrArray( "sweep_traffic" );
+  if ( traffics.empty( ) ) {
+    traffics.push_back( config.GetStr( "traffic" ) );
+  }
+  vector<string> dim_sizes = config.GetStrArray( "sweep_dim_sizes" );
+  if ( dim_sizes.empty( ) ) {
+    dim_sizes.push_back( "" );
+  }
+  vector<int> vc_counts = config.GetIntArray( "sweep_num_vcs" );
+  if ( vc_counts.empty( ) ) {
+    vc_counts.push_back( config.GetInt( "num_vcs" ) );
+  }
+  vector<string> vertical_topos = config.GetStrArray( "sweep_vertical_topology" );
+  if ( vertical_topos.empty( ) ) {
+    vertical_topos.push_back( config.GetStr( "vertical_topology" ) );
+  }
+
+  vector<SweepGroup> groups;
+  for ( size_t t = 0; t < traffics.size( ); ++t ) {
+    for ( size_t d = 0; d < dim_sizes.size( ); ++d ) {
+      string size = _SizeString( config );
+      if ( !dim_sizes[d].empty( ) ) {
+        vector<int> const dims = tokenize_int( dim_sizes[d] );
+        ostringstream size_str;
+        for ( size_t i = 0; i < dims.size( ); ++i ) {
+          size_str << ( i ? "," : "" ) << dims[i];
+        }
+        size = size_str.str( );
+      }
+      for ( size_t v = 0; v < vc_counts.size( ); ++v ) {
+        for ( size_t vt = 0; vt < vertical_topos.size( ); ++vt ) {
+          SweepGroup g;
+          g.traffic = traffics[t];
+          g.dim_sizes = dim_sizes[d];
+          g.size = size;
+          g.vcs = vc_counts[v];
+          g.vertical_topology = vertical_topos[vt];
+          groups.push_back( g );
+        }
+      }
+    }
+  }
+  return groups;
+}
+
+
+static void _WriteHeader( ostream & os )
+{
+  os << "Traffic,InjectionRate,Size,VCs,VerticalTopology,AvgLatency,Throughput,"
+     << "LatencyCI,ThroughputCI" << endl;
+}
+
+static void _WriteRow( ostream & os, SweepGroup const & g,
+                       double rate, SimResult const & result )
+{
+  os << g.traffic << ',' << rate << ",\"" << g.size << "\","
+     << g.vcs << ',' << g.vertical_topology << ',';
+  if ( result.stable ) {
+    os << result.latency << ',' << result.throughput << ',';
+    // fewer than two batches leave the confidence intervals undefined
+    if ( result.latency_ci >= 0.0 ) {
+      os << result.latency_ci;
+    }
+    os << ',';
+    if ( result.throughput_ci >= 0.0 ) {
+      os << result.throughput_ci;
+    }
+    os << endl;
+  } else {
+    os << "inf,0,," << endl;
+  }
+}
+
+static ostream * _OpenOutput( string const & out_file, ofstream & file )
+{
+  if ( out_file == "-" ) {
+    return &cout;
+  }
+  file.open( out_file.c_str( ) );
+  if ( !file ) {
+    cerr << "Error: Could not open output file " << out_file << endl;
+    exit(-1);
+  }
+  return &file;
+}
+
+bool RunSweep( BookSimConfig & config )
+{
+  vector<double> const rates = ExpandSweepRange( config.GetStr( "sweep_injection_rate" ) );
+
+  int const jobs = config.GetInt( "sweep_jobs" );
+  if ( jobs < 1 ) {
+    cerr << "Invalid sweep_jobs " << jobs << endl;
+    exit(-1);
+  }
+
+  // points in sweep order, injection rate innermost
+  vector<SweepGroup> const groups = _SweepGroups( config );
+  vector<SweepPoint> points;
+  for ( size_t g = 0; g < groups.size( ); ++g ) {
+    for ( size_t r = 0; r < rates.size( ); ++r ) {
+      SweepPoint p;
+      p.group = g;
+      p.rate = r;
+      points.push_back( p );
+    }
+  }
+
+  string const out_file = config.GetStr( "sweep_output_file" );
+  ofstream csv;
+  ostream * os = _OpenOutput( out_file, csv );
+
+  _WriteHeader( *os );
+
+  vector<SimResult> results( points.size( ) );
+  vector<bool> done( points.size( ), false );
+  // index of the first unstable rate of each group
+  vector<int> cutoff( groups.size( ), rates.size( ) );
+
+  map<pid_t, pair<int, int> > running; // pid -> (point, result fd)
+  size_t next_point = 0;
+  size_t next_row = 0;
+
+  while ( next_row < points.size( ) ) {
+
+    // start as many points as there are free workers
+    while ( ( (int)running.size( ) < jobs ) && ( next_point < points.size( ) ) ) {
+      int const i = next_point++;
+      SweepPoint const & p = points[i];
+      if ( p.rate > cutoff[p.group] ) {
+        continue;
+      }
+      if ( jobs == 1 ) {
+        _RunPoint( config, groups[p.group], rates[p.rate], i, &results[i] );
+        done[i] = true;
+        if ( !results[i].stable ) {
+          cutoff[p.group] = p.rate;
+        }
+        break;
+      } else {
+        int fd;
+        pid_t const pid = _ForkPoint( config, groups[p.group], rates[p.rate], i, &fd );
+        running[pid] = make_pair( i, fd );
+      }
+    }
+
+    // collect one finished worker
+    if ( !running.empty( ) ) {
+      int status;
+      pid_t const pid = wait( &status );
+      if ( pid < 0 ) {
+        if ( errno == EINTR ) {
+          continue;
+        }
+        cerr << "Lost track of sweep workers" << endl;
+        exit(-1);
+      }
+      map<pid_t, pair<int, int> >::iterator iter = running.find( pid );
+      if ( iter != running.end( ) ) {
+        int const i = iter->second.first;
+        int const fd = iter->second.second;
+        running.erase( iter );
+        SimResult & result = results[i];
+        if ( read( fd, &result, sizeof( result ) ) != (ssize_t)sizeof( result ) ) {
+          // the worker died without reporting; count the point as failed
+          cerr << "Sweep worker for point " << i << " exited abnormally" << endl;
+          result.stable = false;
+        }
+        close( fd );
+        done[i] = true;
+        SweepPoint const & p = points[i];
+        if ( !result.stable && ( p.rate < cutoff[p.group] ) ) {
+          cutoff[p.group] = p.rate;
+          // points past the new cutoff are the slowest ones (they run to
+          // max_samples); free their workers now
+          for ( map<pid_t, pair<int, int> >::iterator kill_iter = running.begin( );
+                kill_iter != running.end( ); ) {
+            SweepPoint const & q = points[kill_iter->second.first];
+            if ( ( q.group == p.group ) && ( q.rate > cutoff[p.group] ) ) {
+              _StopWorker( config, kill_iter->first, kill_iter->second.first,
+                           kill_iter->second.second );
+              running.erase( kill_iter++ );
+            } else {
+              ++kill_iter;
+            }
+          }
+        }
+      }
+    }
+
+    // write all rows that are final, in sweep order
+    while ( next_row < points.size( ) ) {
+      SweepPoint const & p = points[next_row];
+      SweepGroup const & g = groups[p.group];
+      if ( p.rate > cutoff[p.group] ) {
+        ++next_row;
+        continue;
+      }
+      if ( !done[next_row] ) {
+        break;
+      }
+      SimResult const & result = results[next_row];
+
+      if ( p.rate == 0 ) {
+        cout << "Testing: Traffic=" << g.traffic
+             << ", Size=" << g.size
+             << ", VCs=" << g.vcs
+             << ", VerticalTopo=" << g.vertical_topology << endl;
+      }
+      cout << "  Injection rate: " << rates[p.rate] << endl;
+      if ( result.stable ) {
+        cout << "    SUCCESS: Latency=" << result.latency
+             << ", Throughput=" << result.throughput << endl;
+      } else {
+        cout << "    FAILED: Simulation unstable" << endl;
+      }
+
+      _WriteRow( *os, g, rates[p.rate], result );
+      if ( !result.stable ) {
+        cout << "    Stopping sweep for this configuration due to failure" << endl;
+      }
+      ++next_row;
+    }
+  }
+
+  // all rows are written, so any workers left are past an unstable rate
+  for ( map<pid_t, pair<int, int> >::iterator iter = running.begin( );
+        iter != running.end( ); ++iter ) {
+    _StopWorker( config, iter->first, iter->second.first, iter->second.second );
+  }
+
+  if ( out_file != "-" ) {
+    cout << "Sweep completed. Results saved to " << out_file << endl;
+  }
+
+  return true;
+}
+
+bool SaturationSearchEnabled( Configuration const & config )
+{
+  return config.GetStr( "sim_type" ) == "saturation_search";
+}
+
+// Probes of one configuration, by injection rate. Rates are rounded so
+// bisection midpoints and knee points that coincide are only run once.
+class _SaturationProbes {
+  BookSimConfig & _config;
+  SweepGroup const & _group;
+  map<double, SimResult> _results;
+  long long _cycles;
+
+public:
+  _SaturationProbes( BookSimConfig & config, SweepGroup const & group )
+    : _config( config ), _group( group ), _cycles( 0 ) { }
+
+  static double Round( double rate ) {
+    return floor( rate * 1e6 + 0.5 ) / 1e6;
+  }
+
+  SimResult const & Probe( double rate ) {
+    rate = Round( rate );
+    map<double, SimResult>::iterator iter = _results.find( rate );
+    if ( iter != _results.end( ) ) {
+      return iter->second;
+    }
+    SimResult & result = _results[rate];
+    // probes are numbered across all searches of this process
+    static int probe_count = 0;
+    _RunPoint( _config, _group, rate, probe_count++, &result );
+    _cycles += result.cycles;
+    cout << "  Injection rate: " << rate << endl;
+    if ( result.stable ) {
+      cout << "    SUCCESS: Latency=" << result.latency
+           << ", Throughput=" << result.throughput << endl;
+    } else {
+      cout << "    FAILED: Simulation unstable" << endl;
+    }
+    return result;
+  }
+
+  map<double, SimResult> const & Results( ) const { return _results; }
+  long long Cycles( ) const { return _cycles; }
+};
+
+// Bracket and bisect the saturation rate; returns the highest stable rate
+// (negative if even saturation_min_rate is unstable) and sets *hi to the
+// lowest unstable one (negative if saturation_max_rate is stable)
+static double _BracketSaturation( Configuration const & config,
+                                  _SaturationProbes & probes, double * hi )
+{
+  double const min_rate = config.GetFloat( "saturation_min_rate" );
+  double const max_rate = config.GetFloat( "saturation_max_rate" );
+  double const precision = config.GetFloat( "saturation_precision" );
+
+  // bracket: double the rate until a probe is unstable
+  double lo = -1.0; // highest stable rate
+  *hi = -1.0;       // lowest unstable rate
+  double rate = min_rate;
+  for ( ; ; ) {
+    if ( probes.Probe( rate ).stable ) {
+      lo = _SaturationProbes::Round( rate );
+      if ( rate >= max_rate ) {
+        break;
+      }
+      rate = min( 2.0 * rate, max_rate );
+    } else {
+      *hi = _SaturationProbes::Round( rate );
+      break;
+    }
+  }
+
+  // bisect
+  if ( ( lo >= 0.0 ) && ( *hi >= 0.0 ) ) {
+    while ( *hi - lo > precision ) {
+      double const mid = _SaturationProbes::Round( 0.5 * ( lo + *hi ) );
+      if ( ( mid <= lo ) || ( mid >= *hi ) ) {
+        break;
+      }
+      if ( probes.Probe( mid ).stable ) {
+        lo = mid;
+      } else {
+        *hi = mid;
+      }
+    }
+  }
+  return lo;
+}
+
+static void _CheckSaturationParameters( Configuration const & config )
+{
+  double const min_rate = config.GetFloat( "saturation_min_rate" );
+  double const max_rate = config.GetFloat( "saturation_max_rate" );
+  double const precision = config.GetFloat( "saturation_precision" );
+  int const knee_points = config.GetInt( "saturation_knee_points" );
+  double const knee_step = config.GetFloat( "saturation_knee_step" );
+  if ( ( min_rate <= 0.0 ) || ( max_rate < min_rate ) || ( precision <= 0.0 ) ||
+       ( knee_points < 0 ) || ( knee_step <= 0.0 ) ) {
+    cerr << "Invalid saturation search parameters" << endl;
+    exit(-1);
+  }
+}
+
+double FindSaturationRate( BookSimConfig & config )
+{
+  _CheckSaturationParameters( config );
+  config.Assign( "sim_type", string( "latency" ) );
+
+  SweepGroup g;
+  g.traffic = config.GetStr( "traffic" );
+  g.size = _SizeString( config );
+  g.vcs = config.GetInt( "num_vcs" );
+  g.vertical_topology = config.GetStr( "vertical_topology" );
+  _SaturationProbes probes( config, g );
+  double hi;
+  double const lo = _BracketSaturation( config, probes, &hi );
+  return max( lo, 0.0 );
+}
+
+bool RunSaturationSearch( BookSimConfig & config )
+{
+  _CheckSaturationParameters( config );
+  double const min_rate = config.GetFloat( "saturation_min_rate" );
+  double const max_rate = config.GetFloat( "saturation_max_rate" );
+  int const knee_points = config.GetInt( "saturation_knee_points" );
+  double const knee_step = config.GetFloat( "saturation_knee_step" );
+
+  // every probe is a latency simulation, which gives up as soon as the
+  // average latency exceeds latency_thres
+  config.Assign( "sim_type", string( "latency" ) );
+
+  vector<SweepGroup> const groups = _SweepGroups( config );
+
+  ofstream summary_file;
+  ostream * summary = _OpenOutput( config.GetStr( "saturation_output_file" ), summary_file );
+  *summary << "Traffic,Size,VCs,VerticalTopology,SaturationRate,Throughput,"
+           << "AvgLatency,Probes,Cycles" << endl;
+
+  string const probe_out = config.GetStr( "saturation_probe_file" );
+  ofstream probe_file;
+  ostream * probes_os = NULL;
+  if ( !probe_out.empty( ) ) {
+    probes_os = _OpenOutput( probe_out, probe_file );
+    _WriteHeader( *probes_os );
+  }
+
+  for ( size_t gi = 0; gi < groups.size( ); ++gi ) {
+    SweepGroup const & g = groups[gi];
+    cout << "Searching saturation: Traffic=" << g.traffic
+         << ", Size=" << g.size
+         << ", VCs=" << g.vcs
+         << ", VerticalTopo=" << g.vertical_topology << endl;
+
+    _SaturationProbes probes( config, g );
+    double hi;
+    double const lo = _BracketSaturation( config, probes, &hi );
+
+    // points just below the knee, for the shape of the latency curve
+    if ( lo > 0.0 ) {
+      for ( int i = 1; i <= knee_points; ++i ) {
+        double const knee_rate = lo - i * knee_step;
+        if ( knee_rate <= 0.0 ) {
+          break;
+        }
+        probes.Probe( knee_rate );
+      }
+    }
+
+    *summary << g.traffic << ",\"" << g.size << "\"," << g.vcs << ','
+             << g.vertical_topology << ',';
+    if ( lo < 0.0 ) {
+      cout << "  Saturated below the minimum rate " << min_rate << endl;
+      *summary << "0,0,inf,";
+    } else {
+      SimResult const & result = probes.Results( ).find( lo )->second;
+      if ( hi < 0.0 ) {
+        cout << "  Not saturated up to the maximum rate " << max_rate << endl;
+      }
+      cout << "  Saturation rate: " << lo << ", Throughput=" << result.throughput
+           << " (" << probes.Results( ).size( ) << " probes, "
+           << probes.Cycles( ) << " cycles)" << endl;
+      *summary << lo << ',' << result.throughput << ',' << result.latency << ',';
+    }
+    *summary << probes.Results( ).size( ) << ',' << probes.Cycles( ) << endl;
+
+    if ( probes_os ) {
+      map<double, SimResult> const & results = probes.Results( );
+      for ( map<double, SimResult>::const_iterator iter = results.begin( );
+            iter != results.end( ); ++iter ) {
+        _WriteRow( *probes_os, g, iter->first, iter->second );
+      }
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,38 @@
+// $Id$
+
+#ifndef _SWEEP_HPP_
+#define _SWEEP_HPP_
+
+#include "booksim_config.hpp"
+
+// Result of a single simulation point, as reported in the sweep CSV
+struct SimResult {
+  bool   stable;
+  double latency;     // packet latency average
+  double throughput;  // accepted packet rate average
+  double latency_ci;     // 95% confidence half-widths (batch means), -1
+                         // with fewer than two batches
+  double throughput_ci;
+  int    cycles;      // simulated cycles, including the drain
+};
+
+// defined in main.cpp
+bool Simulate( BookSimConfig const & config, SimResult * result = NULL );
+
+// Expand a list of values where each element is either a number or a
+// min:max:step range, e.g. {0.01:0.5:0.01} or {0.1,0.2,0.3}
+vector<double> ExpandSweepRange( string const & data );
+
+bool SweepEnabled( Configuration const & config );
+bool RunSweep( BookSimConfig & config );
+
+// sim_type = saturation_search
+bool SaturationSearchEnabled( Configuration const & config );
+bool RunSaturationSearch( BookSimConfig & config );
+
+// Saturation rate of the current configuration (bracket and bisection of
+// the saturation_search parameters, no knee points); 0 if even
+// saturation_min_rate is unstable
+double FindSaturationRate( BookSimConfig & config );
+
+#endif
@@ -0,0 +1,105 @@
+// $Id$
+
+/*thread_pool.cpp
+ *
+ * Worker threads used to evaluate routers in parallel (sim_threads)
+ *
+ * Jobs run in the parallel section must not touch shared simulator state
+ * other than the flit and credit pools (which are per thread), the random
+ * number generator (which is locked for the duration of Run()) and
+ * gWatchOut (which is buffered per worker and written out in part order,
+ * so watch output matches a sequential run).
+ *
+ */
+
+#include "booksim.hpp"
+#include "thread_pool.hpp"
+#include "globals.hpp"
+
+ThreadPool::ThreadPool( int threads )
+  : _threads( threads ), _generation( 0 ), _pending( 0 ), _stop( false ),
+    _job( NULL ), _arg( NULL ), _watch_out( NULL )
+{
+  assert( threads > 0 );
+  _watch_bufs.resize( threads );
+  for ( int t = 1; t < threads; ++t ) {
+    _watch_bufs[t] = new ostringstream;
+    _workers.push_back( thread( &ThreadPool::_Worker, this, t ) );
+  }
+}
+
+ThreadPool::~ThreadPool( )
+{
+  {
+    lock_guard<mutex> lock( _lock );
+    _stop = true;
+  }
+  _start.notify_all( );
+  for ( size_t i = 0; i < _workers.size( ); ++i ) {
+    _workers[i].join( );
+  }
+  for ( int t = 1; t < _threads; ++t ) {
+    delete _watch_bufs[t];
+  }
+}
+
+void ThreadPool::_Worker( int part )
+{
+  unsigned seen = 0;
+  for ( ;; ) {
+    {
+      unique_lock<mutex> lock( _lock );
+      while ( !_stop && ( _generation == seen ) ) {
+        _start.wait( lock );
+      }
+      if ( _stop ) {
+        return;
+      }
+      seen = _generation;
+    }
+
+    gWatchOut = _watch_out ? _watch_bufs[part] : NULL;
+    _job( _arg, part, _threads );
+
+    {
+      lock_guard<mutex> lock( _lock );
+      if ( --_pending == 0 ) {
+        _done.notify_one( );
+      }
+    }
+  }
+}
+
+void ThreadPool::Run( Job job, void * arg )
+{
+  if ( _threads == 1 ) {
+    job( arg, 0, 1 );
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock( _lock );
+    _job = job;
+    _arg = arg;
+    _watch_out = gWatchOut;
+    _pending = _threads - 1;
+    ++_generation;
+  }
+  _start.notify_all( );
+
+  job( arg, 0, _threads );
+
+  {
+    unique_lock<mutex> lock( _lock );
+    while ( _pending > 0 ) {
+      _done.wait( lock );
+    }
+  }
+
+  if ( _watch_out ) {
+    for ( int t = 1; t < _threads; ++t ) {
+      *_watch_out << _watch_bufs[t]->str( );
+      _watch_bufs[t]->str( "" );
+    }
+  }
+}
@@ -0,0 +1,47 @@
+// $Id$
+
+#ifndef _THREAD_POOL_HPP_
+#define _THREAD_POOL_HPP_
+
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Persistent set of worker threads running one job at a time. Run() splits
+// the job into NumThreads() parts; the calling thread runs part 0 and returns
+// once every part has finished, so each call acts as a barrier.
+class ThreadPool {
+public:
+  typedef void (*Job)( void * arg, int part, int parts );
+
+  ThreadPool( int threads );
+  ~ThreadPool( );
+
+  inline int NumThreads( ) const { return _threads; }
+
+  void Run( Job job, void * arg );
+
+private:
+  int _threads;
+  std::vector<std::thread> _workers;
+
+  std::mutex _lock;
+  std::condition_variable _start;
+  std::condition_variable _done;
+  unsigned _generation;
+  int _pending;
+  bool _stop;
+
+  Job _job;
+  void * _arg;
+
+  // watch output of the workers, appended to gWatchOut in part order
+  std::ostream * _watch_out;
+  std::vector<std::ostringstream *> _watch_bufs;
+
+  void _Worker( int part );
+};
+
+#endif
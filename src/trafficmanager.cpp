@@ -36,6 +36,8 @@
 #include "booksim_config.hpp"
 #include "trafficmanager.hpp"
 #include "batchtrafficmanager.hpp"
+#include "unitorus.hpp"
+#include "event_trace.hpp"
 #include "random_utils.hpp" 
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
@@ -232,6 +234,36 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _injection_process[c] = InjectionProcess::New(injection_process[c], _nodes, _load[c], &config);
     }
 
+    // replies are issued on demand, so they cannot be sampled in advance
+    _inject_skip_ahead = (config.GetInt("injection_skip_ahead") > 0);
+    for(int c = 0; c < _classes; ++c) {
+        if(_use_read_write[c] || !_injection_process[c]->can_skip()) {
+            _inject_skip_ahead = false;
+        }
+    }
+
+    // ============ Trace-driven injection ============ 
+
+    _packet_trace = NULL;
+    _packet_trace_replies = false;
+    _packet_trace_done = false;
+    _packet_trace_time = numeric_limits<int>::min();
+    string const packet_trace = config.GetStr("packet_trace");
+    if(!packet_trace.empty()) {
+        if(_classes > 1) {
+            Error("Trace-driven injection supports a single traffic class.");
+        }
+        int const window = config.GetInt("packet_trace_window");
+        if(window <= 0) {
+            Error("packet_trace_window must be positive.");
+        }
+        _packet_trace = new PacketTrace(packet_trace, (size_t)window << 20);
+        _packet_trace_replies = (config.GetInt("packet_trace_replies") > 0);
+        _inject_skip_ahead = false;
+        _trace_queue.resize(_nodes);
+        _trace_is_active.resize(_nodes, false);
+    }
+
     // ============ Injection VC states  ============ 
 
     _buf_states.resize(_nodes);
@@ -278,15 +310,30 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _qdrained[s].resize(_classes);
         _partial_packets[s].resize(_classes);
     }
+    if(_inject_skip_ahead) {
+        _next_arrival.resize(_nodes, vector<int>(_classes, 0));
+    }
 
     _total_in_flight_flits.resize(_classes);
     _measured_in_flight_flits.resize(_classes);
     _retired_packets.resize(_classes);
+    _ejecting_flits.resize(_subnets, vector<Flit *>(_nodes, NULL));
 
     _packet_seq_no.resize(_nodes);
     _repliesPending.resize(_nodes);
     _requestsOutstanding.resize(_nodes);
 
+    // ============ Checkpoints ============
+
+    _topology = config.GetStr("topology");
+    _routing_function = config.GetStr("routing_function");
+    _vc_buf_size = config.GetInt("vc_buf_size");
+    _buf_size = config.GetInt("buf_size");
+    _checkpoint_save = config.GetStr("checkpoint_save");
+    _checkpoint_load = config.GetStr("checkpoint_load");
+    _checkpoint_seed = config.GetInt("checkpoint_seed");
+    _resume_phases = 0;
+
     _hold_switch_for_packet = config.GetInt("hold_switch_for_packet");
 
     // ============ Simulation parameters ============ 
@@ -307,6 +354,9 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
       seed = config.GetInt("seed");
     }
     RandomSeed(seed);
+    for (int i=0; i < _subnets; ++i) {
+        _net[i]->SeedRouters(seed, i);
+    }
 
     _measure_latency = (config.GetStr("sim_type") == "latency");
 
@@ -320,6 +370,12 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     }
     _measure_stats.resize(_classes, _measure_stats.back());
     _pair_stats = (config.GetInt("pair_stats")==1);
+    _pair_stats_out = config.GetStr("pair_stats_out");
+    string const pair_stats_format = config.GetStr("pair_stats_format");
+    if((pair_stats_format != "csv") && (pair_stats_format != "binary")) {
+        Error("Unknown pair_stats_format: " + pair_stats_format);
+    }
+    _pair_stats_binary = (pair_stats_format == "binary");
 
     _latency_thres = config.GetFloatArray( "latency_thres" );
     if(_latency_thres.empty()) {
@@ -351,6 +407,17 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     }
     _acc_stopping_threshold.resize(_classes, _acc_stopping_threshold.back());
 
+    string const stopping_mode = config.GetStr( "stopping_mode" );
+    if(stopping_mode == "confidence") {
+        _ci_stopping = true;
+    } else if(stopping_mode == "change") {
+        _ci_stopping = false;
+    } else {
+        Error("Unknown stopping_mode: " + stopping_mode);
+    }
+    _ci_precision = config.GetFloat( "confidence_precision" );
+    _ci_min_batches = max(config.GetInt( "confidence_min_batches" ), 2);
+
     _include_queuing = config.GetInt( "include_queuing" );
 
     _print_csv_results = config.GetInt( "print_csv_results" );
@@ -380,6 +447,40 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _stats_out = new ofstream(stats_out_file.c_str());
         config.WriteMatlabFile(_stats_out);
     }
+
+    string channel_stats_out_file = config.GetStr( "channel_stats_out" );
+    if(channel_stats_out_file == "") {
+        _channel_stats_out = NULL;
+    } else {
+        _channel_stats_out = new ofstream(channel_stats_out_file.c_str());
+        if(!*_channel_stats_out) {
+            Error("Could not open channel_stats_out file " + channel_stats_out_file);
+        }
+        _net[0]->WriteChannelStatsHeader(*_channel_stats_out, "sample,state,subnet,");
+    }
+
+    _elevator_stats.resize(_subnets, NULL);
+    bool have_elevator_stats = false;
+    for(int s = 0; s < _subnets; ++s) {
+        UniTorus const * const unitorus = dynamic_cast<UniTorus const *>(_net[s]);
+        if(unitorus) {
+            _elevator_stats[s] = unitorus->GetElevatorStats();
+            have_elevator_stats = have_elevator_stats || _elevator_stats[s];
+        }
+    }
+    if((config.GetInt("elevator_stats") > 0) && !have_elevator_stats) {
+        Error("elevator_stats requires the unitorus topology.");
+    }
+    string elevator_stats_out_file = config.GetStr( "elevator_stats_out" );
+    if(!have_elevator_stats || (elevator_stats_out_file == "")) {
+        _elevator_stats_out = NULL;
+    } else {
+        _elevator_stats_out = new ofstream(elevator_stats_out_file.c_str());
+        if(!*_elevator_stats_out) {
+            Error("Could not open elevator_stats_out file " + elevator_stats_out_file);
+        }
+        ElevatorStats::WriteHeader(*_elevator_stats_out, "sample,state,subnet,");
+    }
   
 #ifdef TRACK_FLOWS
     _injected_flits.resize(_classes, vector<int>(_nodes, 0));
@@ -466,6 +567,10 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _overall_avg_flat.resize(_classes, 0.0);
     _overall_max_flat.resize(_classes, 0.0);
 
+    _overall_plat_dist.resize(_classes);
+    _overall_nlat_dist.resize(_classes);
+    _overall_flat_dist.resize(_classes);
+
     _frag_stats.resize(_classes);
     _overall_min_frag.resize(_classes, 0.0);
     _overall_avg_frag.resize(_classes, 0.0);
@@ -479,6 +584,18 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
   
     _hop_stats.resize(_classes);
     _overall_hop_stats.resize(_classes, 0.0);
+
+    _batch_plat.resize(_classes);
+    _batch_accepted.resize(_classes);
+    _batch_plat_sum.resize(_classes, 0.0);
+    _batch_plat_count.resize(_classes, 0);
+    _batch_accepted_count.resize(_classes, 0);
+    _plat_ci.resize(_classes, 0.0);
+    _accepted_ci.resize(_classes, 0.0);
+    _overall_batch_plat.resize(_classes);
+    _overall_batch_accepted.resize(_classes);
+    _overall_plat_ci.resize(_classes, -1.0);
+    _overall_accepted_ci.resize(_classes, -1.0);
   
     _sent_packets.resize(_classes);
     _overall_min_sent_packets.resize(_classes, 0.0);
@@ -529,6 +646,18 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _stats[tmp_name.str()] = _flat_stats[c];
         tmp_name.str("");
 
+        tmp_name << "overall_plat_dist_" << c;
+        _overall_plat_dist[c] = new Stats( this, tmp_name.str( ), 1.0, 1000 );
+        tmp_name.str("");
+
+        tmp_name << "overall_nlat_dist_" << c;
+        _overall_nlat_dist[c] = new Stats( this, tmp_name.str( ), 1.0, 1000 );
+        tmp_name.str("");
+
+        tmp_name << "overall_flat_dist_" << c;
+        _overall_flat_dist[c] = new Stats( this, tmp_name.str( ), 1.0, 1000 );
+        tmp_name.str("");
+
         tmp_name << "frag_stat_" << c;
         _frag_stats[c] = new Stats( this, tmp_name.str( ), 1.0, 100 );
         _stats[tmp_name.str()] = _frag_stats[c];
@@ -539,12 +668,6 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _stats[tmp_name.str()] = _hop_stats[c];
         tmp_name.str("");
 
-        if(_pair_stats){
-            _pair_plat[c].resize(_nodes*_nodes);
-            _pair_nlat[c].resize(_nodes*_nodes);
-            _pair_flat[c].resize(_nodes*_nodes);
-        }
-
         _sent_packets[c].resize(_nodes, 0);
         _accepted_packets[c].resize(_nodes, 0);
         _sent_flits[c].resize(_nodes, 0);
@@ -558,24 +681,19 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _crossbar_conflict_stalls[c].resize(_subnets*_routers, 0);
 #endif
         if(_pair_stats){
-            for ( int i = 0; i < _nodes; ++i ) {
-                for ( int j = 0; j < _nodes; ++j ) {
-                    tmp_name << "pair_plat_stat_" << c << "_" << i << "_" << j;
-                    _pair_plat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
-                    _stats[tmp_name.str()] = _pair_plat[c][i*_nodes+j];
-                    tmp_name.str("");
-	  
-                    tmp_name << "pair_nlat_stat_" << c << "_" << i << "_" << j;
-                    _pair_nlat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
-                    _stats[tmp_name.str()] = _pair_nlat[c][i*_nodes+j];
-                    tmp_name.str("");
-	  
-                    tmp_name << "pair_flat_stat_" << c << "_" << i << "_" << j;
-                    _pair_flat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
-                    _stats[tmp_name.str()] = _pair_flat[c][i*_nodes+j];
-                    tmp_name.str("");
-                }
-            }
+            bool const sketch = (config.GetInt("pair_stats_sketch") > 0);
+
+            tmp_name << "pair_plat_stat_" << c;
+            _pair_plat[c] = new PairStats( this, tmp_name.str( ), _nodes, sketch );
+            tmp_name.str("");
+
+            tmp_name << "pair_nlat_stat_" << c;
+            _pair_nlat[c] = new PairStats( this, tmp_name.str( ), _nodes, sketch );
+            tmp_name.str("");
+
+            tmp_name << "pair_flat_stat_" << c;
+            _pair_flat[c] = new PairStats( this, tmp_name.str( ), _nodes, sketch );
+            tmp_name.str("");
         }
     }
 
@@ -599,24 +717,25 @@ TrafficManager::~TrafficManager( )
         delete _plat_stats[c];
         delete _nlat_stats[c];
         delete _flat_stats[c];
+        delete _overall_plat_dist[c];
+        delete _overall_nlat_dist[c];
+        delete _overall_flat_dist[c];
         delete _frag_stats[c];
         delete _hop_stats[c];
 
         delete _traffic_pattern[c];
         delete _injection_process[c];
         if(_pair_stats){
-            for ( int i = 0; i < _nodes; ++i ) {
-                for ( int j = 0; j < _nodes; ++j ) {
-                    delete _pair_plat[c][i*_nodes+j];
-                    delete _pair_nlat[c][i*_nodes+j];
-                    delete _pair_flat[c][i*_nodes+j];
-                }
-            }
+            delete _pair_plat[c];
+            delete _pair_nlat[c];
+            delete _pair_flat[c];
         }
     }
   
     if(gWatchOut && (gWatchOut != &cout)) delete gWatchOut;
     if(_stats_out && (_stats_out != &cout)) delete _stats_out;
+    if(_channel_stats_out) delete _channel_stats_out;
+    if(_elevator_stats_out) delete _elevator_stats_out;
 
 #ifdef TRACK_FLOWS
     if(_injected_flits_out) delete _injected_flits_out;
@@ -634,6 +753,8 @@ TrafficManager::~TrafficManager( )
     if(_max_credits_out) delete _max_credits_out;
 #endif
 
+    if(_packet_trace) delete _packet_trace;
+
     PacketReplyInfo::FreeAll();
     Flit::FreeAll();
     Credit::FreeAll();
@@ -644,12 +765,12 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
 {
     _deadlock_timer = 0;
 
-    assert(_total_in_flight_flits[f->cl].count(f->id) > 0);
-    _total_in_flight_flits[f->cl].erase(f->id);
+    assert(_total_in_flight_flits[f->cl].Find(f->id));
+    _total_in_flight_flits[f->cl].Erase(f->id);
   
     if(f->record) {
-        assert(_measured_in_flight_flits[f->cl].count(f->id) > 0);
-        _measured_in_flight_flits[f->cl].erase(f->id);
+        assert(_measured_in_flight_flits[f->cl].Find(f->id));
+        _measured_in_flight_flits[f->cl].Erase(f->id);
     }
 
     if ( f->watch ) { 
@@ -664,6 +785,10 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
                    << ")." << endl;
     }
 
+    if ( f->trace ) {
+        EventTrace::Add( EventTrace::eject, f, dest, -1, f->vc );
+    }
+
     if ( f->head && ( f->dest != dest ) ) {
         ostringstream err;
         err << "Flit " << f->id << " arrived at incorrect output " << dest;
@@ -678,7 +803,7 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
             _slowest_flit[f->cl] = f->id;
         _flat_stats[f->cl]->AddSample( f->atime - f->itime);
         if(_pair_stats){
-            _pair_flat[f->cl][f->src*_nodes+dest]->AddSample( f->atime - f->itime );
+            _pair_flat[f->cl]->AddSample( f->src, dest, f->atime - f->itime );
         }
     }
       
@@ -687,10 +812,9 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
         if(f->head) {
             head = f;
         } else {
-            map<int, Flit *>::iterator iter = _retired_packets[f->cl].find(f->pid);
-            assert(iter != _retired_packets[f->cl].end());
-            head = iter->second;
-            _retired_packets[f->cl].erase(iter);
+            head = _retired_packets[f->cl].Find(f->pid);
+            assert(head);
+            _retired_packets[f->cl].Erase(f->pid);
             assert(head->head);
             assert(f->pid == head->pid);
         }
@@ -708,15 +832,23 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
 
         //code the source of request, look carefully, its tricky ;)
         if (f->type == Flit::READ_REQUEST || f->type == Flit::WRITE_REQUEST) {
-            PacketReplyInfo* rinfo = PacketReplyInfo::New();
-            rinfo->source = f->src;
-            rinfo->time = f->atime;
-            rinfo->record = f->record;
-            rinfo->type = f->type;
-            _repliesPending[dest].push_back(rinfo);
+            if (!_packet_trace || _packet_trace_replies) {
+                PacketReplyInfo* rinfo = PacketReplyInfo::New();
+                rinfo->source = f->src;
+                rinfo->time = f->atime;
+                rinfo->record = f->record;
+                rinfo->type = f->type;
+                _repliesPending[dest].push_back(rinfo);
+                if (_packet_trace) {
+                    _ActivateTraceSource(dest);
+                }
+            }
         } else {
             if(f->type == Flit::READ_REPLY || f->type == Flit::WRITE_REPLY  ){
-                _requestsOutstanding[dest]--;
+                // replies from a trace were never counted as outstanding
+                if (!_packet_trace || _packet_trace_replies) {
+                    _requestsOutstanding[dest]--;
+                }
             } else if(f->type == Flit::ANY_TYPE) {
                 _requestsOutstanding[f->src]--;
             }
@@ -742,8 +874,8 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
                 _frag_stats[f->cl]->AddSample( (f->atime - head->atime) - (f->id - head->id) );
 
                 if(_pair_stats){
-                    _pair_plat[f->cl][f->src*_nodes+dest]->AddSample( f->atime - head->ctime );
-                    _pair_nlat[f->cl][f->src*_nodes+dest]->AddSample( f->atime - head->itime );
+                    _pair_plat[f->cl]->AddSample( f->src, dest, f->atime - head->ctime );
+                    _pair_nlat[f->cl]->AddSample( f->src, dest, f->atime - head->itime );
                 }
             }
             // If self-loop: statistics collection is skipped entirely
@@ -757,7 +889,7 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
     }
   
     if(f->head && !f->tail) {
-        _retired_packets[f->cl].insert(make_pair(f->pid, f));
+        _retired_packets[f->cl].Insert(f->pid, f);
     } else {
         f->Free();
     }
@@ -801,11 +933,8 @@ void TrafficManager::_GeneratePacket( int source, int stype,
 
     Flit::FlitType packet_type = Flit::ANY_TYPE;
     int size = _GetNextPacketSize(cl); //input size 
-    int pid = _cur_pid++;
-    assert(_cur_pid);
     int packet_destination = _traffic_pattern[cl]->dest(source);
     bool record = false;
-    bool watch = gWatchOut && (_packets_to_watch.count(pid) > 0);
     if(_use_read_write[cl]){
         if(stype > 0) {
             if (stype == 1) {
@@ -840,6 +969,19 @@ void TrafficManager::_GeneratePacket( int source, int stype,
         }
     }
 
+    _EnqueuePacket( source, packet_destination, size, packet_type, cl, time,
+                    record );
+}
+
+void TrafficManager::_EnqueuePacket( int source, int packet_destination,
+                                     int size, Flit::FlitType packet_type,
+                                     int cl, int time, bool record )
+{
+    int pid = _cur_pid++;
+    assert(_cur_pid);
+    bool watch = gWatchOut && (_packets_to_watch.count(pid) > 0);
+    bool const trace = EventTrace::Sample(pid);
+
     if ((packet_destination <0) || (packet_destination >= _nodes)) {
         ostringstream err;
         err << "Incorrect packet destination " << packet_destination
@@ -870,19 +1012,20 @@ void TrafficManager::_GeneratePacket( int source, int stype,
         assert(_cur_id);
         f->pid    = pid;
         f->watch  = watch | (gWatchOut && (_flits_to_watch.count(f->id) > 0));
+        f->trace  = trace;
         f->subnetwork = subnetwork;
         f->src    = source;
         f->ctime  = time;
         f->record = record;
         f->cl     = cl;
 
-        _total_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+        _total_in_flight_flits[f->cl].Insert(f->id, f);
         if(record) {
-            _measured_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+            _measured_in_flight_flits[f->cl].Insert(f->id, f);
         }
     
         if(gTrace){
-            cout<<"New Flit "<<f->src<<endl;
+            cout<<"New Flit "<<f->src<<'\n';
         }
         f->type = packet_type;
 
@@ -933,6 +1076,16 @@ void TrafficManager::_GeneratePacket( int source, int stype,
 
 void TrafficManager::_Inject(){
 
+    if(_packet_trace) {
+        _InjectTrace();
+        return;
+    }
+
+    if(_inject_skip_ahead) {
+        _InjectSkipAhead();
+        return;
+    }
+
     for ( int input = 0; input < _nodes; ++input ) {
         for ( int c = 0; c < _classes; ++c ) {
             // Potentially generate packets for any (input,class)
@@ -963,19 +1116,224 @@ void TrafficManager::_Inject(){
     }
 }
 
+// Skip-ahead equivalent of one iteration of the loop in _Inject() for a
+// source that is not busy: issue the packet that arrived at
+// _next_arrival[source][cl], if it is due, and sample the next arrival.
+// Returns false if the source is still queueing its previous packet.
+bool TrafficManager::_InjectFromSource( int source, int cl )
+{
+    if ( !_partial_packets[source][cl].empty() ) {
+        return false;
+    }
+    int & next = _next_arrival[source][cl];
+    if ( next <= _time ) {
+        _requestsOutstanding[source]++;
+        _packet_seq_no[source]++;
+        _GeneratePacket( source, 1, cl, 
+                         _include_queuing==1 ? next : _time );
+        _qtime[source][cl] = next + 1;
+        int const gap = _injection_process[cl]->next(source);
+        next = ( gap < numeric_limits<int>::max() - _qtime[source][cl] ) ?
+            _qtime[source][cl] + gap : numeric_limits<int>::max();
+    } else {
+        _qtime[source][cl] = _time + 1;
+    }
+    if ( ( _sim_state == draining ) && 
+         ( _qtime[source][cl] > _drain_time ) ) {
+        _qdrained[source][cl] = true;
+    }
+    return true;
+}
+
+void TrafficManager::_ScheduleArrival( int source, int cl )
+{
+    int const next = _next_arrival[source][cl];
+    if ( next <= _time ) {
+        _arrivals_due.push_back( source * _classes + cl );
+    } else if ( next < numeric_limits<int>::max() ) {
+        _arrivals.push( make_pair( next, source * _classes + cl ) );
+    }
+}
+
+void TrafficManager::_InjectSkipAhead(){
+
+    // while draining, every source has to be visited anyway to see when its
+    // queue has drained
+    if ( _sim_state == draining ) {
+        for ( int input = 0; input < _nodes; ++input ) {
+            for ( int c = 0; c < _classes; ++c ) {
+                _InjectFromSource( input, c );
+            }
+        }
+        return;
+    }
+
+    vector<int> due;
+    due.swap( _arrivals_due );
+    for ( size_t i = 0; i < due.size(); ++i ) {
+        int const input = due[i] / _classes;
+        int const c = due[i] % _classes;
+        if ( _InjectFromSource( input, c ) ) {
+            _ScheduleArrival( input, c );
+        } else {
+            _arrivals_due.push_back( due[i] );
+        }
+    }
+
+    while ( !_arrivals.empty() && ( _arrivals.top().first <= _time ) ) {
+        int const input = _arrivals.top().second / _classes;
+        int const c = _arrivals.top().second % _classes;
+        _arrivals.pop();
+        if ( _InjectFromSource( input, c ) ) {
+            _ScheduleArrival( input, c );
+        } else {
+            _arrivals_due.push_back( input * _classes + c );
+        }
+    }
+}
+
+// Sample the first arrival of every source at the start of a simulation
+void TrafficManager::_ResetArrivals()
+{
+    _arrivals = priority_queue<pair<int, int>, vector<pair<int, int> >,
+                               greater<pair<int, int> > >();
+    _arrivals_due.clear();
+    for ( int input = 0; input < _nodes; ++input ) {
+        for ( int c = 0; c < _classes; ++c ) {
+            _next_arrival[input][c] = _injection_process[c]->next(input);
+            _ScheduleArrival( input, c );
+        }
+    }
+}
+
+// Trace-driven injection: queue the trace records that are due at their
+// sources, then let every idle source with work issue one packet. As in
+// _IssuePacket(), pending replies go first.
+void TrafficManager::_InjectTrace()
+{
+    PacketTrace::Record const * r;
+    while ( ( r = _packet_trace->Peek() ) && ( r->time <= _time ) ) {
+        // a record out of order would be injected late and its delay
+        // counted as latency
+        if ( r->time < _packet_trace_time ) {
+            ostringstream err;
+            err << "Packet trace is not sorted by time at record "
+                << _packet_trace->Position() << " (time = " << r->time
+                << " after " << _packet_trace_time << ")";
+            Error( err.str( ) );
+        }
+        if ( ( r->src < 0 ) || ( r->src >= _nodes ) ||
+             ( r->dest < 0 ) || ( r->dest >= _nodes ) || ( r->size <= 0 ) ||
+             ( r->type < 0 ) || ( r->type >= Flit::NUM_FLIT_TYPES ) ) {
+            ostringstream err;
+            err << "Invalid packet trace record " << _packet_trace->Position()
+                << " (time = " << r->time << ", src = " << r->src
+                << ", dest = " << r->dest << ", size = " << r->size
+                << ", type = " << r->type << ")";
+            Error( err.str( ) );
+        }
+        // with packet_trace_replies, replies are generated for the traced
+        // requests instead
+        bool const reply = ( ( r->type == Flit::READ_REPLY ) ||
+                             ( r->type == Flit::WRITE_REPLY ) );
+        if ( !reply || !_packet_trace_replies ) {
+            _trace_queue[r->src].push_back( *r );
+            _ActivateTraceSource( r->src );
+        }
+        _packet_trace_time = r->time;
+        _packet_trace->Pop();
+    }
+    if ( !r && !_packet_trace_done ) {
+        cout << "Packet trace ends at time " << _time << endl;
+        _packet_trace_done = true;
+    }
+
+    size_t active = 0;
+    for ( size_t i = 0; i < _trace_active.size(); ++i ) {
+        int const source = _trace_active[i];
+        deque<PacketTrace::Record> & queue = _trace_queue[source];
+        list<PacketReplyInfo *> & replies = _repliesPending[source];
+        if ( _partial_packets[source][0].empty() ) {
+            if ( !replies.empty() && ( replies.front()->time <= _time ) ) {
+                PacketReplyInfo * const rinfo = replies.front();
+                replies.pop_front();
+                Flit::FlitType const type =
+                    ( rinfo->type == Flit::READ_REQUEST ) ?
+                    Flit::READ_REPLY : Flit::WRITE_REPLY;
+                int const size = ( type == Flit::READ_REPLY ) ?
+                    _read_reply_size[0] : _write_reply_size[0];
+                _packet_seq_no[source]++;
+                _EnqueuePacket( source, rinfo->source, size, type, 0,
+                                rinfo->time, rinfo->record );
+                rinfo->Free();
+            } else if ( !queue.empty() ) {
+                PacketTrace::Record const & next = queue.front();
+                // only count packets whose retirement (or reply) takes
+                // them off again; traced replies are not matched to
+                // requests
+                bool const request = ( ( next.type == Flit::READ_REQUEST ) ||
+                                       ( next.type == Flit::WRITE_REQUEST ) );
+                if ( ( next.type == Flit::ANY_TYPE ) ||
+                     ( request && _packet_trace_replies ) ) {
+                    _requestsOutstanding[source]++;
+                }
+                _packet_seq_no[source]++;
+                _EnqueuePacket( source, next.dest, next.size,
+                                (Flit::FlitType)next.type, 0,
+                                _include_queuing==1 ? next.time : _time,
+                                false );
+                queue.pop_front();
+            }
+        }
+        if ( queue.empty() && replies.empty() ) {
+            _trace_is_active[source] = false;
+        } else {
+            _trace_active[active++] = source;
+        }
+    }
+    _trace_active.resize( active );
+
+    // a source has drained once it has issued every record from before
+    // the end of the measurement
+    if ( _sim_state == draining ) {
+        for ( int s = 0; s < _nodes; ++s ) {
+            _qdrained[s][0] = ( _trace_queue[s].empty() ||
+                                ( _trace_queue[s].front().time >= _drain_time ) );
+        }
+    }
+}
+
+void TrafficManager::_ActivateTraceSource( int source )
+{
+    if ( !_trace_is_active[source] ) {
+        _trace_is_active[source] = true;
+        _trace_active.push_back( source );
+    }
+}
+
+void TrafficManager::_ResetTrace()
+{
+    _packet_trace->Rewind();
+    _packet_trace_done = false;
+    _packet_trace_time = numeric_limits<int>::min();
+    for ( int s = 0; s < _nodes; ++s ) {
+        _trace_queue[s].clear();
+    }
+    _trace_active.clear();
+    _trace_is_active.assign( _nodes, false );
+}
+
 void TrafficManager::_Step( )
 {
     bool flits_in_flight = false;
     for(int c = 0; c < _classes; ++c) {
-        flits_in_flight |= !_total_in_flight_flits[c].empty();
+        flits_in_flight |= !_total_in_flight_flits[c].Empty();
     }
     if(flits_in_flight && (_deadlock_timer++ >= _deadlock_warn_timeout)){
         _deadlock_timer = 0;
         cout << "WARNING: Possible network deadlock.\n";
     }
 
-    vector<map<int, Flit *> > flits(_subnets);
-  
     for ( int subnet = 0; subnet < _subnets; ++subnet ) {
         for ( int n = 0; n < _nodes; ++n ) {
             Flit * const f = _net[subnet]->ReadFlit( n );
@@ -988,7 +1346,7 @@ void TrafficManager::_Step( )
                                << " from VC " << f->vc
                                << "." << endl;
                 }
-                flits[subnet].insert(make_pair(n, f));
+                _ejecting_flits[subnet][n] = f;
                 if((_sim_state == warming_up) || (_sim_state == running)) {
                     ++_accepted_flits[f->cl][n];
                     if(f->tail) {
@@ -1000,7 +1358,7 @@ void TrafficManager::_Step( )
             Credit * const c = _net[subnet]->ReadCredit( n );
             if ( c ) {
 #ifdef TRACK_FLOWS
-                for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+                for(Credit::VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
                     int const vc = *iter;
                     assert(!_outstanding_classes[n][subnet][vc].empty());
                     int cl = _outstanding_classes[n][subnet][vc].front();
@@ -1071,7 +1429,7 @@ void TrafficManager::_Step( )
 	  
                     OutputSet route_set;
                     _rf(NULL, cf, -1, &route_set, true);
-                    set<OutputSet::sSetElement> const & os = route_set.GetSet();
+                    OutputSet const & os = route_set.GetSet();
                     assert(os.size() == 1);
                     OutputSet::sSetElement const & se = *os.begin();
                     assert(se.output_port == -1);
@@ -1098,7 +1456,7 @@ void TrafficManager::_Step( )
                                        << "Generating lookahead routing info for flit " << cf->id
                                        << " (NOQ)." << endl;
                         }
-                        set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
+                        OutputSet const & sl = cf->la_route_set.GetSet();
                         assert(sl.size() == 1);
                         int next_output = sl.begin()->output_port;
                         vc_count /= router->NumOutputs();
@@ -1224,6 +1582,9 @@ void TrafficManager::_Step( )
                                << "." << endl;
                 }
                 f->itime = _time;
+                if(f->trace) {
+                    EventTrace::Add(EventTrace::inject, f, n, -1, f->vc);
+                }
 
                 // Pass VC "back"
                 if(!_partial_packets[n][c].empty() && !f->tail) {
@@ -1250,9 +1611,9 @@ void TrafficManager::_Step( )
 
     for(int subnet = 0; subnet < _subnets; ++subnet) {
         for(int n = 0; n < _nodes; ++n) {
-            map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
-            if(iter != flits[subnet].end()) {
-                Flit * const f = iter->second;
+            Flit * const f = _ejecting_flits[subnet][n];
+            if(f) {
+                _ejecting_flits[subnet][n] = NULL;
 
                 f->atime = _time;
                 if(f->watch) {
@@ -1273,15 +1634,16 @@ void TrafficManager::_Step( )
                 _RetireFlit(f, n);
             }
         }
-        flits[subnet].clear();
         _net[subnet]->Evaluate( );
         _net[subnet]->WriteOutputs( );
     }
 
     ++_time;
     assert(_time);
+    // nocviewer text trace; '\n' instead of endl, so that the per-cycle
+    // lines are not flushed one at a time
     if(gTrace){
-        cout<<"TIME "<<_time<<endl;
+        cout<<"TIME "<<_time<<'\n';
     }
 
 }
@@ -1290,7 +1652,7 @@ bool TrafficManager::_PacketsOutstanding( ) const
 {
     for ( int c = 0; c < _classes; ++c ) {
         if ( _measure_stats[c] ) {
-            if ( _measured_in_flight_flits[c].empty() ) {
+            if ( _measured_in_flight_flits[c].Empty() ) {
 	
                 for ( int s = 0; s < _nodes; ++s ) {
                     if ( !_qdrained[s][c] ) {
@@ -1303,7 +1665,7 @@ bool TrafficManager::_PacketsOutstanding( ) const
                 }
             } else {
 #ifdef DEBUG_DRAIN
-                cout << "in flight = " << _measured_in_flight_flits[c].size() << endl;
+                cout << "in flight = " << _measured_in_flight_flits[c].Size() << endl;
 #endif
                 return true;
             }
@@ -1338,16 +1700,19 @@ void TrafficManager::_ClearStats( )
         _crossbar_conflict_stalls[c].assign(_subnets*_routers, 0);
 #endif
         if(_pair_stats){
-            for ( int i = 0; i < _nodes; ++i ) {
-                for ( int j = 0; j < _nodes; ++j ) {
-                    _pair_plat[c][i*_nodes+j]->Clear( );
-                    _pair_nlat[c][i*_nodes+j]->Clear( );
-                    _pair_flat[c][i*_nodes+j]->Clear( );
-                }
-            }
+            _pair_plat[c]->Clear( );
+            _pair_nlat[c]->Clear( );
+            _pair_flat[c]->Clear( );
         }
         _hop_stats[c]->Clear();
 
+        _batch_plat[c].clear();
+        _batch_accepted[c].clear();
+        _batch_plat_sum[c] = 0.0;
+        _batch_plat_count[c] = 0;
+        _batch_accepted_count[c] = 0;
+        _plat_ci[c] = -1.0;
+        _accepted_ci[c] = -1.0;
     }
 
     _reset_time = _time;
@@ -1392,40 +1757,187 @@ void TrafficManager::_ComputeStats( const vector<int> & stats, int *sum, int *mi
     }
 }
 
+// 97.5% quantile of Student's t distribution with df degrees of freedom
+static double _StudentT975( int df )
+{
+    static double const table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    assert(df >= 1);
+    if(df <= 30) {
+        return table[df - 1];
+    }
+    // Cornish-Fisher expansion around the normal quantile
+    double const z = 1.959964;
+    double const z3 = z * z * z;
+    double const z5 = z3 * z * z;
+    return z + (z3 + z) / (4.0 * df) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * df * df);
+}
+
+// 95% confidence half-width of the batch means; -1 if there are fewer
+// than two batches and the variance cannot be estimated
+static double _HalfWidth( vector<double> const & batches )
+{
+    int const k = batches.size();
+    if(k < 2) {
+        return -1.0;
+    }
+    double sum = 0.0;
+    for(int i = 0; i < k; ++i) {
+        sum += batches[i];
+    }
+    double const mean = sum / (double)k;
+    double sq = 0.0;
+    for(int i = 0; i < k; ++i) {
+        sq += (batches[i] - mean) * (batches[i] - mean);
+    }
+    return _StudentT975(k - 1) * sqrt(sq / (double)(k - 1) / (double)k);
+}
+
+static string _HalfWidthString( double half_width )
+{
+    if(half_width < 0.0) {
+        return "insufficient batches";
+    }
+    ostringstream os;
+    os << "+/-" << half_width;
+    return os.str();
+}
+
+// empty CSV field if the half-width is undefined
+static string _CIField( double half_width )
+{
+    if(half_width < 0.0) {
+        return "";
+    }
+    ostringstream os;
+    os << half_width;
+    return os.str();
+}
+
+static double _Mean( vector<double> const & batches )
+{
+    double sum = 0.0;
+    for(size_t i = 0; i < batches.size(); ++i) {
+        sum += batches[i];
+    }
+    return batches.empty() ? 0.0 : (sum / (double)batches.size());
+}
+
+// Close the batch covering the last sample period. Periods in which no
+// packet retired carry no latency sample and only count towards the rate.
+void TrafficManager::_AddBatch( )
+{
+    for(int c = 0; c < _classes; ++c) {
+
+        if(_measure_stats[c] == 0) {
+            continue;
+        }
+
+        double const plat_sum = _plat_stats[c]->Sum();
+        int const plat_count = _plat_stats[c]->NumSamples();
+        if(plat_count > _batch_plat_count[c]) {
+            _batch_plat[c].push_back((plat_sum - _batch_plat_sum[c]) /
+                                     (double)(plat_count - _batch_plat_count[c]));
+        }
+        _batch_plat_sum[c] = plat_sum;
+        _batch_plat_count[c] = plat_count;
+
+        int accepted_count;
+        _ComputeStats(_accepted_packets[c], &accepted_count);
+        _batch_accepted[c].push_back((double)(accepted_count - _batch_accepted_count[c]) /
+                                     (double)_sample_period / (double)_nodes);
+        _batch_accepted_count[c] = accepted_count;
+
+        _plat_ci[c] = _HalfWidth(_batch_plat[c]);
+        _accepted_ci[c] = _HalfWidth(_batch_accepted[c]);
+    }
+}
+
+bool TrafficManager::_BatchesConverged( ) const
+{
+    for(int c = 0; c < _classes; ++c) {
+
+        if(_measure_stats[c] == 0) {
+            continue;
+        }
+
+        if(_measure_latency &&
+           (((int)_batch_plat[c].size() < _ci_min_batches) || (_plat_ci[c] < 0.0) ||
+            (_plat_ci[c] > _ci_precision * _Mean(_batch_plat[c])))) {
+            return false;
+        }
+        if(((int)_batch_accepted[c].size() < _ci_min_batches) || (_accepted_ci[c] < 0.0) ||
+           (_accepted_ci[c] > _ci_precision * _Mean(_batch_accepted[c]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void TrafficManager::_DisplayRemaining( ostream & os ) const 
 {
     for(int c = 0; c < _classes; ++c) {
 
-        map<int, Flit *>::const_iterator iter;
-        int i;
+        vector<Flit *> flits;
 
         os << "Class " << c << ":" << endl;
 
         os << "Remaining flits: ";
-        for ( iter = _total_in_flight_flits[c].begin( ), i = 0;
-              ( iter != _total_in_flight_flits[c].end( ) ) && ( i < 10 );
-              iter++, i++ ) {
-            os << iter->first << " ";
+        _total_in_flight_flits[c].GetFlits( &flits, 10 );
+        for ( size_t i = 0; i < flits.size( ); ++i ) {
+            os << flits[i]->id << " ";
         }
-        if(_total_in_flight_flits[c].size() > 10)
+        if(_total_in_flight_flits[c].Size() > 10)
             os << "[...] ";
     
-        os << "(" << _total_in_flight_flits[c].size() << " flits)" << endl;
+        os << "(" << _total_in_flight_flits[c].Size() << " flits)" << endl;
     
         os << "Measured flits: ";
-        for ( iter = _measured_in_flight_flits[c].begin( ), i = 0;
-              ( iter != _measured_in_flight_flits[c].end( ) ) && ( i < 10 );
-              iter++, i++ ) {
-            os << iter->first << " ";
+        _measured_in_flight_flits[c].GetFlits( &flits, 10 );
+        for ( size_t i = 0; i < flits.size( ); ++i ) {
+            os << flits[i]->id << " ";
         }
-        if(_measured_in_flight_flits[c].size() > 10)
+        if(_measured_in_flight_flits[c].Size() > 10)
             os << "[...] ";
     
-        os << "(" << _measured_in_flight_flits[c].size() << " flits)" << endl;
+        os << "(" << _measured_in_flight_flits[c].Size() << " flits)" << endl;
     
     }
 }
 
+void TrafficManager::_WriteChannelStats( int sample )
+{
+    for(int s = 0; s < _subnets; ++s) {
+        ostringstream prefix;
+        prefix << sample << ','
+               << ((_sim_state == warming_up) ? "warmup" : "running") << ','
+               << s << ',';
+        _net[s]->WriteChannelStats(*_channel_stats_out, prefix.str());
+        _net[s]->ResetChannelStats();
+    }
+}
+
+// Sample periods after warmup count towards the elevator totals.
+void TrafficManager::_EndElevatorPeriod( int sample )
+{
+    for(int s = 0; s < _subnets; ++s) {
+        if(!_elevator_stats[s]) {
+            continue;
+        }
+        if(_elevator_stats_out) {
+            ostringstream prefix;
+            prefix << sample << ','
+                   << ((_sim_state == warming_up) ? "warmup" : "running") << ','
+                   << s << ',';
+            _elevator_stats[s]->WritePeriod(*_elevator_stats_out, prefix.str());
+        }
+        _elevator_stats[s]->EndPeriod(_sim_state == running);
+    }
+}
+
 bool TrafficManager::_SingleSim( )
 {
     int converged = 0;
@@ -1435,6 +1947,19 @@ bool TrafficManager::_SingleSim( )
     vector<double> prev_accepted(_classes, 0.0);
     bool clear_last = false;
     int total_phases = 0;
+    if ( _resume_phases > 0 ) {
+        // continue right after the warmup saved in the checkpoint
+        prev_latency = _resume_latency;
+        prev_accepted = _resume_accepted;
+        clear_last = true;
+        total_phases = _resume_phases;
+        _resume_phases = 0;
+    }
+    if(_channel_stats_out) {
+        for(int s = 0; s < _subnets; ++s) {
+            _net[s]->TrackChannelStats();
+        }
+    }
     while( ( total_phases < _max_samples ) && 
            ( ( _sim_state != running ) || 
              ( converged < 3 ) ) ) {
@@ -1452,6 +1977,24 @@ bool TrafficManager::_SingleSim( )
 
         UpdateStats();
         DisplayStats();
+        if(_channel_stats_out) {
+            _WriteChannelStats(total_phases);
+        }
+        _EndElevatorPeriod(total_phases);
+
+        if ( _sim_state == running ) {
+            _AddBatch( );
+            if ( _ci_stopping ) {
+                for ( int c = 0; c < _classes; ++c ) {
+                    if ( _measure_stats[c] ) {
+                        cout << "latency 95% CI    = " << _HalfWidthString(_plat_ci[c])
+                             << " (" << _batch_plat[c].size() << " batches)" << endl;
+                        cout << "throughput 95% CI = " << _HalfWidthString(_accepted_ci[c])
+                             << " (" << _batch_accepted[c].size() << " batches)" << endl;
+                    }
+                }
+            }
+        }
     
         int lat_exc_class = -1;
         int lat_chg_exc_class = -1;
@@ -1479,11 +2022,10 @@ bool TrafficManager::_SingleSim( )
             double latency = (double)_plat_stats[c]->Sum();
             double count = (double)_plat_stats[c]->NumSamples();
       
-            map<int, Flit *>::const_iterator iter;
-            for(iter = _total_in_flight_flits[c].begin(); 
-                iter != _total_in_flight_flits[c].end(); 
-                iter++) {
-                latency += (double)(_time - iter->second->ctime);
+            vector<Flit *> flits;
+            _total_in_flight_flits[c].GetFlits(&flits);
+            for(size_t i = 0; i < flits.size(); ++i) {
+                latency += (double)(_time - flits[i]->ctime);
                 count++;
             }
       
@@ -1543,10 +2085,18 @@ bool TrafficManager::_SingleSim( )
                 cout << "Warmed up ..." <<  "Time used is " << _time << " cycles" <<endl;
                 clear_last = true;
                 _sim_state = running;
+                if ( !_checkpoint_save.empty( ) ) {
+                    _SaveCheckpoint( total_phases + 1, prev_latency, prev_accepted );
+                    _checkpoint_save.clear( );
+                }
             }
         } else if(_sim_state == running) {
-            if ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
-                 ( acc_chg_exc_class < 0 ) ) {
+            if ( _ci_stopping ) {
+                // one precise enough estimate ends the run, like three
+                // converging periods do otherwise
+                converged = _BatchesConverged( ) ? 3 : 0;
+            } else if ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
+                        ( acc_chg_exc_class < 0 ) ) {
                 ++converged;
             } else {
                 converged = 0;
@@ -1584,11 +2134,10 @@ bool TrafficManager::_SingleSim( )
                         double acc_latency = _plat_stats[c]->Sum();
                         double acc_count = (double)_plat_stats[c]->NumSamples();
 	    
-                        map<int, Flit *>::const_iterator iter;
-                        for(iter = _total_in_flight_flits[c].begin(); 
-                            iter != _total_in_flight_flits[c].end(); 
-                            iter++) {
-                            acc_latency += (double)(_time - iter->second->ctime);
+                        vector<Flit *> flits;
+                        _total_in_flight_flits[c].GetFlits(&flits);
+                        for(size_t i = 0; i < flits.size(); ++i) {
+                            acc_latency += (double)(_time - flits[i]->ctime);
                             acc_count++;
                         }
 	    
@@ -1648,11 +2197,27 @@ bool TrafficManager::Run( )
         _sim_state    = warming_up;
   
         _ClearStats( );
+        for(int s = 0; s < _subnets; ++s) {
+            if(_elevator_stats[s]) {
+                _elevator_stats[s]->Clear();
+            }
+        }
 
         for(int c = 0; c < _classes; ++c) {
             _traffic_pattern[c]->reset();
             _injection_process[c]->reset();
         }
+        if(_inject_skip_ahead) {
+            _ResetArrivals();
+        }
+        if(_packet_trace) {
+            _ResetTrace();
+        }
+
+        // resume from the end of a saved warmup instead
+        if ( ( sim == 0 ) && !_checkpoint_load.empty( ) ) {
+            _LoadCheckpoint( );
+        }
 
         if ( !_SingleSim( ) ) {
             cout << "Simulation unstable, ending ..." << endl;
@@ -1666,7 +2231,7 @@ bool TrafficManager::Run( )
 
         bool packets_left = false;
         for(int c = 0; c < _classes; ++c) {
-            packets_left |= !_total_in_flight_flits[c].empty();
+            packets_left |= !_total_in_flight_flits[c].Empty();
         }
 
         while( packets_left ) { 
@@ -1680,7 +2245,7 @@ bool TrafficManager::Run( )
       
             packets_left = false;
             for(int c = 0; c < _classes; ++c) {
-                packets_left |= !_total_in_flight_flits[c].empty();
+                packets_left |= !_total_in_flight_flits[c].Empty();
             }
         }
         //wait until all the credits are drained as well
@@ -1689,6 +2254,14 @@ bool TrafficManager::Run( )
         }
         _empty_network = false;
 
+        // departures while draining belong to this run, not to the first
+        // period of the next one
+        for(int s = 0; s < _subnets; ++s) {
+            if(_elevator_stats[s]) {
+                _elevator_stats[s]->EndPeriod(true);
+            }
+        }
+
         //for the love of god don't ever say "Time taken" anywhere else
         //the power script depend on it
         cout << "Time taken is " << _time << " cycles" <<endl; 
@@ -1696,6 +2269,19 @@ bool TrafficManager::Run( )
         if(_stats_out) {
             WriteStats(*_stats_out);
         }
+        if(_pair_stats && !_pair_stats_out.empty()) {
+            WritePairStats();
+        }
+        for(int s = 0; s < _subnets; ++s) {
+            if(_elevator_stats[s]) {
+                _elevator_stats[s]->Display(cout);
+                if(_elevator_stats_out) {
+                    ostringstream prefix;
+                    prefix << "total,running," << s << ',';
+                    _elevator_stats[s]->WriteTotals(*_elevator_stats_out, prefix.str());
+                }
+            }
+        }
         _UpdateOverallStats();
     }
   
@@ -1730,6 +2316,17 @@ void TrafficManager::_UpdateOverallStats() {
 
         _overall_hop_stats[c] += _hop_stats[c]->Average();
 
+        _overall_plat_dist[c]->Merge(*_plat_stats[c]);
+        _overall_nlat_dist[c]->Merge(*_nlat_stats[c]);
+        _overall_flat_dist[c]->Merge(*_flat_stats[c]);
+
+        _overall_batch_plat[c].insert(_overall_batch_plat[c].end(),
+                                      _batch_plat[c].begin(), _batch_plat[c].end());
+        _overall_batch_accepted[c].insert(_overall_batch_accepted[c].end(),
+                                          _batch_accepted[c].begin(), _batch_accepted[c].end());
+        _overall_plat_ci[c] = _HalfWidth(_overall_batch_plat[c]);
+        _overall_accepted_ci[c] = _HalfWidth(_overall_batch_accepted[c]);
+
         int count_min, count_sum, count_max;
         double rate_min, rate_sum, rate_max;
         double rate_avg;
@@ -1816,28 +2413,28 @@ void TrafficManager::WriteStats(ostream & os) const {
             os<< "pair_sent(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_plat[c][i*_nodes+j]->NumSamples() << " ";
+                    os << _pair_plat[c]->NumSamples( i, j ) << " ";
                 }
             }
             os << "];" << endl
                << "pair_plat(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_plat[c][i*_nodes+j]->Average( ) << " ";
+                    os << _pair_plat[c]->Average( i, j ) << " ";
                 }
             }
             os << "];" << endl
                << "pair_nlat(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_nlat[c][i*_nodes+j]->Average( ) << " ";
+                    os << _pair_nlat[c]->Average( i, j ) << " ";
                 }
             }
             os << "];" << endl
                << "pair_flat(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_flat[c][i*_nodes+j]->Average( ) << " ";
+                    os << _pair_flat[c]->Average( i, j ) << " ";
                 }
             }
         }
@@ -1905,6 +2502,39 @@ void TrafficManager::WriteStats(ostream & os) const {
     }
 }
 
+// CSV: one line per class, metric and pair with samples. Binary: the number
+// of classes, then for every class the plat, nlat and flat matrices as
+// written by PairStats::WriteBinary.
+void TrafficManager::WritePairStats( ) const
+{
+    ofstream os(_pair_stats_out.c_str(),
+                _pair_stats_binary ? (ios::out | ios::binary) : ios::out);
+    if(!os) {
+        Error("Could not open pair_stats_out file " + _pair_stats_out);
+    }
+    if(_pair_stats_binary) {
+        os.write((char const *)&_classes, sizeof(_classes));
+    } else {
+        os << "class,metric,src,dest,count,avg,min,max";
+        if(_pair_plat[0]->HasSketch()) {
+            os << ",p50,p90,p99";
+        }
+        os << endl;
+    }
+    for(int c = 0; c < _classes; ++c) {
+        PairStats const * const metrics[] = { _pair_plat[c], _pair_nlat[c], _pair_flat[c] };
+        for(int m = 0; m < 3; ++m) {
+            if(_pair_stats_binary) {
+                metrics[m]->WriteBinary(os);
+            } else {
+                ostringstream prefix;
+                prefix << c << "," << (m == 0 ? "plat" : (m == 1 ? "nlat" : "flat"));
+                metrics[m]->WriteCSV(os, prefix.str());
+            }
+        }
+    }
+}
+
 void TrafficManager::UpdateStats() {
 #if defined(TRACK_FLOWS) || defined(TRACK_STALLS)
     for(int c = 0; c < _classes; ++c) {
@@ -2062,8 +2692,8 @@ void TrafficManager::DisplayStats(ostream & os) const {
         cout << "Injected packet length average = " << (double)sent_flits / (double)sent_packets << endl
              << "Accepted packet length average = " << (double)accepted_flits / (double)accepted_packets << endl;
 
-        cout << "Total in-flight flits = " << _total_in_flight_flits[c].size()
-             << " (" << _measured_in_flight_flits[c].size() << " measured)"
+        cout << "Total in-flight flits = " << _total_in_flight_flits[c].Size()
+             << " (" << _measured_in_flight_flits[c].Size() << " measured)"
              << endl;
     
 #ifdef TRACK_STALLS
@@ -2092,6 +2722,15 @@ void TrafficManager::DisplayStats(ostream & os) const {
     }
 }
 
+// p50, p90, p99 and p99.9 of a latency distribution
+static string _Percentiles( Stats const * s, string const & sep )
+{
+    ostringstream os;
+    os << s->Percentile(0.5) << sep << s->Percentile(0.9) << sep
+       << s->Percentile(0.99) << sep << s->Percentile(0.999);
+    return os.str();
+}
+
 void TrafficManager::DisplayOverallStats( ostream & os ) const {
 
     os << "====== Overall Traffic Statistics ======" << endl;
@@ -2167,6 +2806,18 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
     
         os << "Hops average = " << _overall_hop_stats[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
+
+        os << "Packet latency percentiles = " << _Percentiles(_overall_plat_dist[c], " / ")
+           << " (p50 / p90 / p99 / p99.9)" << endl;
+        os << "Network latency percentiles = " << _Percentiles(_overall_nlat_dist[c], " / ")
+           << " (p50 / p90 / p99 / p99.9)" << endl;
+        os << "Flit latency percentiles = " << _Percentiles(_overall_flat_dist[c], " / ")
+           << " (p50 / p90 / p99 / p99.9)" << endl;
+
+        os << "Packet latency 95% CI = " << _HalfWidthString(GetOverallPacketLatencyCI(c))
+           << " (" << _overall_batch_plat[c].size() << " batches)" << endl;
+        os << "Accepted packet rate 95% CI = " << _HalfWidthString(GetOverallAcceptedPacketRateCI(c))
+           << " (" << _overall_batch_accepted[c].size() << " batches)" << endl;
     
 #ifdef TRACK_STALLS
         os << "Buffer busy stall rate = " << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
@@ -2182,6 +2833,14 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
 #endif
     
     }
+
+    // memory pools; objects still outstanding here were left in the network
+    os << "Flit pool: " << ObjectPool<Flit>::Allocated() << " allocated in "
+       << ObjectPool<Flit>::Chunks() << " chunks, "
+       << ObjectPool<Flit>::Outstanding() << " outstanding" << endl;
+    os << "Credit pool: " << ObjectPool<Credit>::Allocated() << " allocated in "
+       << ObjectPool<Credit>::Chunks() << " chunks, "
+       << ObjectPool<Credit>::Outstanding() << " outstanding" << endl;
   
 }
 
@@ -2217,7 +2876,12 @@ string TrafficManager::_OverallStatsCSV(int c) const
        << ',' << _overall_max_accepted[c] / (double)_total_sims
        << ',' << _overall_avg_sent[c] / _overall_avg_sent_packets[c]
        << ',' << _overall_avg_accepted[c] / _overall_avg_accepted_packets[c]
-       << ',' << _overall_hop_stats[c] / (double)_total_sims;
+       << ',' << _overall_hop_stats[c] / (double)_total_sims
+       << ',' << _CIField(GetOverallPacketLatencyCI(c))
+       << ',' << _CIField(GetOverallAcceptedPacketRateCI(c))
+       << ',' << _Percentiles(_overall_plat_dist[c], ",")
+       << ',' << _Percentiles(_overall_nlat_dist[c], ",")
+       << ',' << _Percentiles(_overall_flat_dist[c], ",");
 
 #ifdef TRACK_STALLS
     os << ',' << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
@@ -2259,6 +2923,303 @@ void TrafficManager::_LoadWatchList(const string & filename){
     }
 }
 
+// Checkpoints hold the network and traffic manager state at the end of the
+// first warmup of sim 0: everything in flight, the injection and VC
+// allocation state of every source, and both random number streams.
+// Statistics are cleared at that point anyway and are not saved. Traffic
+// patterns are only reset, so patterns that keep state between packets
+// (single_packet) do not resume where they left off.
+
+static int const _checkpoint_version = 3;
+
+static void _SaveFlitTable( CheckpointWriter & writer, FlitTable const & table )
+{
+    vector<Flit *> flits;
+    table.GetFlits(&flits);
+    writer.WriteInt(flits.size());
+    for(size_t i = 0; i < flits.size(); ++i) {
+        writer.Write(flits[i]);
+    }
+}
+
+static void _LoadFlitTable( CheckpointReader & reader, FlitTable & table, bool by_pid )
+{
+    int const size = reader.ReadInt();
+    for(int i = 0; i < size; ++i) {
+        Flit * f;
+        reader.Read(f);
+        table.Insert(by_pid ? f->pid : f->id, f);
+    }
+}
+
+void TrafficManager::_SaveCheckpoint( int phases, vector<double> const & prev_latency,
+                                      vector<double> const & prev_accepted ) const
+{
+    CheckpointWriter writer(_checkpoint_save);
+
+    writer.WriteString("booksim checkpoint");
+    writer.WriteInt(_checkpoint_version);
+    writer.WriteString(_topology);
+    writer.WriteString(_routing_function);
+    writer.WriteInt(_nodes);
+    writer.WriteInt(_routers);
+    writer.WriteInt(_vcs);
+    writer.WriteInt(_classes);
+    writer.WriteInt(_subnets);
+    writer.WriteInt(_vc_buf_size);
+    writer.WriteInt(_buf_size);
+    writer.WriteBool(_inject_skip_ahead);
+    writer.WriteBool(_packet_trace != NULL);
+
+    writer.WriteInt(phases);
+    for(int c = 0; c < _classes; ++c) {
+        writer.WriteDouble(prev_latency[c]);
+        writer.WriteDouble(prev_accepted[c]);
+    }
+
+    writer.WriteInt(_time);
+    writer.WriteInt(_cur_id);
+    writer.WriteInt(_cur_pid);
+    writer.WriteInt(_deadlock_timer);
+
+    for(int s = 0; s < _nodes; ++s) {
+        writer.WriteInts(_qtime[s]);
+        writer.WriteBools(_qdrained[s]);
+        for(int c = 0; c < _classes; ++c) {
+            list<Flit *> const & pp = _partial_packets[s][c];
+            writer.WriteInt(pp.size());
+            for(list<Flit *>::const_iterator iter = pp.begin(); iter != pp.end(); ++iter) {
+                writer.Write(*iter);
+            }
+        }
+    }
+
+    for(int c = 0; c < _classes; ++c) {
+        _SaveFlitTable(writer, _total_in_flight_flits[c]);
+        _SaveFlitTable(writer, _measured_in_flight_flits[c]);
+        _SaveFlitTable(writer, _retired_packets[c]);
+        _injection_process[c]->SaveState(writer);
+    }
+
+    for(int s = 0; s < _nodes; ++s) {
+        writer.WriteInts(_last_class[s]);
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            writer.WriteInts(_last_vc[s][subnet]);
+            _buf_states[s][subnet]->SaveState(writer);
+        }
+    }
+
+    writer.WriteInts(_packet_seq_no);
+    writer.WriteInts(_requestsOutstanding);
+    for(int s = 0; s < _nodes; ++s) {
+        list<PacketReplyInfo *> const & rp = _repliesPending[s];
+        writer.WriteInt(rp.size());
+        for(list<PacketReplyInfo *>::const_iterator iter = rp.begin(); iter != rp.end(); ++iter) {
+            writer.WriteInt((*iter)->source);
+            writer.WriteInt((*iter)->time);
+            writer.WriteBool((*iter)->record);
+            writer.WriteInt((*iter)->type);
+        }
+    }
+
+    if(_inject_skip_ahead) {
+        for(int s = 0; s < _nodes; ++s) {
+            writer.WriteInts(_next_arrival[s]);
+        }
+        priority_queue<pair<int, int>, vector<pair<int, int> >,
+                       greater<pair<int, int> > > arrivals = _arrivals;
+        writer.WriteInt(arrivals.size());
+        for(; !arrivals.empty(); arrivals.pop()) {
+            writer.WriteInt(arrivals.top().first);
+            writer.WriteInt(arrivals.top().second);
+        }
+        writer.WriteInts(_arrivals_due);
+    }
+    if(_packet_trace) {
+        writer.WriteLong(_packet_trace->Position());
+        writer.WriteBool(_packet_trace_done);
+        writer.WriteInt(_packet_trace_time);
+        for(int s = 0; s < _nodes; ++s) {
+            deque<PacketTrace::Record> const & queue = _trace_queue[s];
+            writer.WriteInt(queue.size());
+            for(deque<PacketTrace::Record>::const_iterator iter = queue.begin(); iter != queue.end(); ++iter) {
+                writer.WriteInt(iter->time);
+                writer.WriteInt(iter->src);
+                writer.WriteInt(iter->dest);
+                writer.WriteInt(iter->size);
+                writer.WriteInt(iter->type);
+            }
+        }
+    }
+    writer.WriteMarker(1);
+
+    vector<long> save_x;
+    vector<double> save_u;
+    SaveRandomStreams(save_x, save_u);
+    writer.WriteInt(save_x.size());
+    for(size_t i = 0; i < save_x.size(); ++i) {
+        writer.WriteLong(save_x[i]);
+    }
+    writer.WriteInt(save_u.size());
+    for(size_t i = 0; i < save_u.size(); ++i) {
+        writer.WriteDouble(save_u[i]);
+    }
+    writer.WriteMarker(2);
+
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+        _net[subnet]->SaveState(writer);
+    }
+    writer.WriteMarker(3);
+
+    writer.Close();
+    cout << "Checkpoint saved to " << _checkpoint_save << " at time " << _time << endl;
+}
+
+void TrafficManager::_LoadCheckpoint( )
+{
+    CheckpointReader reader(_checkpoint_load);
+
+    if(reader.ReadString() != "booksim checkpoint") {
+        reader.Error("not a checkpoint file.");
+    }
+    reader.Expect(_checkpoint_version, "Checkpoint version");
+    reader.Expect(_topology, "topology");
+    reader.Expect(_routing_function, "routing_function");
+    reader.Expect(_nodes, "Number of nodes");
+    reader.Expect(_routers, "Number of routers");
+    reader.Expect(_vcs, "num_vcs");
+    reader.Expect(_classes, "Number of classes");
+    reader.Expect(_subnets, "subnets");
+    reader.Expect(_vc_buf_size, "vc_buf_size");
+    reader.Expect(_buf_size, "buf_size");
+    if(reader.ReadBool() != _inject_skip_ahead) {
+        reader.Error("injection_skip_ahead differs from the current configuration.");
+    }
+    if(reader.ReadBool() != (_packet_trace != NULL)) {
+        reader.Error("packet_trace differs from the current configuration.");
+    }
+
+    _resume_phases = reader.ReadInt();
+    _resume_latency.resize(_classes);
+    _resume_accepted.resize(_classes);
+    for(int c = 0; c < _classes; ++c) {
+        _resume_latency[c] = reader.ReadDouble();
+        _resume_accepted[c] = reader.ReadDouble();
+    }
+
+    _time = reader.ReadInt();
+    _cur_id = reader.ReadInt();
+    _cur_pid = reader.ReadInt();
+    _deadlock_timer = reader.ReadInt();
+
+    for(int s = 0; s < _nodes; ++s) {
+        _qtime[s] = reader.ReadInts();
+        _qdrained[s] = reader.ReadBools();
+        for(int c = 0; c < _classes; ++c) {
+            list<Flit *> & pp = _partial_packets[s][c];
+            int const size = reader.ReadInt();
+            for(int i = 0; i < size; ++i) {
+                Flit * f;
+                reader.Read(f);
+                pp.push_back(f);
+            }
+        }
+    }
+
+    for(int c = 0; c < _classes; ++c) {
+        _LoadFlitTable(reader, _total_in_flight_flits[c], false);
+        _LoadFlitTable(reader, _measured_in_flight_flits[c], false);
+        _LoadFlitTable(reader, _retired_packets[c], true);
+        _injection_process[c]->LoadState(reader);
+    }
+
+    for(int s = 0; s < _nodes; ++s) {
+        _last_class[s] = reader.ReadInts();
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            _last_vc[s][subnet] = reader.ReadInts();
+            _buf_states[s][subnet]->LoadState(reader);
+        }
+    }
+
+    _packet_seq_no = reader.ReadInts();
+    _requestsOutstanding = reader.ReadInts();
+    for(int s = 0; s < _nodes; ++s) {
+        int const size = reader.ReadInt();
+        for(int i = 0; i < size; ++i) {
+            PacketReplyInfo * rinfo = PacketReplyInfo::New();
+            rinfo->source = reader.ReadInt();
+            rinfo->time = reader.ReadInt();
+            rinfo->record = reader.ReadBool();
+            rinfo->type = (Flit::FlitType)reader.ReadInt();
+            _repliesPending[s].push_back(rinfo);
+        }
+    }
+
+    if(_inject_skip_ahead) {
+        for(int s = 0; s < _nodes; ++s) {
+            _next_arrival[s] = reader.ReadInts();
+        }
+        _arrivals = priority_queue<pair<int, int>, vector<pair<int, int> >,
+                                   greater<pair<int, int> > >();
+        int const size = reader.ReadInt();
+        for(int i = 0; i < size; ++i) {
+            int const time = reader.ReadInt();
+            int const index = reader.ReadInt();
+            _arrivals.push(make_pair(time, index));
+        }
+        _arrivals_due = reader.ReadInts();
+    }
+    if(_packet_trace) {
+        _packet_trace->Seek(reader.ReadLong());
+        _packet_trace_done = reader.ReadBool();
+        _packet_trace_time = reader.ReadInt();
+        for(int s = 0; s < _nodes; ++s) {
+            int const size = reader.ReadInt();
+            for(int i = 0; i < size; ++i) {
+                PacketTrace::Record r;
+                r.time = reader.ReadInt();
+                r.src = reader.ReadInt();
+                r.dest = reader.ReadInt();
+                r.size = reader.ReadInt();
+                r.type = reader.ReadInt();
+                _trace_queue[s].push_back(r);
+            }
+            // sources without work drop out in the next cycle
+            _ActivateTraceSource(s);
+        }
+    }
+    reader.ReadMarker(1);
+
+    vector<long> save_x(reader.ReadInt());
+    for(size_t i = 0; i < save_x.size(); ++i) {
+        save_x[i] = reader.ReadLong();
+    }
+    vector<double> save_u(reader.ReadInt());
+    for(size_t i = 0; i < save_u.size(); ++i) {
+        save_u[i] = reader.ReadDouble();
+    }
+    RestoreRandomStreams(save_x, save_u);
+    reader.ReadMarker(2);
+
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+        _net[subnet]->LoadState(reader);
+    }
+    reader.ReadMarker(3);
+
+    // a different seed gives independent samples of the same warmed-up state
+    if(_checkpoint_seed >= 0) {
+        RandomSeed(_checkpoint_seed);
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            _net[subnet]->SeedRouters(_checkpoint_seed, subnet);
+        }
+    }
+
+    _sim_state = running;
+    _ClearStats();
+
+    cout << "Resumed from checkpoint " << _checkpoint_load << " at time " << _time << endl;
+}
+
 int TrafficManager::_GetNextPacketSize(int cl) const
 {
     assert(cl >= 0 && cl < _classes);
@@ -31,6 +31,8 @@
 #include <list>
 #include <map>
 #include <set>
+#include <queue>
+#include <deque>
 #include <cassert>
 
 #include "module.hpp"
@@ -39,10 +41,14 @@
 #include "flit.hpp"
 #include "buffer_state.hpp"
 #include "stats.hpp"
+#include "pairstats.hpp"
+#include "elevator_stats.hpp"
 #include "traffic.hpp"
 #include "routefunc.hpp"
 #include "outputset.hpp"
 #include "injection.hpp"
+#include "flit_table.hpp"
+#include "packet_trace.hpp"
 
 //register the requests to a node
 class PacketReplyInfo;
@@ -113,9 +119,32 @@ protected:
   vector<vector<bool> > _qdrained;
   vector<vector<list<Flit *> > > _partial_packets;
 
-  vector<map<int, Flit *> > _total_in_flight_flits;
-  vector<map<int, Flit *> > _measured_in_flight_flits;
-  vector<map<int, Flit *> > _retired_packets;
+  // skip-ahead injection: arrival times of each source's next packet are
+  // sampled in advance and kept in a min-heap, so idle sources are not
+  // visited every cycle
+  bool _inject_skip_ahead;
+  vector<vector<int> > _next_arrival;
+  priority_queue<pair<int, int>, vector<pair<int, int> >,
+                 greater<pair<int, int> > > _arrivals; // (time, source*classes+class)
+  vector<int> _arrivals_due; // due, but the previous packet is still queued
+
+  // trace-driven injection (packet_trace): records that are due wait in
+  // per-source queues, and only sources with queued records or pending
+  // replies are visited
+  PacketTrace * _packet_trace;
+  bool _packet_trace_replies;
+  bool _packet_trace_done;
+  int _packet_trace_time;  // time of the last record popped
+  vector<deque<PacketTrace::Record> > _trace_queue;
+  vector<int> _trace_active;
+  vector<bool> _trace_is_active;
+
+  vector<FlitTable> _total_in_flight_flits;    // by flit ID
+  vector<FlitTable> _measured_in_flight_flits; // by flit ID
+  vector<FlitTable> _retired_packets;          // head flits by packet ID
+
+  // flit ejected at each node of each subnet in the current cycle
+  vector<vector<Flit *> > _ejecting_flits;
   bool _empty_network;
 
   bool _hold_switch_for_packet;
@@ -137,6 +166,21 @@ protected:
   vector<list<PacketReplyInfo*> > _repliesPending;
   vector<int> _requestsOutstanding;
 
+  // ============ Checkpoints ============
+
+  // the state at the end of the first warmup is saved to _checkpoint_save;
+  // loading _checkpoint_load instead resumes sim 0 from that point
+  string _topology;
+  string _routing_function;
+  int _vc_buf_size;
+  int _buf_size;
+  string _checkpoint_save;
+  string _checkpoint_load;
+  int _checkpoint_seed;
+  int _resume_phases;
+  vector<double> _resume_latency;
+  vector<double> _resume_accepted;
+
   // ============ Statistics ============
 
   vector<Stats *> _plat_stats;     
@@ -154,18 +198,39 @@ protected:
   vector<double> _overall_avg_flat;  
   vector<double> _overall_max_flat;  
 
+  // latency distributions merged over all sims, for percentiles
+  vector<Stats *> _overall_plat_dist;
+  vector<Stats *> _overall_nlat_dist;
+  vector<Stats *> _overall_flat_dist;
+
   vector<Stats *> _frag_stats;
   vector<double> _overall_min_frag;
   vector<double> _overall_avg_frag;
   vector<double> _overall_max_frag;
 
-  vector<vector<Stats *> > _pair_plat;
-  vector<vector<Stats *> > _pair_nlat;
-  vector<vector<Stats *> > _pair_flat;
+  vector<PairStats *> _pair_plat;
+  vector<PairStats *> _pair_nlat;
+  vector<PairStats *> _pair_flat;
 
   vector<Stats *> _hop_stats;
   vector<double> _overall_hop_stats;
 
+  // batch means: every sample period after warmup is one batch; the 95%
+  // confidence half-widths of packet latency and accepted packet rate
+  // follow from the spread of the batch averages. The overall ones pool
+  // the batches of all sims.
+  vector<vector<double> > _batch_plat;
+  vector<vector<double> > _batch_accepted;
+  vector<vector<double> > _overall_batch_plat;
+  vector<vector<double> > _overall_batch_accepted;
+  vector<double> _batch_plat_sum;      // totals at the end of the last batch
+  vector<int> _batch_plat_count;
+  vector<int> _batch_accepted_count;
+  vector<double> _plat_ci;
+  vector<double> _accepted_ci;
+  vector<double> _overall_plat_ci;
+  vector<double> _overall_accepted_ci;
+
   vector<vector<int> > _sent_packets;
   vector<double> _overall_min_sent_packets;
   vector<double> _overall_avg_sent_packets;
@@ -220,12 +285,20 @@ protected:
 
   vector<int> _measure_stats;
   bool _pair_stats;
+  string _pair_stats_out;
+  bool _pair_stats_binary;
 
   vector<double> _latency_thres;
 
   vector<double> _stopping_threshold;
   vector<double> _acc_stopping_threshold;
 
+  // stop once the confidence half-widths are within this fraction of the
+  // mean rather than after three sample periods with little change
+  bool _ci_stopping;
+  double _ci_precision;
+  int _ci_min_batches;
+
   vector<double> _warmup_threshold;
   vector<double> _acc_warmup_threshold;
 
@@ -241,6 +314,14 @@ protected:
   //flits to watch
   ostream * _stats_out;
 
+  // per-channel utilization, one block per sample period
+  ostream * _channel_stats_out;
+
+  // elevator usage per subnet (NULL unless a 3D UniTorus with
+  // elevator_stats), and its per sample period output
+  vector<ElevatorStats *> _elevator_stats;
+  ostream * _elevator_stats_out;
+
 #ifdef TRACK_FLOWS
   vector<vector<int> > _injected_flits;
   vector<vector<int> > _ejected_flits;
@@ -265,23 +346,41 @@ protected:
   virtual void _RetireFlit( Flit *f, int dest );
 
   void _Inject();
+  void _InjectSkipAhead();
+  bool _InjectFromSource( int source, int cl );
+  void _ScheduleArrival( int source, int cl );
+  void _ResetArrivals();
+  void _InjectTrace();
+  void _ActivateTraceSource( int source );
+  void _ResetTrace();
   void _Step( );
 
   bool _PacketsOutstanding( ) const;
   
   virtual int  _IssuePacket( int source, int cl );
   void _GeneratePacket( int source, int size, int cl, int time );
+  void _EnqueuePacket( int source, int dest, int size, Flit::FlitType type,
+                       int cl, int time, bool record );
 
   virtual void _ClearStats( );
+  void _WriteChannelStats( int sample );
+  void _EndElevatorPeriod( int sample );
 
   void _ComputeStats( const vector<int> & stats, int *sum, int *min = NULL, int *max = NULL, int *min_pos = NULL, int *max_pos = NULL ) const;
 
+  void _AddBatch( );
+  bool _BatchesConverged( ) const;
+
   virtual bool _SingleSim( );
 
   void _DisplayRemaining( ostream & os = cout ) const;
   
   void _LoadWatchList(const string & filename);
 
+  void _SaveCheckpoint( int phases, vector<double> const & prev_latency,
+                        vector<double> const & prev_accepted ) const;
+  void _LoadCheckpoint( );
+
   virtual void _UpdateOverallStats();
 
   virtual string _OverallStatsCSV(int c = 0) const;
@@ -300,11 +399,20 @@ public:
   bool Run( );
 
   virtual void WriteStats( ostream & os = cout ) const ;
+  void WritePairStats( ) const ;
   virtual void UpdateStats( ) ;
   virtual void DisplayStats( ostream & os = cout ) const ;
   virtual void DisplayOverallStats( ostream & os = cout ) const ;
   virtual void DisplayOverallStatsCSV( ostream & os = cout ) const ;
 
+  // averages over all sims of the last Run(), as in DisplayOverallStats
+  double GetOverallPacketLatency( int c = 0 ) const { return _overall_avg_plat[c] / (double)_total_sims; }
+  double GetOverallAcceptedPacketRate( int c = 0 ) const { return _overall_avg_accepted_packets[c] / (double)_total_sims; }
+  // confidence half-widths over the batches of all sims; -1 if there are
+  // fewer than two
+  double GetOverallPacketLatencyCI( int c = 0 ) const { return _overall_plat_ci[c]; }
+  double GetOverallAcceptedPacketRateCI( int c = 0 ) const { return _overall_accepted_ci[c]; }
+
   inline int getTime() { return _time;}
   Stats * getStats(const string & name) { return _stats[name]; }
 
@@ -0,0 +1,41 @@
+import argparse
+import csv
+import struct
+import sys
+
+# Converts a CSV packet trace (columns time,src,dest,size[,type]) to the
+# binary format read by booksim with packet_trace (see
+# src/packet_trace.hpp). Rows must be sorted by time; they are converted
+# one at a time, so the input may be larger than memory.
+
+TYPES = {"read_request": 0, "read_reply": 1, "write_request": 2,
+         "write_reply": 3, "any": 4}
+RECORD = struct.Struct("<iiiii")
+
+
+def parse_type(value: str) -> int:
+    if not value:
+        return TYPES["any"]
+    if value in TYPES:
+        return TYPES[value]
+    return int(value)
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument('csv', help="CSV trace with a header row (- for stdin)")
+parser.add_argument('output', help="Binary packet trace to write")
+args = parser.parse_args()
+
+infile = sys.stdin if args.csv == "-" else open(args.csv, newline="")
+last_time = None
+with open(args.output, "wb") as out:
+    out.write(b"BSPKTRC1")
+    reader = csv.DictReader(infile)
+    for row in reader:
+        time = int(row["time"])
+        if last_time is not None and time < last_time:
+            sys.exit(f"Error: trace is not sorted by time (line {reader.line_num}: "
+                     f"time {time} after {last_time})")
+        last_time = time
+        out.write(RECORD.pack(time, int(row["src"]), int(row["dest"]),
+                              int(row["size"]), parse_type(row.get("type", ""))))
@@ -0,0 +1,76 @@
+import argparse
+import struct
+import sys
+
+# Converts a binary event trace written with trace_out (see
+# src/event_trace.hpp for the format) to CSV.
+
+EVENTS = ["inject", "route", "vc_alloc", "sw_alloc", "traverse", "eject"]
+RECORD = struct.Struct("<iiiihhBBh")
+
+
+def read_varint(data: bytes, pos: int) -> tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7f) << shift
+        shift += 7
+        if b < 0x80:
+            break
+    # undo the zigzag encoding
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def read_block(encoding: int, count: int, payload: bytes):
+    if encoding == 0:
+        for i in range(count):
+            yield RECORD.unpack_from(payload, i * RECORD.size)[:8]
+        return
+    assert encoding == 1, f"Unknown block encoding {encoding}"
+    time = fid = pid = 0
+    pos = 0
+    for _ in range(count):
+        values = []
+        for _ in range(6):
+            v, pos = read_varint(payload, pos)
+            values.append(v)
+        time += values[0]
+        fid += values[1]
+        pid += values[2]
+        etype, flags = payload[pos], payload[pos + 1]
+        pos += 2
+        yield time, fid, pid, values[3], values[4], values[5], etype, flags
+
+
+def read_trace(filename: str):
+    with open(filename, "rb") as file:
+        assert file.read(8) == b"BSEVTRC1", f"{filename} is not an event trace"
+        while True:
+            header = file.read(9)
+            if not header:
+                break
+            encoding, count, size = struct.unpack("<BII", header)
+            payload = file.read(size)
+            assert len(payload) == size, f"{filename} is truncated"
+            yield from read_block(encoding, count, payload)
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument('trace', help="Binary trace file written by booksim (trace_out)")
+parser.add_argument('-o', '--output', help="CSV file to write (default: stdout)")
+parser.add_argument('--sort', action='store_true',
+                    help="Sort records by time (blocks of different threads may interleave)")
+args = parser.parse_args()
+
+records = read_trace(args.trace)
+if args.sort:
+    records = sorted(records, key=lambda r: r[0])
+
+out = open(args.output, "w") if args.output else sys.stdout
+out.write("time,event,flit,packet,node,port,vc,head,tail\n")
+for time, fid, pid, node, port, vc, etype, flags in records:
+    out.write(f"{time},{EVENTS[etype]},{fid},{pid},{node},{port},{vc},{flags & 1},{(flags >> 1) & 1}\n")
+if args.output:
+    out.close()